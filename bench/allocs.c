@@ -0,0 +1,98 @@
+/*******************************************************************
+* Michael S. Lewis
+* CS 344 Fall 2017
+* Program 3: smallsh allocation counter
+*
+* Preloaded into smallsh by the benchmark driver. Counts the calls to
+* malloc, calloc and realloc and writes the total to the file named
+* by SMALLBENCH_ALLOCS when the shell exits.
+********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+/* glibc's own allocator, which every call is passed on to. */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations;   // Calls counted so far.
+static pid_t shellPid;              // Only this process reports; forked children exit silently.
+static const char *countPath;       // File the total is written to.
+
+/* Function declarations */
+static void startCounting() __attribute__((constructor));
+static void reportCount() __attribute__((destructor));
+
+
+/*******************************************************************
+ * Name: static void startCounting()
+ * Description: Notes the shell's pid and where to report, then
+ *              drops LD_PRELOAD so the commands it runs are not
+ *              counted.
+ *******************************************************************/
+static void startCounting()
+{
+    shellPid = getpid();
+    countPath = getenv("SMALLBENCH_ALLOCS");
+    unsetenv("LD_PRELOAD");
+}
+
+
+/*******************************************************************
+ * Name: static void reportCount()
+ * Description: Writes the total when the shell itself exits.
+ *******************************************************************/
+static void reportCount()
+{
+    FILE *file;
+
+    if(countPath == NULL || getpid() != shellPid){
+        return;
+    }
+    file = fopen(countPath, "w");
+    if(file != NULL){
+        fprintf(file, "%lu\n", __atomic_load_n(&allocations, __ATOMIC_RELAXED));
+        fclose(file);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void *malloc(size_t size)
+ * Description: Counts the call and passes it to glibc.
+ * Returns: What glibc returns.
+ *******************************************************************/
+void *malloc(size_t size)
+{
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+
+/*******************************************************************
+ * Name: void *calloc(size_t count, size_t size)
+ * Description: Counts the call and passes it to glibc.
+ * Returns: What glibc returns.
+ *******************************************************************/
+void *calloc(size_t count, size_t size)
+{
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+
+/*******************************************************************
+ * Name: void *realloc(void *ptr, size_t size)
+ * Description: Counts the call and passes it to glibc.
+ * Returns: What glibc returns.
+ *******************************************************************/
+void *realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
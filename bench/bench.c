@@ -0,0 +1,846 @@
+/*******************************************************************
+* Michael S. Lewis
+* CS 344 Fall 2017
+* Program 3: smallsh benchmark driver
+*
+* Runs smallsh on generated scripts, reports the results as JSON and
+* compares them with a stored baseline. Used by "make bench".
+********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+
+#define REPEATS 5               // Runs of each workload; the best one is kept.
+#define LAUNCH_COUNT 2000       // Foreground commands in the launch workloads.
+#define PARSE_COUNT 500000      // Lines in the parse workload.
+#define REAP_COUNT 1000         // Background commands in the reap workload.
+#define LOOP_DIGITS 6           // Nested loops over ten digits in the loop workload.
+#define PADDED_COUNT 500        // Foreground commands in the padded workload.
+#define PADDED_BYTES 67108864   // Bytes the padded workload holds in a variable before launching.
+#define PIPE_BYTES 268435456    // Bytes pushed through the pipeline and temp-file workloads.
+#define CORPUS_REPEAT 10000     // Copies of the corpus in the corpus workload.
+#define BUILTIN_DIGITS 4        // Nested loops over ten digits in the builtin workload.
+#define EXTERNAL_DIGITS 2       // Nested loops over ten digits in the external workload.
+#define UTILITY_NUM 5           // Commands run by one pass of the builtin and external loops.
+#define ARGS_COUNT 20000        // Lines in the args workload.
+#define ARGS_WORDS 64           // Arguments on each of those lines.
+#define THRESHOLD 25.0          // Percent a metric may worsen before the run fails.
+#define MAX_LINE 512            // Longest line read from the shell's output.
+
+#define METRIC_NUM 20
+
+/* A measured value, the direction that counts as better, and its baseline. */
+struct metric{
+    const char *name;
+    bool higherBetter;
+    double value;
+    double baseline;            // Negative when the baseline has no such metric.
+};
+
+struct metric metrics[METRIC_NUM] = {
+    {"commands_per_sec", true, 0, -1},
+    {"launch_p50_us", false, 0, -1},
+    {"launch_p99_us", false, 0, -1},
+    {"parse_ns_per_line", false, 0, -1},
+    {"loop_commands_per_sec", true, 0, -1},
+    {"unrolled_commands_per_sec", true, 0, -1},
+    {"reap_per_sec", true, 0, -1},
+    {"peak_rss_kb", false, 0, -1},
+    {"padded_spawn_p50_us", false, 0, -1},
+    {"padded_fork_p50_us", false, 0, -1},
+    {"pipeline_mb_per_sec", true, 0, -1},
+    {"tempfile_mb_per_sec", true, 0, -1},
+    {"corpus_ns_per_line", false, 0, -1},
+    {"builtin_commands_per_sec", true, 0, -1},
+    {"external_commands_per_sec", true, 0, -1},
+    {"worker_commands_per_sec", true, 0, -1},
+    {"worker_launch_p50_us", false, 0, -1},
+    {"worker_launch_p99_us", false, 0, -1},
+    {"args_ns_per_word", false, 0, -1},
+    {"allocs_per_1k_lines", false, 0, -1}
+};
+
+const char *shellPath;          // Binary under test.
+const char *corpusPath = "bench/corpus.txt";    // Realistic script lines for the corpus workload.
+char *corpus;                   // Contents of corpusPath.
+const char *shimPath = "bench/allocs.so";      // Preloaded to count the shell's allocations.
+int corpusLines;                // Lines in corpus.
+char workDir[] = "/tmp/smallbench.XXXXXX";  // Scripts and output live here for the run.
+double *samples;                // Launch latencies from one run, in microseconds.
+int sampleNum;
+
+/* Function declarations */
+double now();
+bool readCorpus(const char* path);
+bool writeScript(const char* name, const char* header, const char* line, int count, const char* footer);
+int writeLoops(char* header, char* footer, size_t size, int digits);
+bool runShell(const char* option, const char* name, double* wall, long* maxrss);
+bool countAllocations(const char* name, double* count);
+bool readLatencies();
+int compareSamples(const void* a, const void* b);
+double percentile(double fraction);
+void setMetric(const char* name, double value);
+struct metric* findMetric(const char* name);
+bool runWorkloads();
+void readBaseline(const char* path);
+bool writeResults(const char* path);
+int checkRegressions(double threshold);
+void removeWorkDir();
+
+
+/*******************************************************************
+ * Name: int main(int argc, char *argv[])
+ * Description: Parses the options, runs every workload, writes the
+ *              results and checks them against the baseline.
+ * Arguments: Usage: bench [-a SHIM] [-b BASELINE] [-c CORPUS]
+ *            [-o RESULTS] [-t PERCENT] [-u] SHELL. With -u the
+ *            results become the baseline.
+ * Returns: 0 when no metric regressed, 1 when one did, and 2 when
+ *          the benchmark could not run.
+ *******************************************************************/
+int main(int argc, char *argv[])
+{
+    const char *baselinePath = "bench/baseline.json";
+    const char *resultsPath = "bench/results.json";
+    double threshold = THRESHOLD;
+    bool update = false;    // Indicates the results replace the baseline.
+    int option;
+    int status;
+
+    while((option = getopt(argc, argv, "a:b:c:o:t:u")) != -1){
+        switch(option){
+            case 'a':
+                shimPath = optarg;
+                break;
+            case 'b':
+                baselinePath = optarg;
+                break;
+            case 'c':
+                corpusPath = optarg;
+                break;
+            case 'o':
+                resultsPath = optarg;
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            case 'u':
+                update = true;
+                break;
+            default:
+                printf("usage: bench [-a SHIM] [-b BASELINE] [-c CORPUS] [-o RESULTS] [-t PERCENT] [-u] SHELL\n");
+                return 2;
+        }
+    }
+    if(optind != argc - 1){
+        printf("usage: bench [-a SHIM] [-b BASELINE] [-c CORPUS] [-o RESULTS] [-t PERCENT] [-u] SHELL\n");
+        return 2;
+    }
+    shellPath = argv[optind];
+    if(readCorpus(corpusPath) == false){
+        return 2;
+    }
+
+    if(mkdtemp(workDir) == NULL){
+        printf("bench: %s: %s\n", workDir, strerror(errno));
+        return 2;
+    }
+    samples = malloc(LAUNCH_COUNT * sizeof(double));
+    if(samples == NULL || runWorkloads() == false){
+        removeWorkDir();
+        return 2;
+    }
+    removeWorkDir();
+
+    if(writeResults(resultsPath) == false || (update == true && writeResults(baselinePath) == false)){
+        return 2;
+    }
+    if(update == true){
+        printf("bench: baseline written to %s\n", baselinePath);
+        return 0;
+    }
+    readBaseline(baselinePath);
+    status = checkRegressions(threshold);
+    return status;
+}
+
+
+/*******************************************************************
+ * Name: double now()
+ * Description: Reads the monotonic clock.
+ * Returns: The time in seconds.
+ *******************************************************************/
+double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*******************************************************************
+ * Name: bool readCorpus(const char* path)
+ * Description: Reads the corpus into memory and counts its lines.
+ * Arguments: The corpus file's path.
+ * Returns: False if it could not be read or does not end with a
+ *          newline.
+ *******************************************************************/
+bool readCorpus(const char* path)
+{
+    FILE *file;
+    long size;
+    size_t length;
+    size_t i;
+
+    file = fopen(path, "r");
+    if(file == NULL){
+        printf("bench: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    corpus = malloc(size + 1);
+    if(corpus == NULL){
+        printf("bench: out of memory\n");
+        fclose(file);
+        return false;
+    }
+    length = fread(corpus, 1, size, file);
+    corpus[length] = '\0';
+    fclose(file);
+    if(length == 0 || corpus[length - 1] != '\n'){
+        printf("bench: %s: must end with a newline\n", path);
+        return false;
+    }
+
+    corpusLines = 0;
+    for(i = 0; i < length; i++){
+        if(corpus[i] == '\n'){
+            corpusLines++;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool writeScript(const char* name, const char* header,
+ *                        const char* line, int count,
+ *                        const char* footer)
+ * Description: Writes a workload script into the work directory: a
+ *              header, one line repeated count times, and a footer.
+ * Arguments: The script's file name, the header, the repeated line
+ *            and the footer. Each is written as given, so each
+ *            ends with its own newline.
+ * Returns: False if the script could not be written.
+ *******************************************************************/
+bool writeScript(const char* name, const char* header, const char* line, int count, const char* footer)
+{
+    char path[MAX_LINE];
+    FILE *script;
+    int i;
+
+    snprintf(path, sizeof(path), "%s/%s", workDir, name);
+    script = fopen(path, "w");
+    if(script == NULL){
+        printf("bench: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fputs(header, script);
+    for(i = 0; i < count; i++){
+        fputs(line, script);
+    }
+    fputs(footer, script);
+    return fclose(script) == 0;
+}
+
+
+/*******************************************************************
+ * Name: int writeLoops(char* header, char* footer, size_t size,
+ *                      int digits)
+ * Description: Writes the header and footer of nested for loops,
+ *              each over the ten digits, to wrap a loop body.
+ * Arguments: Buffers of size bytes for the header and footer, and
+ *            the number of loops.
+ * Returns: The number of passes the body makes.
+ *******************************************************************/
+int writeLoops(char* header, char* footer, size_t size, int digits)
+{
+    int passes = 1;
+    int i;
+
+    header[0] = '\0';
+    footer[0] = '\0';
+    for(i = 0; i < digits; i++){
+        snprintf(header + strlen(header), size - strlen(header), "for d%d in 0 1 2 3 4 5 6 7 8 9; do\n", i);
+        snprintf(footer + strlen(footer), size - strlen(footer), "done\n");
+        passes *= 10;
+    }
+    return passes;
+}
+
+
+/*******************************************************************
+ * Name: bool runShell(const char* option, const char* name,
+ *                     double* wall, long* maxrss)
+ * Description: Runs the shell on a script from the work directory,
+ *              with stdin from /dev/null and stdout and stderr
+ *              going to "output" there.
+ * Arguments: An option for the shell, such as "-f", or NULL for
+ *            none, the script's file name, and pointers that
+ *            receive the wall time in seconds and the peak resident
+ *            set size in kilobytes of the shell and the commands it
+ *            waited for.
+ * Returns: False if the shell could not run or did not exit 0.
+ *******************************************************************/
+bool runShell(const char* option, const char* name, double* wall, long* maxrss)
+{
+    char script[MAX_LINE];
+    char output[MAX_LINE];
+    struct rusage usage;
+    double started;
+    pid_t pid;
+    int status;
+    int fd;
+
+    snprintf(script, sizeof(script), "%s/%s", workDir, name);
+    snprintf(output, sizeof(output), "%s/output", workDir);
+    fflush(stdout);
+    started = now();
+    pid = fork();
+    if(pid == -1){
+        printf("bench: fork: %s\n", strerror(errno));
+        return false;
+    }
+    if(pid == 0){
+        fd = open("/dev/null", O_RDONLY);
+        dup2(fd, 0);
+        fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, 1);
+        dup2(fd, 2);
+        if(option != NULL){
+            execl(shellPath, shellPath, option, script, (char*)NULL);
+        }
+        else{
+            execl(shellPath, shellPath, script, (char*)NULL);
+        }
+        fprintf(stderr, "bench: %s: %s\n", shellPath, strerror(errno));
+        _exit(127);
+    }
+    if(wait4(pid, &status, 0, &usage) == -1){
+        printf("bench: wait4: %s\n", strerror(errno));
+        return false;
+    }
+    *wall = now() - started;
+    *maxrss = usage.ru_maxrss;
+    if(WIFEXITED(status) == false || WEXITSTATUS(status) != 0){
+        printf("bench: %s failed on %s; see %s\n", shellPath, name, output);
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool countAllocations(const char* name, double* count)
+ * Description: Runs the shell on a script with the shim preloaded
+ *              and reads back how often it called malloc, calloc
+ *              and realloc.
+ * Arguments: The script's file name and a pointer that receives
+ *            the count.
+ * Returns: False if the shell failed or left no count.
+ *******************************************************************/
+bool countAllocations(const char* name, double* count)
+{
+    char shim[PATH_MAX];
+    char path[MAX_LINE];
+    FILE *file;
+    double wall;
+    long maxrss;
+    bool ran;
+
+    if(realpath(shimPath, shim) == NULL){
+        printf("bench: %s: %s\n", shimPath, strerror(errno));
+        return false;
+    }
+    snprintf(path, sizeof(path), "%s/allocs", workDir);
+    unlink(path);
+    setenv("LD_PRELOAD", shim, 1);
+    setenv("SMALLBENCH_ALLOCS", path, 1);
+    ran = runShell(NULL, name, &wall, &maxrss);
+    unsetenv("LD_PRELOAD");
+    unsetenv("SMALLBENCH_ALLOCS");
+    if(ran == false){
+        return false;
+    }
+    file = fopen(path, "r");
+    if(file == NULL || fscanf(file, "%lf", count) != 1){
+        printf("bench: %s left no allocation count\n", shim);
+        if(file != NULL){
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool readLatencies()
+ * Description: Collects the "real=" time of every "time -m" report
+ *              in the shell's output into samples, sorted.
+ * Returns: False if there were no reports.
+ *******************************************************************/
+bool readLatencies()
+{
+    char path[MAX_LINE];
+    char line[MAX_LINE];
+    FILE *output;
+    char *real;
+
+    snprintf(path, sizeof(path), "%s/output", workDir);
+    output = fopen(path, "r");
+    if(output == NULL){
+        printf("bench: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    sampleNum = 0;
+    while(sampleNum < LAUNCH_COUNT && fgets(line, sizeof(line), output) != NULL){
+        real = strstr(line, " real=");
+        if(strncmp(line, "time ", 5) == 0 && real != NULL){
+            samples[sampleNum++] = atof(real + 6) * 1e6;
+        }
+    }
+    fclose(output);
+    if(sampleNum == 0){
+        printf("bench: no \"time -m\" reports in %s\n", path);
+        return false;
+    }
+    qsort(samples, sampleNum, sizeof(double), compareSamples);
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: int compareSamples(const void* a, const void* b)
+ * Description: Orders two latencies for qsort.
+ * Arguments: Pointers to the two doubles.
+ * Returns: Negative, zero or positive as a is less than, equal to
+ *          or greater than b.
+ *******************************************************************/
+int compareSamples(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/*******************************************************************
+ * Name: double percentile(double fraction)
+ * Description: Picks a percentile from the sorted samples by the
+ *              nearest-rank method.
+ * Arguments: The fraction of samples at or below the result.
+ * Returns: The latency in microseconds.
+ *******************************************************************/
+double percentile(double fraction)
+{
+    int rank = (int)(fraction * sampleNum + 0.999999);
+
+    if(rank < 1){
+        rank = 1;
+    }
+    return samples[rank - 1];
+}
+
+
+/*******************************************************************
+ * Name: void setMetric(const char* name, double value)
+ * Description: Keeps the better of a new value and the one from an
+ *              earlier run, so each metric reports the best run.
+ * Arguments: The metric's name and the value just measured.
+ *******************************************************************/
+void setMetric(const char* name, double value)
+{
+    struct metric *m = findMetric(name);
+
+    if(m->value == 0 || (m->higherBetter == true ? value > m->value : value < m->value)){
+        m->value = value;
+    }
+}
+
+
+/*******************************************************************
+ * Name: struct metric* findMetric(const char* name)
+ * Description: Looks up a metric by name.
+ * Arguments: The metric's name.
+ * Returns: A pointer into metrics, or NULL if there is no such one.
+ *******************************************************************/
+struct metric* findMetric(const char* name)
+{
+    int i;
+
+    for(i = 0; i < METRIC_NUM; i++){
+        if(strcmp(metrics[i].name, name) == 0){
+            return &metrics[i];
+        }
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: bool runWorkloads()
+ * Description: Writes each workload and runs it REPEATS times:
+ *              - launch: LAUNCH_COUNT external commands, for the
+ *                command rate;
+ *              - latency: the same with "time -m", for the p50 and
+ *                p99 launch-to-reap latency the shell measures;
+ *                both also run with -z, for the same numbers when
+ *                commands go to pre-forked workers;
+ *              - parse: PARSE_COUNT quoted assignments that run no
+ *                process, for parse and expansion time per line
+ *                less the time of an empty script;
+ *              - loop: nested for loops over builtins, for the rate
+ *                of commands run from the cached syntax tree;
+ *              - unrolled: the same body written out once per pass
+ *                on its own line, for the rate when every command
+ *                is read and parsed again;
+ *              - reap: REAP_COUNT background commands and "wait",
+ *                for the rate background processes are collected;
+ *              - padded: PADDED_COUNT commands with "time -m" after
+ *                the shell has grown by PADDED_BYTES, run with
+ *                posix_spawn and again with -f for fork, for the
+ *                p50 launch latency of a shell with a large RSS;
+ *              - pipeline: PIPE_BYTES through a three-stage "|"
+ *                pipeline, for its throughput;
+ *              - tempfile: the same bytes passed between the three
+ *                commands through files in the work directory, for
+ *                the throughput pipelines replaced;
+ *              - corpus: CORPUS_REPEAT copies of the corpus, lines
+ *                as build and deploy scripts write them that start
+ *                no process, for parse and expansion time per line
+ *                less the time of an empty script;
+ *              - builtin: loops calling echo, true, test, printf
+ *                and pwd, with redirections, for the rate builtins
+ *                run in the shell;
+ *              - external: the same loops calling the /bin and
+ *                /usr/bin utilities instead, for the rate when
+ *                every call forks;
+ *              - args: ARGS_COUNT "true" commands with ARGS_WORDS
+ *                plain, braced, quoted and variable arguments each,
+ *                for expansion time per argument less the time of
+ *                an empty script.
+ *              The corpus and empty scripts also run once with
+ *              the allocation counter preloaded, for the calls to
+ *              malloc, calloc and realloc per thousand corpus lines.
+ *              The peak RSS comes from the loop, which starts no
+ *              processes and reads a short script, so it is the
+ *              shell's own working memory.
+ * Returns: False if a workload could not be written or run.
+ *******************************************************************/
+bool runWorkloads()
+{
+    char header[MAX_LINE];
+    char footer[MAX_LINE];
+    char padding[MAX_LINE];
+    char pipeline[MAX_LINE];
+    char tempfile[MAX_LINE];
+    char args[ARGS_WORDS * 16];    // One args line, as long as its words make it.
+    double wall;
+    double empty;       // Start-up and exit time of the shell alone.
+    double allocs;      // Allocations made running the corpus.
+    double baseAllocs;  // Allocations made running the empty script.
+    long maxrss;
+    int commands;       // Commands run by the loop and unrolled workloads.
+    int passes;         // Times the loop body runs.
+    int builtins;       // Commands run by the builtin workload.
+    int externals;      // Commands run by the external workload.
+    int run;
+    int i;
+
+    passes = writeLoops(header, footer, sizeof(header), LOOP_DIGITS);
+    commands = 2 * passes;
+    snprintf(padding, sizeof(padding), "pad=$(head -c %d /dev/zero | tr '\\0' x)\n", PADDED_BYTES);
+    snprintf(pipeline, sizeof(pipeline), "head -c %d /dev/zero | cat | cat > /dev/null\n", PIPE_BYTES);
+    snprintf(tempfile, sizeof(tempfile), "head -c %d /dev/zero > %s/stage1\ncat < %s/stage1 > %s/stage2\n"
+        "cat < %s/stage2 > /dev/null\n", PIPE_BYTES, workDir, workDir, workDir, workDir);
+    if(writeScript("empty", "", "", 0, "") == false
+            || writeScript("launch", "", "/bin/true\n", LAUNCH_COUNT, "") == false
+            || writeScript("latency", "", "time -m /bin/true\n", LAUNCH_COUNT, "") == false
+            || writeScript("parse", "", "word=plain\"double $HOME\"'single'${USER}end\n", PARSE_COUNT, "") == false
+            || writeScript("loop", header, "x=$d0$d1$d2$d3$d4$d5; test $x != y\n", 1, footer) == false
+            || writeScript("unrolled", "d0=1; d1=2; d2=3; d3=4; d4=5; d5=6\n", "x=$d0$d1$d2$d3$d4$d5; test $x != y\n",
+                passes, "") == false
+            || writeScript("reap", "", "/bin/true &\n", REAP_COUNT, "wait\n") == false
+            || writeScript("padded", padding, "time -m /bin/true\n", PADDED_COUNT, "") == false
+            || writeScript("pipeline", pipeline, "", 0, "") == false
+            || writeScript("tempfile", tempfile, "", 0, "") == false
+            || writeScript("corpus", "", corpus, CORPUS_REPEAT, "true\n") == false){
+        return false;
+    }
+    /* Cycles through four kinds of argument so each expansion path is exercised alike. */
+    strcpy(args, "true");
+    for(i = 0; i < ARGS_WORDS; i++){
+        switch(i % 4){
+            case 0:
+                sprintf(args + strlen(args), " arg%d", i);
+                break;
+            case 1:
+                sprintf(args + strlen(args), " ${PWD}x%d", i);
+                break;
+            case 2:
+                sprintf(args + strlen(args), " \"$HOME/x%d\"", i);
+                break;
+            case 3:
+                sprintf(args + strlen(args), " ${USER}y%d", i);
+                break;
+        }
+    }
+    strcat(args, "\n");
+    if(writeScript("args", "", args, ARGS_COUNT, "") == false){
+        return false;
+    }
+    builtins = UTILITY_NUM * writeLoops(header, footer, sizeof(header), BUILTIN_DIGITS);
+    if(writeScript("builtin", header, "echo $d0 > /dev/null; true; test -d /; printf '%s\\n' $d0 > /dev/null; "
+            "pwd > /dev/null\n", 1, footer) == false){
+        return false;
+    }
+    externals = UTILITY_NUM * writeLoops(header, footer, sizeof(header), EXTERNAL_DIGITS);
+    if(writeScript("external", header, "/bin/echo $d0 > /dev/null; /bin/true; /usr/bin/test -d /; "
+            "/usr/bin/printf '%s\\n' $d0 > /dev/null; /bin/pwd > /dev/null\n", 1, footer) == false){
+        return false;
+    }
+
+    /* The count does not vary between runs, so it is taken once. */
+    if(countAllocations("corpus", &allocs) == false || countAllocations("empty", &baseAllocs) == false){
+        return false;
+    }
+    setMetric("allocs_per_1k_lines", (allocs - baseAllocs) / ((double)corpusLines * CORPUS_REPEAT) * 1000);
+
+    for(run = 0; run < REPEATS; run++){
+        if(runShell(NULL, "empty", &empty, &maxrss) == false){
+            return false;
+        }
+
+        if(runShell(NULL, "launch", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("commands_per_sec", LAUNCH_COUNT / wall);
+
+        if(runShell(NULL, "latency", &wall, &maxrss) == false || readLatencies() == false){
+            return false;
+        }
+        setMetric("launch_p50_us", percentile(0.50));
+        setMetric("launch_p99_us", percentile(0.99));
+
+        if(runShell("-z", "launch", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("worker_commands_per_sec", LAUNCH_COUNT / wall);
+
+        if(runShell("-z", "latency", &wall, &maxrss) == false || readLatencies() == false){
+            return false;
+        }
+        setMetric("worker_launch_p50_us", percentile(0.50));
+        setMetric("worker_launch_p99_us", percentile(0.99));
+
+        if(runShell(NULL, "parse", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("parse_ns_per_line", (wall > empty ? wall - empty : wall) / PARSE_COUNT * 1e9);
+
+        if(runShell(NULL, "loop", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("loop_commands_per_sec", commands / wall);
+        setMetric("peak_rss_kb", maxrss);
+
+        if(runShell(NULL, "unrolled", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("unrolled_commands_per_sec", commands / wall);
+
+        if(runShell(NULL, "reap", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("reap_per_sec", REAP_COUNT / wall);
+
+        if(runShell(NULL, "padded", &wall, &maxrss) == false || readLatencies() == false){
+            return false;
+        }
+        setMetric("padded_spawn_p50_us", percentile(0.50));
+        if(runShell("-f", "padded", &wall, &maxrss) == false || readLatencies() == false){
+            return false;
+        }
+        setMetric("padded_fork_p50_us", percentile(0.50));
+
+        if(runShell(NULL, "pipeline", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("pipeline_mb_per_sec", PIPE_BYTES / 1048576.0 / (wall > empty ? wall - empty : wall));
+
+        if(runShell(NULL, "tempfile", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("tempfile_mb_per_sec", PIPE_BYTES / 1048576.0 / (wall > empty ? wall - empty : wall));
+
+        if(runShell(NULL, "corpus", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("corpus_ns_per_line", (wall > empty ? wall - empty : wall) / ((double)corpusLines * CORPUS_REPEAT) * 1e9);
+
+        if(runShell(NULL, "builtin", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("builtin_commands_per_sec", builtins / (wall > empty ? wall - empty : wall));
+
+        if(runShell(NULL, "external", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("external_commands_per_sec", externals / (wall > empty ? wall - empty : wall));
+
+        if(runShell(NULL, "args", &wall, &maxrss) == false){
+            return false;
+        }
+        setMetric("args_ns_per_word", (wall > empty ? wall - empty : wall) / ((double)ARGS_COUNT * ARGS_WORDS) * 1e9);
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void readBaseline(const char* path)
+ * Description: Reads the baseline written by an earlier "bench -u".
+ *              Each metric is found by its quoted name, so the file
+ *              may hold metrics this driver does not know.
+ * Arguments: The baseline's path. A missing file leaves every
+ *            baseline unset.
+ *******************************************************************/
+void readBaseline(const char* path)
+{
+    char text[4096];
+    char key[MAX_LINE];
+    FILE *baseline;
+    size_t length;
+    char *found;
+    int i;
+
+    baseline = fopen(path, "r");
+    if(baseline == NULL){
+        printf("bench: no baseline at %s; run \"make baseline\" to store one\n", path);
+        return;
+    }
+    length = fread(text, 1, sizeof(text) - 1, baseline);
+    text[length] = '\0';
+    fclose(baseline);
+
+    for(i = 0; i < METRIC_NUM; i++){
+        snprintf(key, sizeof(key), "\"%s\":", metrics[i].name);
+        found = strstr(text, key);
+        if(found != NULL){
+            metrics[i].baseline = atof(found + strlen(key));
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: bool writeResults(const char* path)
+ * Description: Writes every metric as one flat JSON object, one
+ *              metric per line.
+ * Arguments: The file to write.
+ * Returns: False if it could not be written.
+ *******************************************************************/
+bool writeResults(const char* path)
+{
+    FILE *results;
+    int i;
+
+    results = fopen(path, "w");
+    if(results == NULL){
+        printf("bench: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(results, "{\n");
+    for(i = 0; i < METRIC_NUM; i++){
+        fprintf(results, "  \"%s\": %.1f%s\n", metrics[i].name, metrics[i].value, (i < METRIC_NUM - 1) ? "," : "");
+    }
+    fprintf(results, "}\n");
+    return fclose(results) == 0;
+}
+
+
+/*******************************************************************
+ * Name: int checkRegressions(double threshold)
+ * Description: Prints each metric beside its baseline and the
+ *              change, marking any that worsened by more than the
+ *              threshold.
+ * Arguments: The percent a metric may worsen.
+ * Returns: 1 if a metric regressed, otherwise 0.
+ *******************************************************************/
+int checkRegressions(double threshold)
+{
+    double change;      // Percent worse than the baseline; negative when better.
+    int failed = 0;
+    int i;
+
+    printf("%-24s %14s %14s %9s\n", "metric", "value", "baseline", "worse");
+    for(i = 0; i < METRIC_NUM; i++){
+        if(metrics[i].baseline <= 0){
+            printf("%-24s %14.1f %14s\n", metrics[i].name, metrics[i].value, "-");
+            continue;
+        }
+        change = (metrics[i].value - metrics[i].baseline) / metrics[i].baseline * 100;
+        if(metrics[i].higherBetter == true){
+            change = -change;
+        }
+        printf("%-24s %14.1f %14.1f %+8.1f%%%s\n", metrics[i].name, metrics[i].value, metrics[i].baseline,
+            change, (change > threshold) ? "  REGRESSED" : "");
+        if(change > threshold){
+            failed = 1;
+        }
+    }
+    if(failed != 0){
+        printf("bench: a metric is more than %.0f%% worse than the baseline\n", threshold);
+    }
+    return failed;
+}
+
+
+/*******************************************************************
+ * Name: void removeWorkDir()
+ * Description: Deletes the scripts, the output and the work
+ *              directory itself.
+ *******************************************************************/
+void removeWorkDir()
+{
+    const char *names[] = {"empty", "launch", "latency", "parse", "loop", "unrolled", "reap", "padded", "pipeline",
+        "tempfile", "stage1", "stage2", "corpus", "builtin", "external", "args",
+        "allocs", "output"};
+    char path[MAX_LINE];
+    size_t i;
+
+    for(i = 0; i < sizeof(names) / sizeof(names[0]); i++){
+        snprintf(path, sizeof(path), "%s/%s", workDir, names[i]);
+        unlink(path);
+    }
+    rmdir(workDir);
+}
@@ -1,590 +1,9648 @@
-/*******************************************************************
-* Michael S. Lewis
-* CS 344 Fall 2017
-* Program 3: smallsh
-********************************************************************/
-
-#include <stdio.h>
-#include <stdbool.h>
-#include <string.h>
-#include <unistd.h>
-#include <stdlib.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <sys/wait.h>
-#include <signal.h>
-#include <errno.h>
-
-/* Preprocessor directives (to expand with constants). */
-#define MAX_CHARS 2048      // Maximum length of command line shell will support.
-#define MAX_ARGS 512        // Maximum number of arguments shell will support.
-
-/* Organizes attributes for any parsed input. */
-struct parsedInput
-{
-    bool backMode;                  // Indicates a background process is active when true.
-    char inputFile[128];            // Stores string for reading from input file.
-    char outputFile[128];           // Stores string for writing to output file.
-    char shellCommand[MAX_CHARS];   // Stores string for a command.
-    int argNum;                     // Counts number of arguments within a parsed line.
-    char *arguments[MAX_ARGS];      // Stores arguments from parsed input.
-};
-
-/* Process ID stack is used for managing background processes. */
-struct processStack
-{
-    int backPidNum;             // Counts background processes.
-    pid_t backPids[MAX_ARGS];   // Stores each ID of background processes.
-};
-
-/* Global variables. */
-struct processStack pidStack;   // Instantiates the processStack.
-int foregroundValue;            // Indicates exit status or signal used to terminate.
-bool foregroundMode = false;    // Indicates when foreground mode is enabled. Initiated as disabled.
-
-/* Function declarations. */
-void removeBackPid(pid_t processId);
-int changeDir(char* inputBuffer);
-bool testForOperator(char *str);
-void parseForStrings(char* inputBuffer, struct parsedInput* obj);
-void makeArgs(struct parsedInput* obj, char** argsArray);
-void redirectIO(struct parsedInput* obj);
-void forkProcesses(struct parsedInput* obj);
-void trapStopSig(int sig);
-void trapChildSig(int sig);
-void trapTermSig(int sig);
-void resetInput(struct parsedInput* obj);
-void endProcess();
-void testBackMode();
-
-
-int main()
-{
-    char inputBuffer[MAX_CHARS];    // Stores input from stdio.
-    struct parsedInput *obj;        // Instantiates the parsedInput.
-    int fgStatus;                   // Stores exit status or signal used to terminate.
-    int i;                          // Index for loop.
-    char *tempdir1;                 // Handles source for pid variable parsing.
-    char *tempdir2;                 // Handles destination for pid variable parsing.
-    char *pidVar;                   // Stores pid value for string.
-
-    /* Creates stack of background process ID's. */
-    pidStack.backPidNum = -1;
-    for(i = 0; i < MAX_ARGS; i++){
-        pidStack.backPids[i] = -1;  // Initializes each value in backPids to -1.
-    }
-
-    /* Initializes Stop signal. */
-    struct sigaction StopSignal;
-    StopSignal.sa_handler = trapStopSig;
-    StopSignal.sa_flags = 0;
-
-    /* Initializes Terminate signal. */
-    struct sigaction TermSignal;
-    TermSignal.sa_handler = trapTermSig;
-    StopSignal.sa_flags = 0;
-
-    /* Initializes Child signal. */
-    struct sigaction ChildSignal;
-    ChildSignal.sa_handler = trapChildSig;
-    StopSignal.sa_flags = 0;
-
-    /* Loop manages signal handlers, shell built-ins, and prompt for command line. */  
-    do
-    {
-        /* Resets signal handlers. */
-        sigaction(SIGCHLD, &ChildSignal, NULL);
-        sigaction(SIGTSTP, &StopSignal, NULL);
-        sigaction(SIGINT, &TermSignal, NULL);
-
-        usleep(3000);   // Wait state avoids a race condition between trapping signals and subsequent commands.
-
-        testBackMode();   // If a stop signal is caught, the foreground mode is switched.
-
-        /* Flushes the buffer to clear stdout and stdin. */
-        fflush(stdout);
-        fflush(stdin);
-
-        /* Prints a colon as the prompt. */
-        printf(": ");
-        memset(inputBuffer, '\0', sizeof(inputBuffer));
-        fgets(inputBuffer, sizeof(inputBuffer), stdin); // Gets user input to command line.
-        
-        /* Flushes the buffer to clear stdout and stdin. */
-        fflush(stdout);
-        fflush(stdin);
-
-        /* Handles built-in commands and special characters. */
-        if(strncmp(inputBuffer, "exit", 4) == 0){ // Recognizes "exit" command and exits from shell.
-            endProcess();
-            exit(0);
-        }
-        if((pidVar = strstr(inputBuffer, "testdir$$")) != NULL) {   // Handles expansion of pid variable.
-            int replacePID = (int)getpid();     // Stores current pid.
-            tempdir1 = malloc(sizeof(char) * 8);    // Allocates memory for string to hold source.
-            tempdir2 = malloc(sizeof(char) * 20);   // Allocates memory for string to hold destination.
-            strcpy(tempdir1, "testdir");            // Builds string to hold test directory.
-            sprintf(tempdir2, "%s%d", tempdir1, replacePID);    // Stores concatenated testdir and pid.
-            char* tempString = malloc(sizeof(char) * strlen(inputBuffer));  // Allocates memory for string.
-            *pidVar = 0;    // Clears pidVar.
-            strcpy(tempString, inputBuffer);    // Copies inputBuffer as string.
-            sprintf(inputBuffer, "%s%s", tempString, tempdir2); // Replaces inputBuffer with final string.
-            free(tempString);   // Frees and de-allocates tempString memory.
-            tempString = NULL;
-            strtok(inputBuffer, "$"); // Truncates pid variable from argument string.
-        }
-        if(strncmp(inputBuffer, "#", 1) == 0){ // Recognizes '#' character and ignores comment.
-            continue;
-        }
-        else if(strncmp(inputBuffer, "\n", 1) == 0){ // Recognizes empty line and proceeds to next line.
-            continue;
-        }
-        else if(strncmp(inputBuffer, "cd", 2) == 0){ // Recognizes "cd" command to change directories.
-            changeDir(inputBuffer);
-        }
-        else if(strncmp(inputBuffer, "status",6) == 0){ // Tests for last exit value from foreground.
-            if(WEXITSTATUS(foregroundValue)){
-                fgStatus = WEXITSTATUS(foregroundValue);    // Tests if process exited.
-            }
-            else{
-                fgStatus = WTERMSIG(foregroundValue); // Tests if process was terminated by a signal.
-            }
-            printf("exit value %d\n", fgStatus);
-        }
-        else{
-            if(inputBuffer != NULL && strcmp(inputBuffer, "") != 0){
-                /* Reads input to parse for strings. */
-                obj = malloc(1 * sizeof(struct parsedInput)); 
-                parseForStrings(inputBuffer, obj); // Parses input.
-
-                forkProcesses(obj); // Runs commands and manages parent and child processes.
-
-                resetInput(obj);    // Frees memory and clears the input object.
-            }
-            else{
-                continue;   // Proceeds through loop again while true.
-            }
-        }
-    } while(true);
-
-    return 0;
-}
-
-
-/*******************************************************************
- * Name: void removeBackPid(pid_t processId)
- * Description: Removes the process ID if a prior background
- *              process ends.
- * Arguments: A pid_t for the process ID.
- *******************************************************************/
-void removeBackPid(pid_t processId)
-{
-    int i;      // Index for loop.
-    int pidPos; // Stores position of process ID in stack.
-
-    /* Locates process ID in stack that matches background process that ended. */
-    for(i = 0; i < pidStack.backPidNum + 1; i++){
-        if(pidStack.backPids[i] == processId){
-            pidPos = i;
-            break;  // Exits for loop once process ID is located.
-        }
-    }
-
-    /* Reorders remaining each remaining process ID in stack. */
-    for(i = pidPos; i < pidStack.backPidNum + 1; i++){
-        pidStack.backPids[i] = pidStack.backPids[i+1];
-    }
-    
-    pidStack.backPidNum--;  // Decrements process ID count after pid is removed.
-}
-
-
-/*******************************************************************
- * Name: int changeDir(char* inputBuffer)
- * Description: Facilitates operations to change and navigate
- *              from the working directory.
- * Arguments: Pointer to char for buffer to store user input.
- *******************************************************************/
-int changeDir(char* inputBuffer)
-{
-    char* homePath = getenv("HOME"); // Gets path to home directory.
-    char newPath[MAX_CHARS];    // Stores string for name of specified directory path.
-
-    inputBuffer[strlen(inputBuffer) -1] = '\0';
-
-    if(strcmp(inputBuffer,"cd") == 0){
-        if(chdir(homePath) != 0){ // Returning anything but 0 means directory not found.
-            printf("Directory:%s not found.\n", homePath);
-            return 1;
-        }
-        return 0;
-    }
-
-    memset(newPath, '\0', sizeof(newPath)); // Clears out string for name of specified directory path.
-
-    strtok(inputBuffer, " "); // Removes extraneous spaces.
-    strcpy(inputBuffer, strtok(NULL, ""));
-    
-    /* Directory commands. */
-    if(inputBuffer[0] == '/'){
-        sprintf(newPath, "%s%s", homePath, inputBuffer); // Navigates to a specifed directory from home directory.
-    }
-    else if(strcmp(inputBuffer, "..") == 0){ // Navigates back by one folder.
-        strcpy(newPath, inputBuffer);
-    }
-    else if(strcmp(inputBuffer, "~") == 0){ // Navigates to home directory.
-        strcpy(newPath, homePath);
-    }
-    else if(inputBuffer[0] == '.' && inputBuffer[1] == '/'){ // Stays in current directory.
-        sprintf(newPath, "%s", inputBuffer);
-    }
-    else{
-        sprintf(newPath, "%s", inputBuffer); // Navigates to specified directory from home directory path.
-    }
-    if(chdir(newPath) != 0){ // Handles a directory not found.
-        printf("Directory:%s not found.\n", newPath);
-        return 1;
-    }
-    return 0;
-}
-
-
-/*******************************************************************
- * Name: bool testForOperator(char *str)
- * Description: Tests for '&', '<', '>', or '#'. If the char is any
- *              of these, returns bool as true.
- * Arguments: Pointer to char to test input.
- *******************************************************************/
-bool testForOperator(char *str)
-{
-    bool shellChar = false; // Indicates if the character has operator functionality for the shell.
-
-    if(str == NULL){ // Tests for null value to prevent segmentation fault for remaining conditions.
-        return true;
-    }
-
-    if(str[0] == '&'){ // Tests for bg mode character.
-        shellChar = true;
-    }
-    else if(str[0] == '<'){ // Tests for input redirection character.
-        shellChar = true;
-    }
-    else if(str[0] == '>'){ // Tests for output redirection character.
-        shellChar = true;
-    }
-    else if(str[0] == '#'){ // Tests for comment character.
-        shellChar = true;
-    }
-    return shellChar;
-}
-
-
-/*******************************************************************
- * Name: void parseForStrings(char* inputBuffer, struct parsedInput* obj)
- * Description: Initializes the parsedInput struct with any args.
- * Arguments: Pointer to parsedInput struct and pointer to char to
- *            parse input.
- *******************************************************************/
-void parseForStrings(char* inputBuffer, struct parsedInput* obj)
-{
-    char dataBuffer[MAX_CHARS]; // Temporary buffer for storing contents of inputBuffer.
-    char *inputFileName;        // Stores descriptor for input file.
-    char *outputFileName;       // Stores descriptor for output file.
-    char *temp;                 // Stores argument copied from the data buffer.
-
-    obj->argNum = 0;
-    inputBuffer[strlen(inputBuffer) -1] = '\0'; // Removes newline character.
-
-    if(inputBuffer[strlen(inputBuffer) -1] == '&'){ // Tests for background mode.
-        obj->backMode = true;                       // Background mode is already enabled.
-        inputBuffer[strlen(inputBuffer) -1] = '\0'; // Ignores and removes the ampersand.
-    }
-    else{
-        obj->backMode = false;    // Background mode is not enabled.
-    }
-
-    /* Parses a command from input and places in command array. */
-    memset(dataBuffer, '\0', sizeof(dataBuffer)); // Clears out dataBuffer.
-    strcpy(dataBuffer, inputBuffer); // Copies contents of inputBuffer to dataBuffer.
-    strtok(dataBuffer, " "); // Grabs only the command portion of input.
-    strcpy(obj->shellCommand, dataBuffer); // Copies command input into new shellCommand object.
-
-    /* Parses input file name. */
-    memset(dataBuffer, '\0', sizeof(dataBuffer)); // Clears out dataBuffer.
-    strcpy(dataBuffer, inputBuffer);    // Copies inputBuffer into dataBuffer.
-    inputFileName = strstr(dataBuffer, "<"); // Locates substring after input redirection operator.
-    if(inputFileName != NULL){
-        memmove(inputFileName, inputFileName+2, strlen(inputFileName)); // Copies memory block of string, minus operator.
-        strtok(inputFileName, " "); // Truncates space from input file name string.
-        inputFileName[strlen(inputFileName)] = '\0'; // Terminates string with null character. 
-        strcpy(obj->inputFile, inputFileName);  // Copies string into inputFile object.
-    }
-
-    /* Parses output file name. */
-    memset(dataBuffer, '\0', sizeof(dataBuffer));   // Clears out dataBuffer.
-    strcpy(dataBuffer, inputBuffer);                // Copies inputBuffer into dataBuffer.
-    outputFileName = strstr(dataBuffer, ">");       // Locates substring after output redirection operator.
-    if(outputFileName != NULL){
-        memmove(outputFileName, outputFileName+2, strlen(outputFileName));  // Copies memory block of string, minus operator.
-        strtok(outputFileName, " ");                    // Truncates space from output file name string.
-        outputFileName[strlen(outputFileName)] = '\0';  // Terminates string with null character. 
-        strcpy(obj->outputFile, outputFileName);        // Copies string into outputFile object.
-    }
-     
-    /* Parses arguments. */
-    memset(dataBuffer, '\0', sizeof(dataBuffer));   // Clears out dataBuffer.
-    strcpy(dataBuffer, inputBuffer);    // Copies inputBuffer into dataBuffer.
-    strtok(dataBuffer, " ");    // Grabs only the argument portion of input before space.
-
-    temp = strtok(NULL, "");    // Grabs only the argument portion of input after space.
-
-    if(testForOperator(temp) == false){ // Tests if any arguments are present.
-        strcpy(dataBuffer, temp);   // Copies stored argument portion into dataBuffer.
-        strtok(dataBuffer, "<>#"); // Grabs any special characters before arguments.
-        
-        strtok(dataBuffer, " "); // Truncates space from argument string.
-        obj->arguments[0] = dataBuffer; // Stores contents of dataBuffer as first argument.
-        obj->argNum = 1;   // Identifies the first argument entered.
-        temp = strtok(NULL, " "); // Prepares to recognize any subsequent arguments in input.
-        while(temp != NULL){
-            
-            obj->arguments[obj->argNum] = temp;    // Stores remaining arguments.
-            obj->argNum++;                         // Increments argument count.
-            temp = strtok(NULL, " ");   // Prepares to recognize any subsequent arguments in input.
-        }
-        obj->arguments[obj->argNum] = strtok(NULL, "");    // Grabs the final argument as object attribute.
-    }
-}
-
-
-/*******************************************************************
- * Name: void makeArgs(struct parsedInput* obj, char** argsArray)
- * Description: Generates list of arguments that can later be
- *              passed to execvp.
- * Arguments: A pointer to an array of pointers and a pointer to a
- *            parsedInput struct.
- *******************************************************************/
-void makeArgs(struct parsedInput* obj, char** argsArray)
-{
-    int i;  // Index for loop.
-
-    argsArray[0] = obj->shellCommand; // Stores the command as the initial argument.
-    for(i = 0; i < obj->argNum ; i++){ // Loops through all argsArray.
-        if(getenv(obj->arguments[i]) != NULL){  // Tests if environment variable is not null.
-            argsArray[i+1] = getenv(obj->arguments[i]); // Adds as subsequent argument to list.
-        }
-        else if(strcmp(obj->arguments[i], "$$") == 0){  // Tests for process ID variable.
-            sprintf(argsArray[i+1], "%d", getpid());         // Expands to actual pid value.
-        }
-        else{
-            argsArray[i+1] = (obj->arguments[i]);    // Adds current argument object as subsequent argument to list.
-        }
-    }
-
-    argsArray[i+1] = NULL; // Terminates argsArray array.
-}
-
-
-/*******************************************************************
- * Name: void redirectIO(struct parsedInput* obj)
- * Description: Handles input and output redirection.
- * Arguments: A pointer to an parsedInput struct.
- *******************************************************************/
-void redirectIO(struct parsedInput* obj)
-{
-    int inputFileDescriptor = STDIN_FILENO;
-    int outputFileDescriptor = STDOUT_FILENO;
-
-    if(obj->inputFile[0] != '\0'){  // Tests if input file is empty.
-        /* Attempts to open input file. */
-        inputFileDescriptor = open(obj->inputFile, O_RDONLY);
-
-        if(inputFileDescriptor < 0){    // Tests for valid return value from opening file.
-            printf("cannot open file for input\n");   // Prints error message and exits, as needed.
-            exit(1);
-        }
-        dup2(inputFileDescriptor, 0);   // Duplicates file descriptor to redirect to stdin.
-        close(inputFileDescriptor);     // Closes the file.
-    }
-    if(obj->outputFile[0] != '\0'){ // Tests if output file is empty.
-        /* Attempts to open output file for creation or truncation, and assigns permission value. */
-        outputFileDescriptor = open(obj->outputFile,O_WRONLY | O_CREAT | O_TRUNC, 0644);
-
-        if(outputFileDescriptor < 0){   // Tests for valid return value from opening file.
-            printf("Error opening or creating file\n");  // Prints error message and exits, as needed.
-            exit(1);
-        }
-
-        dup2(outputFileDescriptor, 1);  // Duplicates file descriptor to redirect to stdout.
-        close(outputFileDescriptor);    // Closes the file.
-    }
-}
-
-
-/*******************************************************************
- * Name: void forkProcesses(struct parsedInput* obj)
- * Description: Creates a fork for a child process.
- * Arguments: A pointer to an parsedInput struct.
- *******************************************************************/
-void forkProcesses(struct parsedInput* obj)
-{
-    pid_t pid = fork();
-    pid_t topBackPid;   // Stores top of stack.
-    char *argList[MAX_ARGS];
-    int processValue;
-
-    switch(pid)
-    {
-        /* If value returns as -1, then there was an error in the fork. */
-        case -1:
-            printf("Something went wrong with fork()\n");
-            exit(1);
-            break;
-
-        /* If value returns as 0, then this is a child process. */
-        case 0:
-            redirectIO(obj);    // Handles input and output redirection for obj.
-            makeArgs(obj, argList); // Generates list of arguments with obj.
-            execvp(obj->shellCommand, argList); // Replaces current process with command from obj.
-            printf("%s: No such file or directory\n", argList[0]);
-            exit(1);
-            break;
-
-        /* Otherwise, this is a parent process. */
-        default:
-            if(obj->backMode == true && foregroundMode == false){ // Identifies background mode.
-
-                /* Adds the process ID for a background process to the process ID stack. */
-                pidStack.backPids[++(pidStack.backPidNum)] = pid;
-
-                /* Reads the process ID from the top of the stack, returning its pid. */
-                topBackPid = pidStack.backPids[pidStack.backPidNum];
-                printf("Background pid is %d\n", topBackPid);
-            }
-            else{
-                /* Waits for completion of child process with pid if background mode not enabled. */
-                waitpid(pid, &processValue, 0);
-                foregroundValue = processValue;
-            }
-            break;
-    }
-}
-
-
-/*******************************************************************
- * Name: void trapStopSig(int sig)
- * Description: Handles the stop signal (^z) to enter or exit from
- *              foreground mode.
- * Arguments: An int representing the signal.
- *******************************************************************/
-void trapStopSig(int sig)
-{
-    /* Enters foreground mode. */
-    if(foregroundMode == false){
-        char* message = ("\nEntering foreground-only mode (& is now ignored)\n");
-        write(STDOUT_FILENO, message, 50);
-        foregroundMode = true;  // Updates status of foreground mode global variable.
-    }
-    /* Exits from foreground mode. */
-    else{
-        char* message = "\nExiting foreground-only mode\n"; // exit Fg mode.
-        write(STDOUT_FILENO, message, 31);
-        foregroundMode = false; // Updates status of foreground mode global variable.
-    }
-}
-
-
-/*******************************************************************
- * Name: void trapChildSig(int sig)
- * Description: Handles signal when a child process is ending.
- * Arguments: An int representing the signal.
- *******************************************************************/
-void trapChildSig(int sig)
-{
-    pid_t childPid;
-    int childStatus;
-    int i;
-
-    /* Loops through stack to find ID of process that exited or was terminated. */
-    for(i = 0; i < pidStack.backPidNum + 1; i++){
-        childPid = waitpid(pidStack.backPids[i], &childStatus, WNOHANG); // Identifies process ID of the child.
-
-        if((childStatus == 0 || childStatus == 1) && childPid != 0 ){ // Handles messaging if process exited.
-            fprintf(stdout, "\nBackground pid %d is done: exit value %d\n", childPid,childStatus);
-            removeBackPid(childPid);    // Removes the process ID of the child from the stack.
-        }
-        else if(childPid != 0){ // Handles messaging if process was terminated.
-            fprintf(stdout, "\nBackground pid %d is done: terminated by signal %d\n", childPid, childStatus);
-            removeBackPid(childPid);    // Removes the process ID of the child from the stack.
-        }
-    }
-}
-
-
-/*******************************************************************
- * Name: void trapTermSig(int sig)
- * Description: Handles the terminate signal (^c).
- * Arguments: An int representing the signal.
- *******************************************************************/
-void trapTermSig(int sig)
-{
-    printf("\nterminated by signal %d\n", sig); // Indicates signal that terminated the process.
-}
-
-
-/*******************************************************************
- * Name: void resetInput(struct parsedInput* obj)
- * Description: Frees memory from the input object.
- * Arguments: A pointer to an inputobj struct.
- *******************************************************************/
-void resetInput(struct parsedInput* obj)
-{
-    obj->backMode = false; // Resets the background status (false is default).
-
-    /* Fully clears each parsedInput attribute with null characters. */
-    memset(obj->inputFile, '\0', sizeof(obj->inputFile));
-    memset(obj->outputFile, '\0', sizeof(obj->outputFile));
-    memset(obj->shellCommand, '\0', sizeof(obj->shellCommand));
-
-    free(obj);  // De-allocates object memory.
-}
-
-
-/*******************************************************************
- * Name: void endProcess()
- * Description: Facilitates exiting by interupting any remaining
- *              background processes.
- * Arguments: None.
- *******************************************************************/
-void endProcess()
-{
-    int i;  // Index for loop.
-
-    /* Loops through and interrupts all background processes in stack. */
-    for(i = 0; i < pidStack.backPidNum + 1; i++){
-        kill(pidStack.backPids[i], SIGINT);
-        usleep(2000);   // Wait state avoids a race condition between trapping signals and subsequent commands.
-    }
-}
-
-
-/*******************************************************************
- * Name: void testBackMode()
- * Description: If a stop signal is caught, the foreground mode is
- *              switched.
- * Arguments: None.
- *******************************************************************/
-void testBackMode()
-{
-    /* Exits from foreground mode if already in mode when a stop signal is caught. */
-    if(WTERMSIG(foregroundValue) == 11 && foregroundMode == true){
-        printf("\nExiting foreground-only mode\n");
-        foregroundMode = false; // Toggles foreground mode status to false.
-    }
-    /* Enters foreground mode if not already in mode when a stop signal is caught. */
-    else if(WTERMSIG(foregroundValue) == 11 && foregroundMode == false){
-        printf("\nEntering foreground-only mode (& is now ignored)\n");
-        foregroundMode = true;  // Toggles foreground mode status to true.
-    }
+/*******************************************************************
+* Michael S. Lewis
+* CS 344 Fall 2017
+* Program 3: smallsh
+********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <spawn.h>
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/* Preprocessor directives (to expand with constants). */
+#define MAX_CHARS 2048      // Initial size of the terminal input buffer; longer lines grow it.
+#define READ_BLOCK 65536    // Bytes requested per read when input is not a terminal.
+#define ARENA_BLOCK 65536   // Bytes in each arena block; larger requests get a block of their own.
+#define ARGS_START 8        // Initial room in an argument list; doubles as needed.
+
+/* Preprocessor directives for redirection kinds. */
+#define REDIR_IN 0      // "<file" opens the file for reading.
+#define REDIR_OUT 1     // ">file" creates or truncates the file.
+#define REDIR_APPEND 2  // ">>file" creates the file or appends to it.
+#define REDIR_BOTH 3    // "&>file" sends stdout and stderr to the file.
+#define REDIR_DUP 4     // "2>&1" makes one descriptor a copy of another.
+#define REDIR_STRING 5  // "<<<word" supplies the word and a newline as input.
+
+/* A single redirection, applied in the order written. */
+struct redirect
+{
+    int kind;       // One of the REDIR_ constants.
+    int fd;         // Descriptor being redirected (0, 1 or 2).
+    char *target;   // File name, here-string, or source descriptor for REDIR_DUP.
+};
+
+/* Descriptors a child receives, and those the shell opened for it. */
+struct fdPlan
+{
+    int fds[3];     // Descriptor for stdin, stdout and stderr, or -1 to inherit the shell's.
+    int *opened;    // Descriptors to close once the child holds its copies.
+    int openedNum;  // Counts opened.
+};
+
+/* Organizes attributes for any parsed input. All of it lives in cmdArena. */
+struct parsedInput
+{
+    bool backMode;          // Indicates a background process is active when true.
+    bool expand;            // Indicates some word or redirection target needs expandCommand.
+    struct redirect *redirects; // Stores each redirection in the order written.
+    int redirectNum;        // Counts redirections.
+    int redirectCapacity;   // Room in redirects.
+    int argNum;             // Counts the command and its arguments.
+    int argCapacity;        // Room in arguments, not counting the terminating NULL.
+    char **arguments;       // Stores the command followed by its arguments, NULL-terminated for exec.
+};
+
+/* A block of memory handed out by the arena. */
+struct arenaBlock
+{
+    struct arenaBlock *next;    // Next block, kept across resets for reuse.
+    size_t size;                // Usable bytes in data.
+    char data[];                // Memory handed out in order.
+};
+
+/* Bump allocator for everything parsed from one command line; reset before each line. */
+struct arena
+{
+    struct arenaBlock *head;    // First block; resetting returns here.
+    struct arenaBlock *current; // Block allocations are taken from.
+    size_t used;                // Bytes handed out from the current block.
+    char *last;                 // Most recent allocation, which arenaResize can change in place.
+};
+
+/* A point in an arena to release back to, so each pass of a loop reuses the same memory. */
+struct arenaPosition
+{
+    struct arenaBlock *current; // Block allocations were being taken from.
+    size_t used;                // Bytes handed out from that block.
+};
+
+/* Preprocessor directives for token types produced by the lexer. */
+#define TOK_END 0       // End of the text being lexed.
+#define TOK_WORD 1      // A word as written, before quote removal and expansion.
+#define TOK_PIPE 2      // The '|' operator.
+#define TOK_REDIRECT 3  // A redirection operator, with an optional descriptor number before it.
+#define TOK_AMP 4       // The '&' operator.
+#define TOK_ERROR 5     // An unterminated quote or an expansion that did not fit.
+#define TOK_SEMI 6      // The ';' operator.
+#define TOK_AND 7       // The "&&" operator.
+#define TOK_OR 8        // The "||" operator.
+#define TOK_NEWLINE 9   // The end of a line; a comment runs up to it.
+#define TOK_LPAREN 10   // The '(' of a function definition.
+#define TOK_RPAREN 11   // The ')' of a function definition.
+#define LEX_SPECIAL " \t\n|<>&;()'\"\\$`"     // Characters the lexer must look at; all others are kept as they are.
+
+/* A token is a slice of the input line. */
+struct token
+{
+    int type;       // One of the TOK_ constants.
+    char *text;     // NUL-terminated word for TOK_WORD; otherwise unused.
+    bool expand;    // Indicates the word holds quotes, backslashes or '$', left raw for expandWord.
+    bool quoted;    // Indicates the word held quotes, backslashes or '$', so it is never a reserved word.
+    int redirect;   // One of the REDIR_ constants for TOK_REDIRECT.
+    int fd;         // Descriptor being redirected for TOK_REDIRECT.
+};
+
+/* Tracks the lexer's position within a line of input. */
+struct lexer
+{
+    char *pos;      // Next unread character of the line.
+    char held;      // Operator overwritten by the previous word's terminator, or '\0'.
+};
+
+/* Preprocessor directives for the kinds of node in a parsed command. */
+#define NODE_PIPELINE 0 // Simple commands joined by '|'.
+#define NODE_AND 1      // "a && b": runs body only when condition succeeds.
+#define NODE_OR 2       // "a || b": runs body only when condition fails.
+#define NODE_GROUP 3    // "{ list; }".
+#define NODE_IF 4       // "if list; then list; [elif ...] [else list;] fi"; an elif is an NODE_IF in orElse.
+#define NODE_WHILE 5    // "while list; do list; done".
+#define NODE_UNTIL 6    // "until list; do list; done".
+#define NODE_FOR 7      // "for name [in words]; do list; done".
+#define NODE_FUNCTION 8 // "name() command", which defines a function.
+#define FUNCTION_DEPTH 1000 // Function calls that may be running at once.
+#define CONTINUE_PROMPT "> "    // Prompt shown while a command is unfinished.
+
+/* A command as parsed, run as often as needed; only expansion is redone each time. */
+struct node
+{
+    int kind;                       // One of the NODE_ constants.
+    bool negate;                    // Inverts the status, as a leading '!' asks.
+    struct parsedInput **stages;    // Commands of a NODE_PIPELINE, words not yet expanded.
+    int stageCount;                 // Counts stages.
+    struct parsedInput *words;      // Words a NODE_FOR loops over, or NULL for the positional parameters.
+    char *name;                     // Variable of a NODE_FOR, or name of a NODE_FUNCTION.
+    struct node *condition;         // List tested by NODE_IF and the loops; left side of NODE_AND and NODE_OR.
+    struct node *body;              // List run by a compound command; right side of NODE_AND and NODE_OR.
+    struct node *orElse;            // Else part of NODE_IF.
+    struct node *next;              // Next command of a list.
+};
+
+/* Pulls tokens for the parser, reading more lines until every compound command is closed. */
+struct parser
+{
+    struct lexer lex;   // Position within the current line.
+    struct token tok;   // Current token, already read.
+    bool failed;        // Indicates a syntax error was printed.
+    bool nested;        // Indicates the text is a command substitution, so no more lines are read.
+};
+
+/* A shell function, kept in funcArena so it outlives the line that defined it. */
+struct function
+{
+    char *name;             // Function name.
+    struct node *body;      // Compound command run for each call.
+    struct function *next;  // Next function in the same bucket chain.
+};
+
+/* Preprocessor directives for the background job table. */
+#define JOB_TABLE_START 64  // Initial slot count; doubles whenever the table fills.
+
+/* Preprocessor directives for resource usage reports. */
+#define TIME_OFF 0      // No report.
+#define TIME_HUMAN 1    // One labelled line for people.
+#define TIME_MACHINE 2  // One line of key=value pairs for scripts.
+
+/* Preprocessor directives for job control. */
+#define JOB_RUNNING 0   // waitJob was interrupted before the job ended.
+#define JOB_STOPPED 1   // The job was stopped, as by ^Z.
+#define JOB_DONE 2      // Every process of the job has ended.
+#define END_GRACE 250   // Milliseconds jobs have to end after an interrupt when the shell exits.
+
+/* Preprocessor directives for "timeout" and "ulimit". */
+#define TIMEOUT_STATUS 124  // Exit value of a job ended by its deadline, as timeout(1) reports.
+#define TIMEOUT_USAGE 125   // Exit value when the "timeout" prefix itself is wrong.
+#define LIMIT_MAX 8         // Resources "ulimit" knows; see limitOptions.
+
+/* What an event from deadlineLoop refers to. */
+struct watch
+{
+    struct deadline *deadline;  // Deadline the descriptor belongs to.
+    int index;                  // Index into pidFds, or -1 for the timer.
+};
+
+/* A job's deadline: a timerfd and a pidfd per process, all watched by deadlineLoop. */
+struct deadline
+{
+    struct job *job;        // Job the deadline ends.
+    int timerFd;            // timerfd that expires at the deadline, and again killAfter later.
+    int *pidFds;            // pidfd of each process of the job, or -1 once it has exited or if none was given.
+    int live;               // Counts processes not yet seen to exit; the deadline is retired at 0.
+    int signal;             // Signal sent when the deadline passes.
+    double killAfter;       // Seconds from then until SIGKILL, or 0 for never.
+    bool fired;             // Indicates signal was sent, so the next expiry sends SIGKILL.
+    struct watch *watches;  // The timer's watch, then one for each pidfd.
+};
+
+/* A resource "ulimit" can show or change. */
+struct limitOption
+{
+    char letter;        // Option naming the resource.
+    int resource;       // One of the RLIMIT_ constants.
+    rlim_t unit;        // Bytes, seconds or processes counted by each unit shown.
+    const char *label;  // Description printed by "ulimit -a".
+};
+
+/* A limit named on a "ulimit" command line, to show or to set. */
+struct limitSetting
+{
+    const struct limitOption *option;
+    rlim_t value;       // New limit, already multiplied by the unit, or RLIM_INFINITY.
+    bool shown;         // Indicates no value was given, so the limit is printed instead.
+    bool soft;          // Indicates the soft limit is shown or set.
+    bool hard;          // Indicates the hard limit is shown or set.
+};
+
+/* A command or pipeline, run in its own process group. */
+struct job
+{
+    int number;                 // Job number shown by "jobs", or 0 until the job is listed.
+    pid_t pgid;                 // Process group of the job; 0 until its first process starts.
+    pid_t *pids;                // Process ID of each command, or -1 once reaped or if it did not start.
+    int pidNum;                 // Counts entries in pids.
+    int running;                // Counts processes not yet reaped.
+    pid_t lastPid;              // Process ID of the last command, whose status is the job's.
+    int lastValue;              // Wait status of the last command once reaped.
+    bool stopped;               // Indicates the job is stopped.
+    struct termios modes;       // Terminal settings the job had when it stopped.
+    bool modesSaved;            // Indicates modes holds the job's settings.
+    int timeFormat;             // How to report resource usage when a process ends; TIME_OFF for none.
+    struct timespec started;    // Stores when the job was launched.
+    char *command;              // Command text shown by "jobs".
+    struct deadline *deadline;  // Deadline set by "timeout", or NULL once there is none.
+    bool timedOut;              // Indicates the deadline passed, so the job's status is TIMEOUT_STATUS.
+    struct job *next;           // Next job in the job list, most recently current first.
+};
+
+/* A slot in the background job table. */
+struct jobSlot
+{
+    pid_t pid;                  // Process ID of the background process, or -1 when the slot is free.
+    int next;                   // Next slot in the same bucket chain, or in the free-list.
+    struct job *job;            // Job the process belongs to.
+};
+
+/* Job table is a hash map keyed by pid for managing background processes. */
+struct jobTable
+{
+    struct jobSlot *slots;  // Stores each background process; grows as needed.
+    int *buckets;           // Heads of the bucket chains, indexed by pid.
+    int capacity;           // Number of slots and buckets (always a power of two).
+    int backPidNum;         // Counts background processes.
+    int freeHead;           // First unused slot, or -1 when the table is full.
+};
+
+/* Preprocessor directives for the command hash table. */
+#define HASH_BUCKETS 64     // Number of chains in the command hash table.
+
+/* A command name remembered with the full path it resolved to. */
+struct hashedCommand
+{
+    char *name;                 // Command name as typed.
+    char *path;                 // Absolute path found by searching PATH.
+    int hits;                   // Counts launches that used this entry.
+    struct hashedCommand *next; // Next entry in the same bucket chain.
+};
+
+/* Command hash table caches PATH lookups so each launch can exec directly. */
+struct commandTable
+{
+    struct hashedCommand *buckets[HASH_BUCKETS];    // Chains of remembered commands.
+    char *pathValue;                                // PATH the entries were resolved against.
+};
+
+/* A command the shell runs itself instead of launching a process. */
+struct builtinCommand
+{
+    const char *name;                       // Command name as typed.
+    void (*run)(struct parsedInput* obj);   // Runs the command and sets foregroundValue.
+    bool redirects;                         // Indicates '<' and '>' are applied around run.
+    bool captured;                          // Indicates "$(...)" may run it in the shell, as it changes no shell state.
+};
+
+/* Preprocessor directives for shell variables. */
+#define VAR_BUCKETS 256     // Buckets in the variable table (a power of two).
+#define ENV_START 64        // Initial room in the environment array; doubles as needed.
+#define FIELD_START 32      // Extra room given to each field being expanded; doubles as needed.
+
+/* Preprocessor directives for command substitution. */
+#define CAPTURE_START 256           // Initial room for a substitution's output; doubles as needed.
+#define CAPTURE_SPILL (64 * 1024)   // Output beyond this moves from cmdArena to a memfd.
+
+/* Output of a command substitution: in cmdArena while small, then in a mapped memfd. */
+struct capture
+{
+    char *text;         // Output read so far; NUL-terminated once complete.
+    size_t used;        // Bytes of output.
+    size_t capacity;    // Room at text, or the length of the mapping.
+    int fd;             // The memfd to close afterwards, or -1.
+    bool mapped;        // Indicates text is a mapping of a memfd.
+};
+
+/* A shell variable. Exported ones are also in the environment handed to commands. */
+struct variable
+{
+    char *name;             // Stores the variable's name.
+    char *entry;            // Stores "NAME=value" as placed in the environment, or NULL while unset.
+    char *value;            // Points just past the '=' in entry, or NULL while unset.
+    bool exported;          // Indicates the variable is passed to commands.
+    int envIndex;           // Position in the environment array, or -1 when not there.
+    struct variable *next;  // Next variable in the same bucket.
+};
+
+/* Variable table is a hash map by name, with the environment array kept up to date beside it. */
+struct variableTable
+{
+    struct variable *buckets[VAR_BUCKETS];
+    char **envp;                // Exported entries, NULL-terminated; environ points here.
+    struct variable **owners;   // The variable behind each envp entry, so removal is O(1).
+    int envCount;               // Counts entries in envp.
+    int envCapacity;            // Room in envp, not counting the terminating NULL.
+    unsigned long generation;   // Changes with envp, so a packed copy can be reused until then.
+};
+
+/* A word being expanded in cmdArena; unquoted expansions may split it into fields. */
+struct expansion
+{
+    char *text;                 // Field being built; usually the most recent arena allocation.
+    size_t used;                // Bytes of text filled so far.
+    size_t capacity;            // Room in text.
+    bool started;               // Indicates the field exists even if empty, as after "".
+    struct parsedInput *fields; // Receives finished fields, or NULL to keep the word whole.
+};
+
+/* Preprocessor directives for the pre-forked worker pool. */
+#define WORKER_POOL 4           // Idle workers kept ready by the -z option.
+#define WORKER_MESSAGE 65536    // Largest launch message; longer command lines are spawned instead.
+
+/* A pre-forked child of the shell waiting to exec a command. */
+struct worker
+{
+    pid_t pid;  // Process ID of the worker, which becomes the command's.
+    int sock;   // The shell's end of the worker's launch socket.
+};
+
+/* Idle workers, used from the end, and the helper that creates them. */
+struct workerPool
+{
+    struct worker workers[WORKER_POOL];
+    int count;      // Idle workers ready to launch.
+    int requested;  // Workers asked of the helper and not yet received.
+    pid_t helper;   // Process ID of the helper, or 0 when the pool is off.
+    int control;    // The shell's end of the helper's control socket.
+    int cwdFd;      // The shell's working directory, sent with every launch.
+};
+
+/* Starts each launch message; the strings follow. */
+struct launchHeader
+{
+    int redirects;  // Bit 0 when stdin is attached, bit 1 when stdout is, bit 2 when stderr is.
+    int argCount;   // Arguments after the path.
+    int envCount;   // Environment variables after the arguments.
+    pid_t pgid;     // Process group to join, 0 to lead a new one, or -1 to stay in the shell's.
+};
+
+/* Tracks the jobs of a running "parallel" command. */
+struct parallelRun
+{
+    char **items;               // Stores the argument appended for each job.
+    pid_t *pids;                // Process ID in each worker slot, or -1 when the slot is idle.
+    int *jobIndex;              // Index into items of the job in each worker slot.
+    struct timespec *started;   // Stores when the job in each worker slot was launched.
+    int slots;                  // Number of jobs kept running at once.
+    int running;                // Counts jobs still running.
+    int failed;                 // Counts jobs that exited non-zero or were terminated.
+};
+
+/* Preprocessor directives for the execution trace. */
+#define TRACE_RING 1048576  // Bytes in the trace ring buffer (a power of two).
+#define TRACE_RECORD 4096   // Largest trace record; longer argument lists are cut short.
+
+/* Single-producer, single-consumer byte ring between the shell and the trace writer thread. */
+struct traceRing
+{
+    char *data;                 // Records waiting to be written, as JSON lines.
+    atomic_ulong head;          // Bytes ever published by the shell.
+    atomic_ulong tail;          // Bytes ever written out by the writer thread.
+    atomic_bool stopping;       // Tells the writer thread to drain the ring and exit.
+    unsigned long dropped;      // Records discarded because the ring was full; used by the shell only.
+    int fd;                     // Trace file records are written to.
+    int wakeFd;                 // eventfd the shell signals when the writer may be asleep.
+    pthread_t writer;           // Thread that writes the ring out to fd.
+};
+
+/* Completion messages waiting to be printed together before the next prompt. */
+struct noticeQueue
+{
+    char *data;         // Stores the queued messages back to back.
+    size_t length;      // Bytes queued.
+    size_t capacity;    // Size of data; doubles as needed.
+};
+
+/* Buffers raw input until a full line is available. */
+struct inputReader
+{
+    char *data;         // Stores bytes read from stdin, the mapped script, or the -c string.
+    size_t capacity;    // Size of data when it is refilled from fd.
+    size_t start;       // Position of the first unconsumed byte.
+    size_t end;         // Position one past the last buffered byte.
+    int fd;             // File descriptor data is refilled from, or -1 when data holds all input.
+    bool eof;           // Indicates all input has been buffered.
+};
+
+/* Preprocessor directives for the history file and its index. */
+#define HISTORY_MAGIC 0x31687373    // Identifies an index file written by this shell.
+#define HISTORY_BUCKETS 4096        // Prefix chains per key length in the index (a power of two).
+#define HISTORY_KEYS 3              // Key lengths each entry is chained under; see historyKeys.
+#define HISTORY_GROW 16384          // Fewest entries added to the index file when it fills.
+
+/* Start of the index file, mapped shared by every shell using the same history. */
+struct historyHeader
+{
+    uint32_t magic;                     // HISTORY_MAGIC once the index is valid.
+    uint32_t buckets;                   // HISTORY_BUCKETS when the index was built.
+    uint64_t count;                     // Entries indexed; raised only after the entry is written.
+    uint64_t indexedBytes;              // Bytes of the history file covered by the entries.
+    uint32_t heads[HISTORY_KEYS][HISTORY_BUCKETS];  // Newest entry plus one in each prefix chain, or 0.
+};
+
+/* One line of the history file, as recorded after the header of the index file. */
+struct historyEntry
+{
+    uint64_t offset;    // Start of the line in the history file.
+    uint32_t length;    // Length of the line without its newline.
+    uint32_t previous[HISTORY_KEYS];    // Next older entry plus one with the same prefix key, or 0.
+};
+
+/* Append-only history file and its index, both memory-mapped. Changes happen under flock. */
+struct history
+{
+    int fd;                         // History file, opened for appending, or -1 when unavailable.
+    int indexFd;                    // Index file holding a historyHeader and the entries.
+    char *text;                     // History file mapped read-only.
+    size_t textSize;                // Bytes of the history file mapped.
+    struct historyHeader *header;   // Index file mapped shared.
+    size_t indexSize;               // Bytes of the index file mapped.
+};
+
+/* Preprocessor directives for the line editor. */
+#define PROMPT ": "         // Prompt shown when reading from a terminal.
+#define EDIT_START 256      // Initial room in each of the editor's buffers; doubles as needed.
+#define EDIT_READ 4096      // Keyboard bytes read at once, so a paste is handled in one redraw.
+#define ESCAPE_WAIT 50      // Milliseconds to wait for the rest of an escape sequence.
+#define LIST_LIMIT 400      // Most completions listed; beyond this only their number is shown.
+#define CTRL_KEY(c) ((c) & 0x1f)    // Byte a terminal sends for Ctrl held with a letter.
+#define EDIT_MORE 0         // The line is still being edited.
+#define EDIT_DONE 1         // Enter was pressed.
+#define EDIT_EOF 2          // ^D on an empty line, or the terminal closed.
+
+/* Preprocessor directives for keys that arrive as escape sequences. */
+#define KEY_PARTIAL -1      // An escape sequence whose other bytes have not arrived yet.
+#define KEY_EOF -2          // The terminal was closed.
+#define KEY_UP 256
+#define KEY_DOWN 257
+#define KEY_RIGHT 258
+#define KEY_LEFT 259
+#define KEY_HOME 260
+#define KEY_END 261
+#define KEY_DELETE 262
+#define KEY_WORD_LEFT 263   // Alt-b or Ctrl-Left.
+#define KEY_WORD_RIGHT 264  // Alt-f or Ctrl-Right.
+#define KEY_KILL_WORD 265   // Alt-d.
+#define KEY_RUBOUT_WORD 266 // Alt-Backspace.
+#define KEY_UNKNOWN 267     // Any other sequence, which is ignored.
+
+/* A growable run of bytes used by the line editor. */
+struct editBuffer
+{
+    char *data;         // Stores the bytes; not NUL-terminated.
+    size_t length;      // Bytes in use.
+    size_t capacity;    // Room in data.
+};
+
+/* Line being typed at the terminal, and what the screen shows of it, so only changes are redrawn. */
+struct lineEditor
+{
+    bool enabled;               // Indicates stdin and stdout are a terminal the editor can drive.
+    struct termios cooked;      // Terminal settings restored after each line.
+    struct editBuffer line;     // Text typed so far.
+    size_t cursor;              // Byte offset of the cursor in line.
+    struct editBuffer view;     // Prompt and line as they should appear.
+    size_t viewCursor;          // Byte offset of the cursor in view.
+    struct editBuffer shown;    // Prompt and line as the terminal shows them.
+    size_t screenCursor;        // Byte offset in shown of the terminal's cursor.
+    struct editBuffer out;      // Output gathered so each redraw is a single write.
+    struct editBuffer killed;   // Text removed by the latest kills, for yank.
+    bool killing;               // Indicates the previous key killed text, so the next kill joins it.
+    struct editBuffer draft;    // New line kept aside while history is browsed.
+    struct editBuffer pattern;  // Text searched for by ^R.
+    long browsing;              // History entry in line, or 0 for the new line.
+    long found;                 // Entry matched by ^R, or 0.
+    bool searching;             // Indicates a ^R search is under way.
+    int columns;                // Width of the terminal.
+    int lastKey;                // Previous key, so a second tab lists the matches.
+    char input[EDIT_READ];      // Keyboard bytes read and not yet handled.
+    size_t inputStart;          // First unhandled byte of input.
+    size_t inputEnd;            // One past the last byte read into input.
+};
+
+/* A directory's entry names, sorted, kept for completion until the directory's mtime changes. */
+struct dirListing
+{
+    char *path;                 // Directory as named when it was listed.
+    struct timespec mtime;      // Modification time when the names were read.
+    bool settled;               // Indicates mtime was at least a second old, so no change can hide behind it.
+    char *names;                // Stores the names back to back, each NUL-terminated.
+    size_t *offsets;            // Start of each name in names, in sorted order.
+    int count;                  // Counts names.
+    size_t capacity;            // Room in names.
+    int room;                   // Room in offsets.
+    struct dirListing *next;    // Next listing in the same bucket chain.
+};
+
+/* Names matching the word being completed; they live in cmdArena. */
+struct completion
+{
+    char **names;   // Stores each match.
+    int count;      // Counts matches.
+    int capacity;   // Room in names.
+};
+
+/* Global variables. */
+struct jobTable pidStack;       // Instantiates the jobTable.
+struct inputReader reader;      // Instantiates the inputReader for the shell's commands.
+struct commandTable cmdHash;    // Instantiates the commandTable.
+int childPipe[2];               // Self-pipe written by the child signal handler and drained by the main loop.
+volatile sig_atomic_t childPending = 0; // Set by the child signal handler so idle checks skip the self-pipe.
+bool interactive;               // Indicates commands come from a terminal, so a prompt is shown.
+struct parallelRun *activeRun = NULL;   // The "parallel" command waiting on its jobs, if any.
+int timingMode = TIME_OFF;      // Reports resource usage for every command when not TIME_OFF; set by -t or "timing".
+int cmdTimeFormat;              // How the current command line reports resource usage.
+struct rusage cmdUsage;         // Totals the resource usage of the current command line's children.
+int cmdUsageCount;              // Counts children added to cmdUsage.
+struct arena cmdArena;          // Instantiates the arena for the current command line.
+struct noticeQueue notices;     // Instantiates the noticeQueue for background completion messages.
+struct traceRing trace;         // Instantiates the traceRing for the -x option.
+bool tracing = false;           // Indicates every launch and reap is recorded in the trace.
+bool cmdBackground;             // Indicates the current command line runs in the background.
+volatile long long childSignalNs = 0;   // Time of the latest SIGCHLD, set by the child signal handler.
+char pidString[16];             // Holds the shell's pid for "$$" expansion.
+int foregroundValue;            // Indicates exit status or signal used to terminate.
+bool foregroundMode = false;    // Indicates when foreground mode is enabled. Initiated as disabled.
+bool spawnMode = true;          // Launches commands with posix_spawnp; the -f option selects fork() instead.
+struct workerPool pool;         // Instantiates the workerPool; the -z option turns it on.
+struct history hist = {-1, -1, NULL, 0, NULL, 0};   // Instantiates the history; opened on first use.
+struct variableTable vars;      // Instantiates the variableTable.
+pid_t lastBackground = 0;       // Holds the pid of the latest background command for "$!".
+int lastBackgroundValue = -1;   // Wait status of lastBackground once reaped, so "wait $!" still finds it; -1 until then.
+extern char **environ;          // Environment handed to spawned commands.
+struct lineEditor editor;       // Instantiates the lineEditor for terminal input.
+struct dirListing *dirCache[HASH_BUCKETS];  // Directory listings for completion, chained by hashName of the path.
+volatile sig_atomic_t signalMessage = 0;    // Signal whose handler last printed a message, so the line is drawn again.
+struct job *jobList = NULL;     // Background and stopped jobs, the current job first.
+struct arena funcArena;         // Holds function bodies; never reset.
+struct function *functions[HASH_BUCKETS];   // Shell functions, chained by hashName.
+char **positional = NULL;       // Function or script name, then "$1" onward; NULL when there are none.
+int positionalNum = 0;          // Counts positional parameters after the name.
+int loopDepth = 0;              // Loops running in the current function, or outside any.
+int functionDepth = 0;          // Function calls running.
+int breakLevels = 0;            // Loops "break" or "continue" still has to leave.
+bool continuing = false;        // Indicates the last loop left by breakLevels goes on to its next pass.
+bool returning = false;         // Indicates "return" is leaving the current function.
+bool interrupted = false;       // Indicates ^C ended a command, so the loops around it stop.
+const char *prompt = PROMPT;    // Prompt being shown, CONTINUE_PROMPT while a command is unfinished.
+int captureFd = -1;             // memfd that builtins run by "$(...)" write to; kept for the next one.
+bool captureBusy = false;       // Indicates captureFd is in use, so a nested substitution needs its own.
+bool jobControl = false;        // Indicates jobs are handed the terminal; set for an interactive shell.
+pid_t shellPgid;                // Process group of the shell, given the terminal back after each job.
+struct termios shellModes;      // Terminal settings restored after each job.
+int deadlineLoop = -1;          // epoll instance watching every deadline's timerfd and pidfds; created on first use.
+int deadlineCount = 0;          // Deadlines being watched; waits are plain wait4 calls while there are none.
+double cmdTimeout;              // Seconds the current command line may run, or 0 for no deadline.
+int cmdTimeoutSignal;           // Signal sent when cmdTimeout passes.
+double cmdKillAfter;            // Seconds from that signal until SIGKILL, or 0 for never.
+struct limitSetting cmdLimits[LIMIT_MAX];   // Limits the current command line's children set before exec.
+int cmdLimitNum;                // Counts cmdLimits.
+
+/* Function declarations. */
+void* arenaAlloc(struct arena* pool, size_t size);
+void* arenaResize(struct arena* pool, void* ptr, size_t oldSize, size_t newSize);
+void arenaReset(struct arena* pool);
+struct arenaPosition arenaMark(struct arena* pool);
+void arenaRelease(struct arena* pool, struct arenaPosition mark);
+void initJobTable(int capacity);
+struct jobSlot* addBackPid(pid_t processId, struct job* job);
+bool removeBackPid(pid_t processId, struct jobSlot* removed);
+struct jobSlot* findBackPid(pid_t processId);
+void initJobControl();
+struct job* newJob(struct parsedInput** stages, int stageCount);
+void listJob(struct job* job);
+void dropJob(struct job* job);
+struct job* findJob(const char* spec, const char* name);
+bool endJobProcess(struct job* job, pid_t processId, int processValue);
+int waitJob(struct job* job, bool untraced);
+void foregroundJob(struct job* job);
+void jobsBuiltin(struct parsedInput* obj);
+void fgBuiltin(struct parsedInput* obj);
+void bgBuiltin(struct parsedInput* obj);
+void waitBuiltin(struct parsedInput* obj);
+int changeDir(char* path);
+unsigned int variableBucket(const char* name, size_t length);
+struct variable* findVariable(const char* name, size_t length, bool create);
+void initVariables();
+char* getVariable(const char* name);
+bool validName(const char* name, size_t length);
+void setVariable(const char* name, size_t length, const char* value);
+void exportVariable(struct variable* var);
+void removeEnv(struct variable* var);
+void unsetVariable(const char* name);
+size_t assignmentName(const char* word);
+void addArgument(struct parsedInput* obj, char* text);
+size_t plainLength(const char* text);
+void appendText(struct expansion* out, const char* text, size_t length);
+void endField(struct expansion* out);
+const char* expandParameter(char** readPtr, char* digits);
+char* expandWord(char* raw, struct parsedInput* fields);
+void addValue(struct expansion* out, const char* value, bool split);
+char* skipSubstitution(char* start);
+bool substituteCommand(char** readPtr, struct capture* output);
+bool runsInShell(struct node* tree);
+bool captureShell(struct node* tree, struct capture* output);
+bool captureChild(struct node* tree, struct capture* output);
+bool readCapture(int fd, struct capture* output);
+bool spillCapture(int pipeFd, int memfd, struct capture* output);
+void releaseCapture(struct capture* output);
+void enterSubshell();
+bool expandCommand(struct parsedInput* obj);
+bool runAssignments(struct parsedInput* obj);
+void exportBuiltin(struct parsedInput* obj);
+void unsetBuiltin(struct parsedInput* obj);
+int lexOperator(struct lexer* lex, struct token* tok, char* read, char c, int fd);
+char* removeQuotes(char* start, char* end);
+int nextToken(struct lexer* lex, struct token* tok);
+void advance(struct parser* p);
+char* readMore();
+bool isKeyword(struct parser* p, const char* keyword);
+bool expectKeyword(struct parser* p, const char* keyword);
+struct node* syntaxError(struct parser* p, const char* expected);
+void skipNewlines(struct parser* p);
+struct node* newNode(int kind);
+struct parsedInput* parseSimple(struct parser* p);
+struct node* parsePipeline(struct parser* p);
+struct node* parseAndOr(struct parser* p);
+bool endsList(struct parser* p);
+struct node* parseList(struct parser* p, bool top);
+struct node* parseBody(struct parser* p, const char* opener, const char* closer);
+struct node* parseIf(struct parser* p);
+struct node* parseFor(struct parser* p);
+struct node* parseCompound(struct parser* p);
+struct node* parseLine(char* inputBuffer, bool* failed);
+struct node* parseSubstitution(char* text, bool* failed);
+bool unwinding();
+bool loopDone();
+void runList(struct node* list);
+void runNode(struct node* node);
+void runCommand(struct node* node);
+void runLoop(struct node* node);
+void runFor(struct node* node);
+char* copyText(const char* text);
+struct parsedInput* copyCommand(struct parsedInput* obj);
+struct node* copyNode(struct node* node);
+struct function* findFunction(const char* name);
+void defineFunction(struct node* node);
+void runFunction(struct function* func, struct parsedInput* obj);
+void loopBuiltin(struct parsedInput* obj);
+void returnBuiltin(struct parsedInput* obj);
+int redirectIO(struct parsedInput* obj, int* base, struct fdPlan* plan);
+void closePlan(struct fdPlan* plan);
+unsigned int hashName(const char* name);
+char* searchPath(const char* name);
+char* lookupCommand(const char* name);
+void forgetCommand(const char* name);
+void clearHash();
+void hashBuiltin(struct parsedInput* obj);
+void initBuiltins();
+const struct builtinCommand* findBuiltin(const char* name);
+bool runBuiltin(struct parsedInput* obj);
+bool redirectShell(struct parsedInput* obj, int* saved);
+void restoreShell(int* saved);
+void exitBuiltin(struct parsedInput* obj);
+void cdBuiltin(struct parsedInput* obj);
+void statusBuiltin(struct parsedInput* obj);
+void trueBuiltin(struct parsedInput* obj);
+void falseBuiltin(struct parsedInput* obj);
+void pwdBuiltin(struct parsedInput* obj);
+const char* printEscape(const char* text, bool* stop);
+void echoBuiltin(struct parsedInput* obj);
+bool printfNumber(const char* text, char conversion, long long* integer, double* real);
+void printfBuiltin(struct parsedInput* obj);
+int testNumber(const char* text, long long* value);
+bool isUnaryTest(const char* op);
+bool isBinaryTest(const char* op);
+int unaryTest(const char* op, const char* operand);
+int binaryTest(const char* left, const char* op, const char* right);
+int parseTest(char** args, int count, int* pos, int level);
+int evalTest(char** args, int count);
+void testBuiltin(struct parsedInput* obj);
+pid_t spawnChild(char* path, char** argList, int* fds, pid_t pgid);
+pid_t forkChild(char* path, char** argList, int* fds, pid_t pgid);
+void startHelper();
+void runHelper(int control);
+void fillPool();
+void restartPool();
+void runWorker(int sock);
+bool packString(char* message, size_t* length, const char* text);
+pid_t launchWorker(char* path, char** argList, int* fds, pid_t pgid);
+pid_t forkProcesses(struct parsedInput* obj, int* base, pid_t pgid);
+void runPipeline(struct parsedInput** stages, int stageCount);
+double secondsSince(struct timespec* start);
+void addUsage(struct rusage* usage);
+void printUsage(int format, pid_t processId, int processValue, double wall, struct rusage* usage, bool queued);
+int stripTimePrefix(struct parsedInput* obj);
+void timingBuiltin(struct parsedInput* obj);
+bool parseDuration(const char* text, double* seconds);
+int signalNumber(const char* text);
+int parseTimeout(char** args, int count);
+int parseLimits(char** args, int count, struct limitSetting* settings, int* settingNum, bool* all);
+bool stripJobPrefixes(struct parsedInput* obj);
+bool applyLimits(struct limitSetting* settings, int count);
+void printLimit(struct limitSetting* setting, bool labelled);
+void ulimitBuiltin(struct parsedInput* obj);
+void startDeadline(struct job* job);
+void armTimer(int timerFd, double seconds);
+void checkDeadlines();
+void expireDeadline(struct deadline* deadline);
+void retireDeadline(struct deadline* deadline);
+pid_t waitChild(pid_t processId, int* processValue, int options, struct rusage* usage);
+long long monotonicNs();
+void startTrace(const char* path);
+void stopTrace();
+void* traceWriter(void* unused);
+bool traceWrite(const char* record, size_t length);
+void tracePublish(const char* record, size_t length);
+size_t jsonString(char* out, size_t room, const char* text);
+void traceLaunch(struct parsedInput* obj, pid_t processId, long long spawnNs, long long execNs);
+void traceReap(pid_t processId, int processValue, long long reapNs);
+int compareNs(const void* a, const void* b);
+void printLatency(const char* label, long long* samples, int count);
+long long jsonNumber(const char* line, const char* key);
+int analyzeTrace(const char* path);
+int readItems(int fd, char*** items);
+bool finishParallelJob(pid_t processId, int processValue, struct rusage* usage);
+void parallelBuiltin(struct parsedInput* obj);
+void trapStopSig(int sig);
+void trapChildSig(int sig);
+void trapTermSig(int sig);
+void endProcess();
+void testBackMode();
+bool reapBackground();
+void queueNotice(const char* format, ...);
+void flushNotices();
+void openInput(int argc, char *argv[], char* command);
+char* readLine();
+void initEditor();
+void reserveBuffer(struct editBuffer* buf, size_t length);
+void insertText(struct editBuffer* buf, size_t at, const char* text, size_t length);
+void eraseText(struct editBuffer* buf, size_t at, size_t length);
+void editorPrintf(const char* format, ...);
+void writeEditor();
+size_t textColumns(const char* text, size_t length);
+void moveCursor(size_t from, size_t to);
+void refreshLine();
+void leaveLine();
+int decodeKey(const char* data, size_t length, size_t* used);
+int readKey();
+size_t previousChar(size_t at);
+size_t nextChar(size_t at);
+size_t wordStart(size_t at);
+size_t wordEnd(size_t at);
+void killText(size_t start, size_t end);
+void setLine(const char* text, size_t length);
+bool startBrowsing();
+void browseHistory(int direction);
+bool searchKey(int key);
+int compareEntries(const void* a, const void* b, void* text);
+struct dirListing* listDirectory(const char* path);
+void addMatches(struct dirListing* listing, const char* prefix, size_t length, struct completion* found);
+void addCompletion(struct completion* found, char* name);
+int compareNames(const void* a, const void* b);
+void insertEscaped(const char* text, size_t length);
+void listCompletions(struct completion* found);
+void completeWord(bool list);
+int handleKey(int key);
+char* editLine();
+bool openHistory();
+void mapHistory();
+void syncHistory();
+unsigned int historyBucket(const char* text, size_t length, int key);
+void indexHistory(uint64_t offset, uint32_t length);
+void addHistory(const char* line);
+char* historyLine(long number, size_t* length);
+long findHistory(const char* prefix, size_t length);
+long searchHistory(const char* text, size_t length, long before);
+char* expandHistory(char* line);
+void historyBuiltin(struct parsedInput* obj);
+int exitValue();
+int statusValue(int processValue);
+
+/* Builtin commands. "parallel" applies its own redirections. */
+const struct builtinCommand builtins[] = {
+    {"exit", exitBuiltin, false, false},
+    {"cd", cdBuiltin, false, false},
+    {"status", statusBuiltin, true, true},
+    {"hash", hashBuiltin, true, false},
+    {"parallel", parallelBuiltin, false, false},
+    {"timing", timingBuiltin, true, false},
+    {"echo", echoBuiltin, true, true},
+    {"printf", printfBuiltin, true, true},
+    {"true", trueBuiltin, true, true},
+    {"false", falseBuiltin, true, true},
+    {"test", testBuiltin, true, true},
+    {"[", testBuiltin, true, true},
+    {"pwd", pwdBuiltin, true, true},
+    {"history", historyBuiltin, true, true},
+    {"export", exportBuiltin, true, false},
+    {"unset", unsetBuiltin, true, false},
+    {"jobs", jobsBuiltin, true, true},
+    {"fg", fgBuiltin, false, false},
+    {"bg", bgBuiltin, true, false},
+    {"wait", waitBuiltin, false, false},
+    {"break", loopBuiltin, false, false},
+    {"continue", loopBuiltin, false, false},
+    {"return", returnBuiltin, false, false},
+    {"ulimit", ulimitBuiltin, true, false}
+};
+
+/* Resources "ulimit" knows, in the order "ulimit -a" lists them. */
+const struct limitOption limitOptions[LIMIT_MAX] = {
+    {'c', RLIMIT_CORE, 1024, "core file size (blocks)"},
+    {'d', RLIMIT_DATA, 1024, "data seg size (kbytes)"},
+    {'f', RLIMIT_FSIZE, 1024, "file size (blocks)"},
+    {'n', RLIMIT_NOFILE, 1, "open files"},
+    {'s', RLIMIT_STACK, 1024, "stack size (kbytes)"},
+    {'t', RLIMIT_CPU, 1, "cpu time (seconds)"},
+    {'u', RLIMIT_NPROC, 1, "max user processes"},
+    {'v', RLIMIT_AS, 1024, "virtual memory (kbytes)"}
+};
+
+/* Leading bytes of a history line hashed for each of its prefix chains, shortest first. */
+const size_t historyKeys[HISTORY_KEYS] = {2, 4, 8};
+
+/* Redirection operators as written, indexed by the REDIR_ constants. */
+const char *redirectOperators[] = {"<", ">", ">>", "&>", ">&", "<<<"};
+const struct builtinCommand *builtinTable[HASH_BUCKETS];    // Open-addressed lookup table for builtins, filled at startup.
+
+
+int main(int argc, char *argv[])
+{
+    char *inputBuffer;              // Stores input from stdio.
+    struct node *tree;              // Commands parsed from the line.
+    bool failed;                    // Indicates the line had a syntax error.
+    int option;                     // Stores each command line option.
+    char *tracePath = NULL;         // Stores the trace file given with -x.
+    bool workers = false;           // Indicates -z asked for pre-forked workers.
+    char *command = NULL;           // Stores the commands given with -c.
+
+    /* Chooses how commands are launched and where they are read from. */
+    while((option = getopt(argc, argv, "+fztc:x:A:")) != -1){
+        if(option == 'f'){
+            spawnMode = false;  // Falls back to plain fork() and execvp().
+        }
+        else if(option == 'z'){
+            workers = true;     // Launches on pre-forked workers.
+        }
+        else if(option == 't'){
+            timingMode = TIME_HUMAN;    // Reports resource usage after every command.
+        }
+        else if(option == 'c'){
+            command = optarg;   // Runs the given commands instead of reading input.
+        }
+        else if(option == 'x'){
+            tracePath = optarg; // Records every launch and reap as JSON lines.
+        }
+        else if(option == 'A'){
+            exit(analyzeTrace(optarg)); // Summarizes a trace written by -x instead of running commands.
+        }
+        else{
+            fprintf(stderr, "usage: %s [-f] [-z] [-t] [-x tracefile] [-c command | script]\n       %s -A tracefile\n", argv[0], argv[0]);
+            exit(1);
+        }
+    }
+    openInput(argc, argv, command);
+    if(command == NULL && optind < argc){
+        positional = argv + optind;     // A script's name and arguments.
+        positionalNum = argc - optind - 1;
+    }
+
+    initVariables();                // Creates table of shell variables from the environment.
+    initJobTable(JOB_TABLE_START);  // Creates table of background process ID's.
+    initBuiltins();                 // Creates table of commands run inside the shell.
+    sprintf(pidString, "%d", (int)getpid());    // Stores the pid once for "$$" expansion.
+    if(interactive == true){
+        initJobControl();   // Takes the terminal before the helper is forked into the shell's group.
+    }
+
+    if(workers == true){
+        startHelper();  // Forks the helper before anything else makes the shell larger.
+    }
+    if(tracePath != NULL){
+        startTrace(tracePath);
+    }
+    if(interactive == true){
+        openHistory();  // Records and expands the commands typed at the terminal.
+    }
+
+    /* Creates the self-pipe used to learn about ended children without racing the prompt. */
+    if(pipe2(childPipe, O_NONBLOCK | O_CLOEXEC) != 0){
+        perror("pipe2");
+        exit(1);
+    }
+
+    /* Initializes Stop signal. */
+    struct sigaction StopSignal;
+    StopSignal.sa_handler = trapStopSig;
+    sigemptyset(&StopSignal.sa_mask);
+    StopSignal.sa_flags = 0;
+
+    /* Initializes Terminate signal. */
+    struct sigaction TermSignal;
+    TermSignal.sa_handler = trapTermSig;
+    sigemptyset(&TermSignal.sa_mask);
+    TermSignal.sa_flags = 0;
+
+    /* Initializes Child signal. Restarts interrupted calls so a foreground wait is not cut short. */
+    struct sigaction ChildSignal;
+    ChildSignal.sa_handler = trapChildSig;
+    sigemptyset(&ChildSignal.sa_mask);
+    ChildSignal.sa_flags = SA_RESTART;
+
+    /* Installs signal handlers once; they stay in place for the life of the shell. */
+    sigaction(SIGCHLD, &ChildSignal, NULL);
+    sigaction(SIGTSTP, &StopSignal, NULL);
+    sigaction(SIGINT, &TermSignal, NULL);
+
+    /* Loop manages background notifications, shell built-ins, and prompt for command line. */  
+    do
+    {
+        if(childPending){
+            reapBackground();   // Collects any background processes that ended since the last prompt.
+        }
+        flushNotices();     // Prints their messages together, right before the prompt.
+        fillPool();         // Picks up workers the helper made while the last command ran.
+
+        testBackMode();   // If a stop signal is caught, the foreground mode is switched.
+
+        /* Prints a colon as the prompt when reading from a terminal. */
+        if(interactive == true){
+            printf(PROMPT);
+            fflush(stdout);
+        }
+        arenaReset(&cmdArena);  // Releases everything parsed from the previous line at once.
+        inputBuffer = readLine();   // Gets user input to command line.
+        if(inputBuffer == NULL){
+            endProcess();   // Treats end of input like the "exit" command.
+            exit(exitValue());
+        }
+        if(interactive == true){
+            inputBuffer = expandHistory(inputBuffer);   // Replaces "!!", "!n" and the other events.
+            if(inputBuffer == NULL){
+                foregroundValue = 1 << 8;
+                continue;
+            }
+            addHistory(inputBuffer);
+        }
+
+        /* Builds the tree for the line, then runs it; blank lines and comments produce none. */
+        tree = parseLine(inputBuffer, &failed);
+        if(failed == true){
+            foregroundValue = 2 << 8;   // Reports exit value 2 for a syntax error.
+            continue;
+        }
+        signalMessage = 0;
+        interrupted = false;
+        runList(tree);
+    } while(true);
+
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: void* arenaAlloc(struct arena* pool, size_t size)
+ * Description: Hands out memory from the arena by bumping an
+ *              offset. A new block is only requested from malloc
+ *              when no block kept from earlier lines has room.
+ * Arguments: A pointer to an arena struct and the size in bytes.
+ * Returns: Memory aligned for any type.
+ *******************************************************************/
+void* arenaAlloc(struct arena* pool, size_t size)
+{
+    struct arenaBlock *block;
+    size_t offset = (pool->used + 15) & ~(size_t)15;   // Aligns each allocation to 16 bytes.
+
+    if(pool->current == NULL || offset + size > pool->current->size){
+        block = (pool->current != NULL) ? pool->current->next : pool->head;
+        if(block == NULL || block->size < size){
+            /* Adds a block after the current one, keeping any later blocks for reuse. */
+            block = malloc(sizeof(struct arenaBlock) + (size > ARENA_BLOCK ? size : ARENA_BLOCK));
+            if(block == NULL){
+                printf("Unable to allocate memory\n");
+                exit(1);
+            }
+            block->size = (size > ARENA_BLOCK) ? size : ARENA_BLOCK;
+            if(pool->current != NULL){
+                block->next = pool->current->next;
+                pool->current->next = block;
+            }
+            else{
+                block->next = pool->head;
+                pool->head = block;
+            }
+        }
+        pool->current = block;
+        offset = 0;
+    }
+
+    pool->used = offset + size;
+    pool->last = pool->current->data + offset;
+    return pool->last;
+}
+
+
+/*******************************************************************
+ * Name: void* arenaResize(struct arena* pool, void* ptr,
+ *                         size_t oldSize, size_t newSize)
+ * Description: Grows or shrinks an allocation. The most recent
+ *              allocation changes size in place when its block has
+ *              room; anything else is copied to a new allocation.
+ * Arguments: A pointer to an arena struct, the allocation, and its
+ *            old and new sizes in bytes.
+ * Returns: The allocation, which may have moved.
+ *******************************************************************/
+void* arenaResize(struct arena* pool, void* ptr, size_t oldSize, size_t newSize)
+{
+    char *copy;
+    size_t offset;
+
+    if(ptr == pool->last){
+        offset = pool->last - pool->current->data;
+        if(offset + newSize <= pool->current->size){
+            pool->used = offset + newSize;
+            return ptr;
+        }
+    }
+    if(newSize <= oldSize){
+        return ptr;     // Leaves the rest unused until the next reset.
+    }
+    copy = arenaAlloc(pool, newSize);
+    memcpy(copy, ptr, oldSize);
+    return copy;
+}
+
+
+/*******************************************************************
+ * Name: void arenaReset(struct arena* pool)
+ * Description: Releases every allocation at once. Blocks are kept
+ *              so later lines allocate without calling malloc.
+ * Arguments: A pointer to an arena struct.
+ *******************************************************************/
+void arenaReset(struct arena* pool)
+{
+    pool->current = pool->head;
+    pool->used = 0;
+    pool->last = NULL;
+}
+
+
+/*******************************************************************
+ * Name: struct arenaPosition arenaMark(struct arena* pool)
+ * Description: Records how much of the arena is in use.
+ * Arguments: A pointer to an arena struct.
+ * Returns: The position to hand to arenaRelease.
+ *******************************************************************/
+struct arenaPosition arenaMark(struct arena* pool)
+{
+    struct arenaPosition mark = {pool->current, pool->used};
+
+    return mark;
+}
+
+
+/*******************************************************************
+ * Name: void arenaRelease(struct arena* pool,
+ *                         struct arenaPosition mark)
+ * Description: Releases everything handed out since the mark at
+ *              once, keeping the blocks for reuse, like a reset that
+ *              spares what came before.
+ * Arguments: A pointer to an arena struct and the position returned
+ *            by arenaMark.
+ *******************************************************************/
+void arenaRelease(struct arena* pool, struct arenaPosition mark)
+{
+    pool->current = mark.current;
+    pool->used = mark.used;
+    pool->last = NULL;  // Whatever came last is gone, so it can no longer be grown in place.
+}
+
+
+/*******************************************************************
+ * Name: void initJobTable(int capacity)
+ * Description: Allocates an empty job table with the given number
+ *              of slots and links every slot into the free-list.
+ * Arguments: An int for the number of slots (a power of two).
+ *******************************************************************/
+void initJobTable(int capacity)
+{
+    int i;  // Index for loop.
+
+    pidStack.slots = malloc(capacity * sizeof(struct jobSlot));
+    pidStack.buckets = malloc(capacity * sizeof(int));
+    if(pidStack.slots == NULL || pidStack.buckets == NULL){
+        printf("Unable to allocate job table\n");
+        exit(1);
+    }
+    for(i = 0; i < capacity; i++){
+        pidStack.slots[i].pid = -1;
+        pidStack.slots[i].next = i + 1;     // Chains each free slot to the following one.
+        pidStack.buckets[i] = -1;
+    }
+    pidStack.slots[capacity - 1].next = -1;
+    pidStack.capacity = capacity;
+    pidStack.backPidNum = 0;
+    pidStack.freeHead = 0;
+}
+
+
+/*******************************************************************
+ * Name: struct jobSlot* addBackPid(pid_t processId,
+ *                                  struct job* job)
+ * Description: Records a new background process, doubling the
+ *              table first when no free slot remains.
+ * Arguments: A pid_t for the process ID and a pointer to the job
+ *            it belongs to.
+ * Returns: The slot holding the process.
+ *******************************************************************/
+struct jobSlot* addBackPid(pid_t processId, struct job* job)
+{
+    struct jobSlot *oldSlots;   // Slots carried over when the table grows.
+    int oldCapacity;
+    int slot;                   // Slot taken from the free-list.
+    int bucket;                 // Bucket chain for the process ID.
+    int i;                      // Index for loop.
+
+    if(pidStack.freeHead == -1){
+        /* Rebuilds the table at twice the size and reinserts every process ID. */
+        oldSlots = pidStack.slots;
+        oldCapacity = pidStack.capacity;
+        free(pidStack.buckets);
+        initJobTable(oldCapacity * 2);
+        for(i = 0; i < oldCapacity; i++){
+            addBackPid(oldSlots[i].pid, oldSlots[i].job);
+        }
+        free(oldSlots);
+    }
+
+    slot = pidStack.freeHead;
+    pidStack.freeHead = pidStack.slots[slot].next;
+    bucket = processId & (pidStack.capacity - 1);
+
+    pidStack.slots[slot].pid = processId;
+    pidStack.slots[slot].next = pidStack.buckets[bucket];   // Pushes onto the front of the chain.
+    pidStack.slots[slot].job = job;
+    pidStack.buckets[bucket] = slot;
+    pidStack.backPidNum++;
+    return &pidStack.slots[slot];
+}
+
+
+/*******************************************************************
+ * Name: bool removeBackPid(pid_t processId, struct jobSlot* removed)
+ * Description: Removes the process ID if a prior background
+ *              process ends, returning its slot to the free-list.
+ * Arguments: A pid_t for the process ID and a pointer that receives
+ *            a copy of the slot, or NULL.
+ * Returns: True if the process ID was a background process.
+ *******************************************************************/
+bool removeBackPid(pid_t processId, struct jobSlot* removed)
+{
+    int *link;  // Link that points at the current slot in the chain.
+    int slot;
+
+    /* Walks the bucket chain to locate the process ID that ended. */
+    link = &pidStack.buckets[processId & (pidStack.capacity - 1)];
+    while(*link != -1){
+        slot = *link;
+        if(pidStack.slots[slot].pid == processId){
+            if(removed != NULL){
+                *removed = pidStack.slots[slot];
+            }
+            *link = pidStack.slots[slot].next;  // Unlinks the slot from its chain.
+            pidStack.slots[slot].pid = -1;
+            pidStack.slots[slot].next = pidStack.freeHead;
+            pidStack.freeHead = slot;
+            pidStack.backPidNum--;  // Decrements process ID count after pid is removed.
+            return true;
+        }
+        link = &pidStack.slots[slot].next;
+    }
+    return false;
+}
+
+
+/*******************************************************************
+ * Name: struct jobSlot* findBackPid(pid_t processId)
+ * Description: Looks up a background process without removing it.
+ * Arguments: A pid_t for the process ID.
+ * Returns: The slot holding the process, or NULL if there is none.
+ *******************************************************************/
+struct jobSlot* findBackPid(pid_t processId)
+{
+    int slot;
+
+    for(slot = pidStack.buckets[processId & (pidStack.capacity - 1)]; slot != -1; slot = pidStack.slots[slot].next){
+        if(pidStack.slots[slot].pid == processId){
+            return &pidStack.slots[slot];
+        }
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: void initJobControl()
+ * Description: Makes the interactive shell the leader of its own
+ *              process group and the terminal's foreground group,
+ *              so each job can be handed the terminal and taken
+ *              back. Waits, stopped, while started in the
+ *              background, as other shells do.
+ * Arguments: None.
+ *******************************************************************/
+void initJobControl()
+{
+    while(tcgetpgrp(STDIN_FILENO) != getpgrp()){
+        kill(-getpgrp(), SIGTTIN);  // Stops until brought to the foreground.
+    }
+    signal(SIGTTOU, SIG_IGN);   // Lets the shell take the terminal back from a job.
+    signal(SIGTTIN, SIG_IGN);
+    setpgid(0, 0);
+    shellPgid = getpgrp();
+    if(tcsetpgrp(STDIN_FILENO, shellPgid) != 0 || tcgetattr(STDIN_FILENO, &shellModes) != 0){
+        return;     // Runs without job control.
+    }
+    jobControl = true;
+}
+
+
+/*******************************************************************
+ * Name: struct job* newJob(struct parsedInput** stages,
+ *                          int stageCount)
+ * Description: Creates a job for a command line, with its text
+ *              rebuilt from the expanded commands for "jobs".
+ * Arguments: A pointer to the array of parsedInput pointers and an
+ *            int for the number of commands.
+ * Returns: The job, not yet in the job list.
+ *******************************************************************/
+struct job* newJob(struct parsedInput** stages, int stageCount)
+{
+    struct job *job = calloc(1, sizeof(struct job));
+    size_t length = 3;      // Room for " &" and the terminating NUL.
+    int i;      // Index for loop.
+    int j;
+
+    if(job == NULL){
+        printf("Unable to allocate memory\n");
+        exit(1);
+    }
+    for(i = 0; i < stageCount; i++){
+        for(j = 0; j < stages[i]->argNum; j++){
+            length += strlen(stages[i]->arguments[j]) + 3;
+        }
+    }
+    job->command = malloc(length);
+    job->pids = malloc(stageCount * sizeof(pid_t));
+    if(job->command == NULL || job->pids == NULL){
+        printf("Unable to allocate memory\n");
+        exit(1);
+    }
+    job->command[0] = '\0';
+    for(i = 0; i < stageCount; i++){
+        for(j = 0; j < stages[i]->argNum; j++){
+            if(i > 0 || j > 0){
+                strcat(job->command, (j == 0) ? " | " : " ");
+            }
+            strcat(job->command, stages[i]->arguments[j]);
+        }
+    }
+    if(stages[stageCount - 1]->backMode == true && foregroundMode == false){
+        strcat(job->command, " &");
+    }
+    job->timeFormat = cmdTimeFormat;
+    clock_gettime(CLOCK_MONOTONIC, &job->started);
+    return job;
+}
+
+
+/*******************************************************************
+ * Name: void listJob(struct job* job)
+ * Description: Puts a job at the front of the job list, making it
+ *              the current job, "%+". A job new to the list gets
+ *              the number after the highest in use.
+ * Arguments: A pointer to a job struct.
+ *******************************************************************/
+void listJob(struct job* job)
+{
+    struct job **link;
+
+    if(job->number == 0){
+        job->number = 1;
+        for(link = &jobList; *link != NULL; link = &(*link)->next){
+            if((*link)->number >= job->number){
+                job->number = (*link)->number + 1;
+            }
+        }
+    }
+    else{
+        for(link = &jobList; *link != job; link = &(*link)->next){
+        }
+        *link = job->next;  // Unlinks the job before moving it to the front.
+    }
+    job->next = jobList;
+    jobList = job;
+}
+
+
+/*******************************************************************
+ * Name: void dropJob(struct job* job)
+ * Description: Removes a finished job from the job list, if it is
+ *              there, and frees it.
+ * Arguments: A pointer to a job struct.
+ *******************************************************************/
+void dropJob(struct job* job)
+{
+    struct job **link;
+
+    for(link = &jobList; *link != NULL; link = &(*link)->next){
+        if(*link == job){
+            *link = job->next;
+            break;
+        }
+    }
+    if(job->deadline != NULL){
+        retireDeadline(job->deadline);
+    }
+    free(job->command);
+    free(job->pids);
+    free(job);
+}
+
+
+/*******************************************************************
+ * Name: struct job* findJob(const char* spec, const char* name)
+ * Description: Finds the job a job spec names: "%n" or a bare n by
+ *              number, "%%", "%+" or nothing for the current job,
+ *              "%-" for the previous one, and "%text" for the job
+ *              whose command starts with text.
+ * Arguments: Pointer to char for the spec, or NULL, and pointer to
+ *            char for the builtin's name, used in the error.
+ * Returns: The job, or NULL after printing why none matched.
+ *******************************************************************/
+struct job* findJob(const char* spec, const char* name)
+{
+    struct job *job = jobList;
+    int number = 0;
+
+    if(spec != NULL && spec[0] == '%'){
+        spec++;
+    }
+    if(spec == NULL || strcmp(spec, "") == 0 || strcmp(spec, "%") == 0 || strcmp(spec, "+") == 0){
+        if(job == NULL){
+            printf("%s: no current job\n", name);
+        }
+        return job;
+    }
+    if(strcmp(spec, "-") == 0){
+        job = (job != NULL && job->next != NULL) ? job->next : job;
+        if(job == NULL){
+            printf("%s: no previous job\n", name);
+        }
+        return job;
+    }
+    if(isdigit((unsigned char)spec[0])){
+        number = atoi(spec);
+    }
+    for(; job != NULL; job = job->next){
+        if((number > 0 && job->number == number)
+                || (number == 0 && strncmp(job->command, spec, strlen(spec)) == 0)){
+            return job;
+        }
+    }
+    printf("%s: %s: no such job\n", name, spec);
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: bool endJobProcess(struct job* job, pid_t processId,
+ *                          int processValue)
+ * Description: Records that one of a job's processes was reaped.
+ *              The last command's status becomes the job's.
+ * Arguments: A pointer to a job struct, a pid_t for the process ID
+ *            and an int for its wait status.
+ * Returns: True once every process of the job has ended.
+ *******************************************************************/
+bool endJobProcess(struct job* job, pid_t processId, int processValue)
+{
+    int i;  // Index for loop.
+
+    for(i = 0; i < job->pidNum; i++){
+        if(job->pids[i] == processId){
+            job->pids[i] = -1;
+            job->running--;
+        }
+    }
+    if(processId == job->lastPid){
+        job->lastValue = processValue;
+        if(job->timedOut == true && !(WIFSIGNALED(processValue) && WTERMSIG(processValue) == SIGKILL)){
+            job->lastValue = TIMEOUT_STATUS << 8;   // A job that needed SIGKILL reports 137 instead, as timeout(1) does.
+        }
+        if(processId == lastBackground){
+            lastBackgroundValue = job->lastValue;
+        }
+    }
+    return job->running == 0;
+}
+
+
+/*******************************************************************
+ * Name: int waitJob(struct job* job, bool untraced)
+ * Description: Waits for every process of a job to end, reaping
+ *              each one so it is not reported as a background
+ *              process. A ^C typed at the shell ends the wait.
+ * Arguments: A pointer to a job struct, and a bool, true to return
+ *            as soon as the job is stopped.
+ * Returns: JOB_DONE, JOB_STOPPED, or JOB_RUNNING after a ^C.
+ *******************************************************************/
+int waitJob(struct job* job, bool untraced)
+{
+    struct rusage usage;    // Resource usage of each child, from wait4.
+    pid_t result;
+    int processValue;
+    int i;  // Index for loop.
+
+    for(i = 0; i < job->pidNum; i++){
+        if(job->pids[i] == -1){
+            continue;   // Not started, or already reaped.
+        }
+        result = waitChild(job->pids[i], &processValue, untraced ? WUNTRACED : 0, &usage);
+        if(result < 0 && errno == EINTR){
+            if(signalMessage == SIGINT && untraced == false){
+                return JOB_RUNNING;
+            }
+            i--;    // Waits for the same process again.
+            continue;
+        }
+        if(result <= 0){
+            endJobProcess(job, job->pids[i], 1 << 8);   // Someone else reaped it.
+            continue;
+        }
+        if(WIFSTOPPED(processValue)){
+            if(jobControl == true && (WSTOPSIG(processValue) == SIGTTIN || WSTOPSIG(processValue) == SIGTTOU)){
+                kill(-job->pgid, SIGCONT);  // Read the terminal before it was handed over; carries on.
+                i--;
+                continue;
+            }
+            job->stopped = true;
+            return JOB_STOPPED;
+        }
+        if(tracing == true){
+            traceReap(result, processValue, monotonicNs());
+        }
+        addUsage(&usage);
+        removeBackPid(result, NULL);
+        endJobProcess(job, result, processValue);
+    }
+    return JOB_DONE;
+}
+
+
+/*******************************************************************
+ * Name: void foregroundJob(struct job* job)
+ * Description: Gives the terminal to a job, waits for it, and takes
+ *              the terminal back with the shell's own settings. A
+ *              job that stops joins the job list with its terminal
+ *              settings kept for "fg"; one that ends is freed and
+ *              its status becomes the shell's.
+ * Arguments: A pointer to a job struct whose processes have been
+ *            launched or continued.
+ *******************************************************************/
+void foregroundJob(struct job* job)
+{
+    int state;
+    int i;  // Index for loop.
+
+    if(jobControl == true && job->pgid > 0){
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+    state = waitJob(job, true);
+    if(jobControl == true && job->pgid > 0){
+        if(state == JOB_STOPPED){
+            tcgetattr(STDIN_FILENO, &job->modes);
+            job->modesSaved = true;
+        }
+        tcsetpgrp(STDIN_FILENO, shellPgid);
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &shellModes);
+    }
+
+    if(state == JOB_STOPPED){
+        listJob(job);
+        printf("\n[%d]+  Stopped                 %s\n", job->number, job->command);
+        foregroundValue = (128 + SIGTSTP) << 8;     // Reports exit value 148, as other shells do.
+        for(i = 0; i < job->pidNum; i++){
+            if(job->pids[i] != -1){
+                addBackPid(job->pids[i], job);  // Reaped later like any background process.
+            }
+        }
+        return;
+    }
+    foregroundValue = job->lastValue;
+    if(job->lastPid == -1){
+        foregroundValue = 1 << 8;   // Reports exit value 1 when the last command could not start.
+    }
+    else if(jobControl == true && WIFSIGNALED(job->lastValue) && WTERMSIG(job->lastValue) != SIGPIPE){
+        printf("\nterminated by signal %d\n", WTERMSIG(job->lastValue));   // The shell itself did not see the ^C.
+    }
+    dropJob(job);
+}
+
+
+/*******************************************************************
+ * Name: void jobsBuiltin(struct parsedInput* obj)
+ * Description: Handles "jobs [-p]" by listing background and
+ *              stopped jobs, oldest first, with '+' on the current
+ *              job and '-' on the previous one. With -p only each
+ *              job's process group ID is printed.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void jobsBuiltin(struct parsedInput* obj)
+{
+    struct job *job;
+    struct job *printed = NULL;     // Last job printed; jobs are printed in order of number.
+    struct job *next;
+    bool pgidOnly = (obj->argNum > 1 && strcmp(obj->arguments[1], "-p") == 0);
+
+    if(childPending){
+        reapBackground();   // Leaves out jobs that have just finished.
+    }
+    while(true){
+        next = NULL;
+        for(job = jobList; job != NULL; job = job->next){
+            if((printed == NULL || job->number > printed->number) && (next == NULL || job->number < next->number)){
+                next = job;
+            }
+        }
+        if(next == NULL){
+            break;
+        }
+        if(pgidOnly == true){
+            printf("%d\n", (int)next->pgid);
+        }
+        else{
+            printf("[%d]%c  %-24s%s\n", next->number,
+                   (next == jobList) ? '+' : (jobList != NULL && next == jobList->next) ? '-' : ' ',
+                   (next->stopped == true) ? "Stopped" : "Running", next->command);
+        }
+        printed = next;
+    }
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: void fgBuiltin(struct parsedInput* obj)
+ * Description: Handles "fg [job]" by continuing a job in the
+ *              foreground, with the terminal and the settings it
+ *              had when it stopped.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void fgBuiltin(struct parsedInput* obj)
+{
+    struct job *job = findJob((obj->argNum > 1) ? obj->arguments[1] : NULL, "fg");
+    int i;  // Index for loop.
+
+    if(job == NULL){
+        foregroundValue = 1 << 8;
+        return;
+    }
+    printf("%s\n", job->command);
+    fflush(stdout);
+    for(i = 0; i < job->pidNum; i++){
+        if(job->pids[i] != -1){
+            removeBackPid(job->pids[i], NULL);  // Waited for here rather than reported later.
+        }
+    }
+    if(jobControl == true && job->modesSaved == true){
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &job->modes);
+    }
+    job->stopped = false;
+    kill(-job->pgid, SIGCONT);
+    foregroundJob(job);
+}
+
+
+/*******************************************************************
+ * Name: void bgBuiltin(struct parsedInput* obj)
+ * Description: Handles "bg [job]" by continuing a stopped job in
+ *              the background.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void bgBuiltin(struct parsedInput* obj)
+{
+    struct job *job = findJob((obj->argNum > 1) ? obj->arguments[1] : NULL, "bg");
+    size_t length;
+
+    if(job == NULL){
+        foregroundValue = 1 << 8;
+        return;
+    }
+    job->stopped = false;
+    kill(-job->pgid, SIGCONT);
+    length = strlen(job->command);
+    printf("[%d]+ %s%s\n", job->number, job->command,
+           (length > 2 && strcmp(job->command + length - 2, " &") == 0) ? "" : " &");   // A job started with '&' already shows it.
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: void waitBuiltin(struct parsedInput* obj)
+ * Description: Handles "wait [job | pid]". Waits for the given
+ *              job, or the job holding the given process, and takes
+ *              its status; "$!" keeps its status after it has been
+ *              reaped. With no argument waits for every running
+ *              background job and returns 0. A ^C stops waiting.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void waitBuiltin(struct parsedInput* obj)
+{
+    struct job *job = NULL;
+    struct job *next;
+    char *spec = (obj->argNum > 1) ? obj->arguments[1] : NULL;
+    pid_t processId;
+    int i;  // Index for loop.
+
+    signalMessage = 0;
+    foregroundValue = 0;
+    if(spec != NULL && spec[0] != '%'){
+        processId = atoi(spec);
+        for(job = jobList; job != NULL; job = job->next){
+            for(i = 0; i < job->pidNum && job->pids[i] != processId; i++){
+            }
+            if(i < job->pidNum || job->lastPid == processId){
+                break;
+            }
+        }
+        if(job == NULL && processId == lastBackground && lastBackgroundValue != -1){
+            foregroundValue = lastBackgroundValue;  // "$!" has already been reaped; its status is kept.
+            return;
+        }
+        if(job == NULL){
+            foregroundValue = 127 << 8;     // Not a child of this shell, or already reported.
+            return;
+        }
+    }
+    else if(spec != NULL){
+        job = findJob(spec, "wait");
+        if(job == NULL){
+            foregroundValue = 127 << 8;
+            return;
+        }
+    }
+
+    if(job != NULL){
+        if(job->stopped == true){
+            foregroundValue = (128 + SIGTSTP) << 8;     // A stopped job would never finish.
+            return;
+        }
+        if(waitJob(job, false) == JOB_RUNNING){
+            foregroundValue = (128 + SIGINT) << 8;
+            return;
+        }
+        foregroundValue = job->lastValue;
+        dropJob(job);
+        return;
+    }
+
+    while(true){
+        for(next = jobList; next != NULL && next->stopped == true; next = next->next){
+        }
+        if(next == NULL){
+            break;  // Every job has finished or is stopped.
+        }
+        if(waitJob(next, false) == JOB_RUNNING){
+            foregroundValue = (128 + SIGINT) << 8;
+            return;
+        }
+        dropJob(next);
+    }
+}
+
+
+/*******************************************************************
+ * Name: int changeDir(char* path)
+ * Description: Facilitates operations to change and navigate
+ *              from the working directory.
+ * Arguments: Pointer to char for the directory argument, or NULL
+ *            when none was given.
+ * Returns: 0 on success, or 1 when the directory was not found or
+ *          HOME is needed but not set.
+ *******************************************************************/
+int changeDir(char* path)
+{
+    char* homePath = getVariable("HOME"); // Gets path to home directory.
+    char *newPath;              // Stores string for name of specified directory path.
+    size_t size;
+
+    if(homePath == NULL && (path == NULL || strcmp(path, "~") == 0)){
+        printf("cd: HOME not set\n");
+        return 1;
+    }
+    if(path == NULL){
+        if(chdir(homePath) != 0){ // Returning anything but 0 means directory not found.
+            printf("Directory:%s not found.\n", homePath);
+            return 1;
+        }
+        return 0;
+    }
+
+    size = strlen(path) + (homePath != NULL ? strlen(homePath) : 0) + 1;
+    newPath = arenaAlloc(&cmdArena, size);  // Holds the longest path built below.
+
+    /* Directory commands. */
+    if(path[0] == '/'){
+        snprintf(newPath, size, "%s%s", (homePath != NULL) ? homePath : "", path); // Navigates to a specifed directory from home directory, or from the root without one.
+    }
+    else if(strcmp(path, "~") == 0){ // Navigates to home directory.
+        snprintf(newPath, size, "%s", homePath);
+    }
+    else{
+        snprintf(newPath, size, "%s", path); // Navigates to specified directory, including ".." and "./".
+    }
+    if(chdir(newPath) != 0){ // Handles a directory not found.
+        printf("Directory:%s not found.\n", newPath);
+        return 1;
+    }
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: unsigned int variableBucket(const char* name, size_t length)
+ * Description: Computes the bucket for a variable name.
+ * Arguments: Pointer to char for the name and its length.
+ *******************************************************************/
+unsigned int variableBucket(const char* name, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    size_t i;   // Index for loop.
+
+    for(i = 0; i < length; i++){
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash & (VAR_BUCKETS - 1);
+}
+
+
+/*******************************************************************
+ * Name: struct variable* findVariable(const char* name,
+ *                                     size_t length, bool create)
+ * Description: Looks a variable up by name, optionally adding it
+ *              unset when it is not in the table.
+ * Arguments: Pointer to char for the name, which need not be
+ *            terminated, its length, and whether to add it.
+ * Returns: The variable, or NULL if it is not in the table.
+ *******************************************************************/
+struct variable* findVariable(const char* name, size_t length, bool create)
+{
+    unsigned int bucket = variableBucket(name, length);
+    struct variable *var;
+
+    for(var = vars.buckets[bucket]; var != NULL; var = var->next){
+        if(strncmp(var->name, name, length) == 0 && var->name[length] == '\0'){
+            return var;
+        }
+    }
+    if(create == false){
+        return NULL;
+    }
+    var = malloc(sizeof(struct variable));
+    var->name = strndup(name, length);
+    var->entry = NULL;
+    var->value = NULL;
+    var->exported = false;
+    var->envIndex = -1;
+    var->next = vars.buckets[bucket];
+    vars.buckets[bucket] = var;
+    return var;
+}
+
+
+/*******************************************************************
+ * Name: void initVariables()
+ * Description: Fills the variable table from the environment the
+ *              shell was started with, and points environ at the
+ *              table's own array so every launch path and library
+ *              call sees the same, incrementally updated copy.
+ * Arguments: None.
+ *******************************************************************/
+void initVariables()
+{
+    struct variable *var;
+    char *equals;   // Separates each name from its value.
+    int i;          // Index for loop.
+
+    vars.envCapacity = ENV_START;
+    vars.envp = malloc((vars.envCapacity + 1) * sizeof(char*));
+    vars.owners = malloc(vars.envCapacity * sizeof(struct variable*));
+    vars.envCount = 0;
+    vars.envp[0] = NULL;
+
+    for(i = 0; environ[i] != NULL; i++){
+        equals = strchr(environ[i], '=');
+        if(equals == NULL){
+            continue;
+        }
+        var = findVariable(environ[i], equals - environ[i], true);
+        if(var->entry == NULL){     // Keeps the first of repeated names, as getenv does.
+            var->exported = true;
+            setVariable(environ[i], equals - environ[i], equals + 1);
+        }
+    }
+    environ = vars.envp;
+}
+
+
+/*******************************************************************
+ * Name: char* getVariable(const char* name)
+ * Description: Looks up the value of a shell variable.
+ * Arguments: Pointer to char for the name.
+ * Returns: The value, or NULL when the variable is unset.
+ *******************************************************************/
+char* getVariable(const char* name)
+{
+    struct variable *var = findVariable(name, strlen(name), false);
+
+    return (var != NULL) ? var->value : NULL;
+}
+
+
+/*******************************************************************
+ * Name: bool validName(const char* name, size_t length)
+ * Description: Tests whether text can name a variable: a letter or
+ *              underscore, then letters, digits and underscores.
+ * Arguments: Pointer to char for the name and its length.
+ *******************************************************************/
+bool validName(const char* name, size_t length)
+{
+    size_t i;   // Index for loop.
+
+    if(length == 0 || isdigit((unsigned char)name[0])){
+        return false;
+    }
+    for(i = 0; i < length; i++){
+        if(name[i] != '_' && !isalnum((unsigned char)name[i])){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void setVariable(const char* name, size_t length,
+ *                        const char* value)
+ * Description: Sets a shell variable. The value is stored as the
+ *              "NAME=value" entry itself, so an exported variable
+ *              only swaps one pointer in the environment array.
+ * Arguments: Pointer to char for the name, its length, and pointer
+ *            to char for the value.
+ *******************************************************************/
+void setVariable(const char* name, size_t length, const char* value)
+{
+    struct variable *var = findVariable(name, length, true);
+    size_t valueLength = strlen(value);
+    char *entry = malloc(length + valueLength + 2);
+
+    memcpy(entry, name, length);
+    entry[length] = '=';
+    memcpy(entry + length + 1, value, valueLength + 1);
+    free(var->entry);
+    var->entry = entry;
+    var->value = entry + length + 1;
+
+    if(var->envIndex != -1){
+        vars.envp[var->envIndex] = entry;
+        vars.generation++;
+    }
+    else if(var->exported == true){
+        exportVariable(var);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void exportVariable(struct variable* var)
+ * Description: Marks a variable for export and, once it has a
+ *              value, appends it to the environment array.
+ * Arguments: A pointer to a variable struct.
+ *******************************************************************/
+void exportVariable(struct variable* var)
+{
+    var->exported = true;
+    if(var->entry == NULL || var->envIndex != -1){
+        return;
+    }
+    if(vars.envCount == vars.envCapacity){
+        vars.envCapacity *= 2;
+        vars.envp = realloc(vars.envp, (vars.envCapacity + 1) * sizeof(char*));
+        vars.owners = realloc(vars.owners, vars.envCapacity * sizeof(struct variable*));
+        if(vars.envp == NULL || vars.owners == NULL){
+            printf("Unable to allocate memory\n");
+            exit(1);
+        }
+        environ = vars.envp;
+    }
+    vars.envp[vars.envCount] = var->entry;
+    vars.owners[vars.envCount] = var;
+    var->envIndex = vars.envCount++;
+    vars.envp[vars.envCount] = NULL;
+    vars.generation++;
+}
+
+
+/*******************************************************************
+ * Name: void removeEnv(struct variable* var)
+ * Description: Takes a variable out of the environment array by
+ *              moving the last entry into its place.
+ * Arguments: A pointer to a variable struct in the array.
+ *******************************************************************/
+void removeEnv(struct variable* var)
+{
+    int last = --vars.envCount;
+
+    vars.envp[var->envIndex] = vars.envp[last];
+    vars.owners[var->envIndex] = vars.owners[last];
+    vars.owners[var->envIndex]->envIndex = var->envIndex;
+    vars.envp[last] = NULL;
+    var->envIndex = -1;
+    vars.generation++;
+}
+
+
+/*******************************************************************
+ * Name: void unsetVariable(const char* name)
+ * Description: Removes a variable from the table and from the
+ *              environment.
+ * Arguments: Pointer to char for the name.
+ *******************************************************************/
+void unsetVariable(const char* name)
+{
+    struct variable **link = &vars.buckets[variableBucket(name, strlen(name))];
+    struct variable *var;
+
+    for(; (var = *link) != NULL; link = &var->next){
+        if(strcmp(var->name, name) == 0){
+            *link = var->next;
+            if(var->envIndex != -1){
+                removeEnv(var);
+            }
+            free(var->name);
+            free(var->entry);
+            free(var);
+            return;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: size_t assignmentName(const char* word)
+ * Description: Recognizes a word of the form NAME=value.
+ * Arguments: Pointer to char for the raw word.
+ * Returns: The length of NAME, or 0 if the word is not an
+ *          assignment.
+ *******************************************************************/
+size_t assignmentName(const char* word)
+{
+    size_t length = 0;
+
+    if(isdigit((unsigned char)*word)){
+        return 0;
+    }
+    while(word[length] == '_' || isalnum((unsigned char)word[length])){
+        length++;   // Stops at the first character that cannot be in a name.
+    }
+    return (length > 0 && word[length] == '=') ? length : 0;
+}
+
+
+/*******************************************************************
+ * Name: void addArgument(struct parsedInput* obj, char* text)
+ * Description: Appends a word to a command's argument list,
+ *              keeping the list NULL-terminated for exec.
+ * Arguments: A pointer to an parsedInput struct and pointer to char
+ *            for the word.
+ *******************************************************************/
+void addArgument(struct parsedInput* obj, char* text)
+{
+    if(obj->argNum == obj->argCapacity){
+        obj->arguments = arenaResize(&cmdArena, obj->arguments, (obj->argCapacity + 1) * sizeof(char*),
+                                     (2 * obj->argCapacity + 1) * sizeof(char*));
+        obj->argCapacity *= 2;
+    }
+    obj->arguments[obj->argNum++] = text;
+    obj->arguments[obj->argNum] = NULL;
+}
+
+
+/*******************************************************************
+ * Name: size_t plainLength(const char* text)
+ * Description: Counts the characters before the first quote,
+ *              backquote, backslash or '$'. A plain loop, as these
+ *              words are short and strcspn sets up a table on every
+ *              call.
+ * Arguments: Pointer to char for the text.
+ *******************************************************************/
+size_t plainLength(const char* text)
+{
+    size_t length = 0;
+
+    while(text[length] != '\0' && text[length] != '\'' && text[length] != '"'
+            && text[length] != '\\' && text[length] != '$' && text[length] != '`'){
+        length++;
+    }
+    return length;
+}
+
+
+/*******************************************************************
+ * Name: void appendText(struct expansion* out, const char* text,
+ *                       size_t length)
+ * Description: Adds text to the field being expanded, doubling its
+ *              room in cmdArena as needed.
+ * Arguments: A pointer to an expansion struct, pointer to char for
+ *            the text and its length.
+ *******************************************************************/
+void appendText(struct expansion* out, const char* text, size_t length)
+{
+    size_t newCapacity;
+
+    if(out->text == NULL){
+        out->capacity = length + FIELD_START;
+        out->text = arenaAlloc(&cmdArena, out->capacity);
+    }
+    else if(out->used + length + 1 > out->capacity){
+        newCapacity = (out->used + length + 1) * 2;
+        out->text = arenaResize(&cmdArena, out->text, out->capacity, newCapacity);
+        out->capacity = newCapacity;
+    }
+    memcpy(out->text + out->used, text, length);
+    out->used += length;
+}
+
+
+/*******************************************************************
+ * Name: void endField(struct expansion* out)
+ * Description: Finishes the field being expanded, adds it to the
+ *              command's arguments and starts an empty one, which is
+ *              only given room once text is added to it.
+ * Arguments: A pointer to an expansion struct.
+ *******************************************************************/
+void endField(struct expansion* out)
+{
+    if(out->text == NULL){
+        addArgument(out->fields, "");   // An empty field, as from "".
+    }
+    else{
+        out->text[out->used] = '\0';
+        out->text = arenaResize(&cmdArena, out->text, out->capacity, out->used + 1);  // Returns unused room to the arena.
+        addArgument(out->fields, out->text);
+    }
+    out->text = NULL;
+    out->capacity = 0;
+    out->used = 0;
+    out->started = false;
+}
+
+
+/*******************************************************************
+ * Name: const char* expandParameter(char** readPtr, char* digits)
+ * Description: Expands the parameter starting at the '$' under the
+ *              read pointer: "$$" gives the shell's pid, "$?" the
+ *              last exit value, "$!" the latest background pid,
+ *              "$1" to "$9" the positional parameters, "$#" their
+ *              count and "$@" or "$*" all of them joined by spaces,
+ *              and "$NAME" or "${NAME}" the variable's value.
+ * Arguments: A pointer to the read pointer, which is advanced past
+ *            the parameter, and pointer to char with room for a
+ *            number.
+ * Returns: The value, an empty string for unset variables, or NULL
+ *          for a bad "${...}".
+ *******************************************************************/
+const char* expandParameter(char** readPtr, char* digits)
+{
+    char *read = *readPtr + 1;  // Skips the '$'.
+    struct variable *var;
+    size_t length;
+    char special = *read;       // Names "$$", "$?", "$!" or a positional parameter, braced or not.
+    char *close;                // Closing brace of "${NAME}".
+    char *joined;               // Positional parameters joined for "$@".
+    int i;                      // Index for loop.
+
+    *readPtr = read + 1;
+    if(special == '{' && read[1] != '\0' && strchr("$?!#@*0123456789", read[1]) != NULL && read[2] == '}'){
+        special = read[1];
+        *readPtr = read + 3;
+    }
+    if(isdigit((unsigned char)special)){
+        if(special == '0'){
+            return (positional != NULL) ? positional[0] : "smallsh";
+        }
+        return (special - '0' <= positionalNum) ? positional[special - '0'] : "";
+    }
+    switch(special)
+    {
+        case '#':
+            sprintf(digits, "%d", positionalNum);
+            return digits;
+        case '@':
+        case '*':
+            for(length = 0, i = 1; i <= positionalNum; i++){
+                length += strlen(positional[i]) + 1;
+            }
+            joined = arenaAlloc(&cmdArena, length + 1);
+            joined[0] = '\0';
+            for(i = 1; i <= positionalNum; i++){
+                strcat(joined, positional[i]);
+                if(i < positionalNum){
+                    strcat(joined, " ");
+                }
+            }
+            return joined;
+        case '$':
+            return pidString;
+        case '?':
+            sprintf(digits, "%d", statusValue(foregroundValue));
+            return digits;
+        case '!':
+            if(lastBackground == 0){
+                return "";
+            }
+            sprintf(digits, "%d", (int)lastBackground);
+            return digits;
+        case '{':
+            read++;
+            close = strchr(read, '}');
+            if(close == NULL || validName(read, close - read) == false){
+                return NULL;
+            }
+            length = close - read;
+            *readPtr = read + length + 1;
+            break;
+        default:
+            for(length = 0; read[length] == '_' || isalnum((unsigned char)read[length]); length++){
+            }
+            *readPtr = read + length;
+            break;
+    }
+    var = findVariable(read, length, false);
+    return (var != NULL && var->value != NULL) ? var->value : "";   // Unset variables expand to nothing.
+}
+
+
+/*******************************************************************
+ * Name: void addValue(struct expansion* out, const char* value,
+ *                     bool split)
+ * Description: Adds a substituted value to the word being expanded.
+ *              Split at blanks, its first and last pieces join the
+ *              text around it and the others become fields of their
+ *              own; an empty value then adds nothing at all.
+ * Arguments: A pointer to an expansion struct, pointer to char for
+ *            the value, and a bool, true for an unquoted value
+ *            expanded into fields.
+ *******************************************************************/
+void addValue(struct expansion* out, const char* value, bool split)
+{
+    size_t length;
+
+    if(split == false){
+        appendText(out, value, strlen(value));
+        out->started = true;
+        return;
+    }
+    while(*value != '\0'){
+        for(length = 0; value[length] != '\0' && value[length] != ' ' && value[length] != '\t'
+                && value[length] != '\n'; length++){
+        }
+        if(length > 0){
+            appendText(out, value, length);
+            out->started = true;
+            value += length;
+        }
+        if(*value != '\0'){
+            if(out->started == true){
+                endField(out);
+            }
+            value += strspn(value, " \t\n");
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: char* expandWord(char* raw, struct parsedInput* fields)
+ * Description: Expands one raw word: removes quotes and
+ *              backslashes and substitutes parameters and the output
+ *              of "$(...)" and `...`. Unquoted substitutions are
+ *              split into fields at blanks, so a word can become
+ *              several arguments or none. Words with nothing to
+ *              expand are used as they are.
+ * Arguments: Pointer to char for the raw word, and a pointer to an
+ *            parsedInput struct that receives the fields, or NULL
+ *            to keep the word whole.
+ * Returns: The whole expanded word when fields is NULL; otherwise
+ *          any non-NULL value. NULL after printing a bad
+ *          substitution.
+ *******************************************************************/
+char* expandWord(char* raw, struct parsedInput* fields)
+{
+    struct expansion out;
+    char *read = raw;       // Next character to examine.
+    char *end;              // Closing single quote.
+    const char *value;      // Text substituted for a parameter.
+    struct capture output;  // Output substituted for a command.
+    char digits[24];        // Holds the text of "$?" and "$!".
+    char quote = '\0';      // Quote character currently open, if any.
+    size_t length;
+
+    length = plainLength(raw);
+    if(raw[length] == '\0'){
+        if(fields != NULL){
+            addArgument(fields, raw);
+        }
+        return raw;
+    }
+    out.capacity = strlen(raw) + FIELD_START;  // Leaves room for typical substitutions.
+    out.text = arenaAlloc(&cmdArena, out.capacity);
+    out.used = 0;
+    out.started = false;
+    out.fields = fields;
+    if(length > 0){
+        appendText(&out, read, length);     // Copies the plain text before the first special character.
+        out.started = true;
+        read += length;
+    }
+
+    while(*read != '\0'){
+        if(quote == '\''){
+            end = strchr(read, '\'');    // Takes everything up to the closing quote literally.
+            if(end == NULL){
+                end = read + strlen(read);
+            }
+            appendText(&out, read, end - read);
+            read = end;
+            if(*read == '\''){
+                quote = '\0';
+                read++;
+            }
+            continue;
+        }
+        if(*read == '\'' && quote == '\0'){
+            quote = '\'';
+            out.started = true;
+            read++;
+        }
+        else if(*read == '"'){
+            quote = (quote == '\0') ? '"' : '\0';
+            out.started = true;
+            read++;
+        }
+        else if(*read == '\\'){
+            if(read[1] != '\0' && (quote == '\0' || strchr("$\"\\`", read[1]) != NULL)){
+                read++;     // Keeps the escaped character literally.
+            }
+            appendText(&out, read++, 1);
+            out.started = true;
+        }
+        else if(*read == '`' || (*read == '$' && read[1] == '(')){
+            if(substituteCommand(&read, &output) == false){
+                return NULL;
+            }
+            addValue(&out, output.text, quote != '"' && fields != NULL);
+            releaseCapture(&output);
+        }
+        else if(*read == '$' && (read[1] == '\0'
+                || (strchr("$?!{_#@*", read[1]) == NULL && !isalnum((unsigned char)read[1])))){
+            appendText(&out, read++, 1);    // A '$' that starts no parameter is kept.
+            out.started = true;
+        }
+        else if(*read == '$'){
+            value = expandParameter(&read, digits);
+            if(value == NULL){
+                printf("bad substitution\n");
+                return NULL;
+            }
+            addValue(&out, value, quote != '"' && fields != NULL);
+        }
+        else if(*read == '\''){
+            appendText(&out, read++, 1);    // A single quote inside double quotes.
+        }
+        else{
+            length = plainLength(read);     // Copies plain text up to the next special character.
+            appendText(&out, read, length);
+            out.started = true;
+            read += length;
+        }
+    }
+
+    if(fields != NULL){
+        if(out.started == true){
+            endField(&out);
+        }
+        return raw;
+    }
+    out.text[out.used] = '\0';
+    return out.text;
+}
+
+
+/*******************************************************************
+ * Name: bool expandCommand(struct parsedInput* obj)
+ * Description: Runs the expansion stage over a copy of a parsed
+ *              command, replacing its raw words with the expanded
+ *              arguments and expanding redirection targets, all in
+ *              new arrays, so the parsed command can run again.
+ *              Assignments like "export A=$B" are not split.
+ *              Commands the lexer found nothing to expand in are
+ *              skipped outright.
+ * Arguments: A pointer to an parsedInput struct.
+ * Returns: False after printing a bad substitution.
+ *******************************************************************/
+bool expandCommand(struct parsedInput* obj)
+{
+    char **raw = obj->arguments;    // Words as written.
+    int rawCount = obj->argNum;
+    char *word;
+    int i;      // Index for loop.
+
+    if(obj->expand == false){
+        return true;    // Nothing to expand; keeps the words in place.
+    }
+    if(obj->redirectNum > 0){
+        obj->redirects = memcpy(arenaAlloc(&cmdArena, obj->redirectNum * sizeof(struct redirect)), obj->redirects,
+                                obj->redirectNum * sizeof(struct redirect));   // Leaves the parsed targets as written.
+        obj->redirectCapacity = obj->redirectNum;
+    }
+    for(i = 0; i < obj->redirectNum; i++){
+        obj->redirects[i].target = expandWord(obj->redirects[i].target, NULL);
+        if(obj->redirects[i].target == NULL){
+            return false;
+        }
+    }
+
+    obj->argCapacity = (rawCount > ARGS_START) ? rawCount : ARGS_START;
+    obj->arguments = arenaAlloc(&cmdArena, (obj->argCapacity + 1) * sizeof(char*));
+    obj->argNum = 0;
+    obj->arguments[0] = NULL;
+    for(i = 0; i < rawCount; i++){
+        if(assignmentName(raw[i]) > 0){
+            word = expandWord(raw[i], NULL);
+            if(word != NULL){
+                addArgument(obj, word);
+            }
+        }
+        else{
+            word = expandWord(raw[i], obj);
+        }
+        if(word == NULL){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool runAssignments(struct parsedInput* obj)
+ * Description: Handles a command made only of NAME=value words by
+ *              setting each shell variable in turn.
+ * Arguments: A pointer to an parsedInput struct, not yet expanded.
+ * Returns: False if the command is not only assignments.
+ *******************************************************************/
+bool runAssignments(struct parsedInput* obj)
+{
+    char *value;
+    size_t length;
+    int i;      // Index for loop.
+
+    for(i = 0; i < obj->argNum; i++){
+        if(assignmentName(obj->arguments[i]) == 0){
+            return false;
+        }
+    }
+    if(obj->argNum == 0){
+        return false;
+    }
+
+    foregroundValue = 0;
+    for(i = 0; i < obj->argNum; i++){
+        length = assignmentName(obj->arguments[i]);
+        value = expandWord(obj->arguments[i] + length + 1, NULL);
+        if(value == NULL){
+            if(interrupted == false){
+                foregroundValue = 1 << 8;
+            }
+            return true;
+        }
+        setVariable(obj->arguments[i], length, value);
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool substituteCommand(char** readPtr,
+ *                              struct capture* output)
+ * Description: Runs the "$(...)" or `...` under the read pointer and
+ *              captures its output, with trailing newlines removed.
+ *              A command made of one builtin that changes nothing,
+ *              like echo or printf, runs inside the shell; anything
+ *              else runs in a forked copy of it. Its status becomes
+ *              the foreground status, for "x=$(cmd)".
+ * Arguments: A pointer to the read pointer, which is advanced past
+ *            the substitution, and a pointer to a capture struct
+ *            that receives the output, to be given back with
+ *            releaseCapture.
+ * Returns: False after printing an error.
+ *******************************************************************/
+bool substituteCommand(char** readPtr, struct capture* output)
+{
+    char *start = *readPtr;
+    char *end = skipSubstitution(start);    // Closing ')' or backquote.
+    char *text;                             // The command, as its own string.
+    char *write;
+    struct node *tree;
+    bool failed;
+    bool captured;
+
+    output->text = "";
+    output->used = 0;
+    output->capacity = 0;
+    output->fd = -1;
+    output->mapped = false;
+    if(end == NULL){
+        printf("bad substitution\n");
+        return false;
+    }
+    *readPtr = end + 1;
+
+    /* Copies the command; within backquotes, "\`", "\$" and "\\" stand for the character itself. */
+    start += (*start == '`') ? 1 : 2;
+    text = arenaAlloc(&cmdArena, end - start + 1);
+    for(write = text; start < end; start++){
+        if(*end == '`' && *start == '\\' && strchr("`$\\", start[1]) != NULL){
+            start++;
+        }
+        *write++ = *start;
+    }
+    *write = '\0';
+
+    tree = parseSubstitution(text, &failed);
+    if(failed == true){
+        foregroundValue = 2 << 8;
+        return false;
+    }
+    captured = (runsInShell(tree) == true) ? captureShell(tree, output) : captureChild(tree, output);
+    if(captured == false){
+        releaseCapture(output);
+        return false;
+    }
+    while(output->used > 0 && output->text[output->used - 1] == '\n'){
+        output->used--;
+    }
+    if(output->used < output->capacity){
+        output->text[output->used] = '\0';
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool runsInShell(struct node* tree)
+ * Description: Decides whether a substitution can run inside the
+ *              shell: it must be one command, not in the background,
+ *              naming a builtin marked captured and not a function.
+ * Arguments: A pointer to the node struct of the substitution.
+ *******************************************************************/
+bool runsInShell(struct node* tree)
+{
+    const struct builtinCommand *command;
+    struct parsedInput *obj;
+
+    if(tree == NULL){
+        return true;    // "$()" runs nothing.
+    }
+    if(tree->next != NULL || tree->kind != NODE_PIPELINE || tree->stageCount != 1){
+        return false;
+    }
+    obj = tree->stages[0];
+    if(obj->argNum == 0 || obj->backMode == true || findFunction(obj->arguments[0]) != NULL){
+        return false;
+    }
+    command = findBuiltin(obj->arguments[0]);
+    return command != NULL && command->captured == true;
+}
+
+
+/*******************************************************************
+ * Name: bool captureShell(struct node* tree, struct capture* output)
+ * Description: Runs a substitution inside the shell with stdout on
+ *              a memfd, which, unlike a pipe, cannot fill up with
+ *              nobody reading it. The memfd is kept for the next
+ *              substitution; a nested one makes its own.
+ * Arguments: A pointer to the node struct of the substitution and a
+ *            pointer to a capture struct that receives its output.
+ * Returns: False after printing an error.
+ *******************************************************************/
+bool captureShell(struct node* tree, struct capture* output)
+{
+    int fd = captureFd;
+    int saved;          // The shell's own stdout while it is captured.
+    bool busy = captureBusy;
+    off_t size;
+
+    if(busy == true || fd == -1){
+        fd = memfd_create("substitution", MFD_CLOEXEC);
+        if(fd == -1){
+            perror("memfd_create");
+            return false;
+        }
+        if(busy == false){
+            captureFd = fd;
+        }
+    }
+    else{
+        ftruncate(fd, 0);
+        lseek(fd, 0, SEEK_SET);
+    }
+
+    fflush(stdout);     // Keeps earlier output out of the capture.
+    saved = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 10);
+    dup2(fd, STDOUT_FILENO);
+    captureBusy = true;
+    runList(tree);
+    fflush(stdout);
+    captureBusy = busy;
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    size = lseek(fd, 0, SEEK_CUR);
+    if(size > CAPTURE_SPILL){
+        output->fd = (fd != captureFd) ? fd : -1;   // Keeps the shell's own memfd open.
+        output->used = size;
+        return spillCapture(-1, fd, output);
+    }
+    output->text = arenaAlloc(&cmdArena, size + 1);
+    output->used = (pread(fd, output->text, size, 0) == size) ? size : 0;
+    output->capacity = size + 1;
+    if(fd != captureFd){
+        close(fd);
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool captureChild(struct node* tree, struct capture* output)
+ * Description: Runs a substitution in a forked copy of the shell,
+ *              reading its stdout through a pipe until it ends.
+ * Arguments: A pointer to the node struct of the substitution and a
+ *            pointer to a capture struct that receives its output.
+ * Returns: False after printing an error.
+ *******************************************************************/
+bool captureChild(struct node* tree, struct capture* output)
+{
+    int fds[2];     // Read and write ends of the pipe.
+    pid_t pid;
+    int status;
+    bool captured;
+
+    if(pipe2(fds, O_CLOEXEC) != 0){
+        perror("pipe2");
+        return false;
+    }
+    fflush(stdout);     // Keeps buffered output from being written twice.
+    pid = fork();
+    if(pid == -1){
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if(pid == 0){
+        dup2(fds[1], STDOUT_FILENO);
+        enterSubshell();
+        runList(tree);
+        fflush(stdout);
+        _exit(exitValue());
+    }
+
+    close(fds[1]);
+    captured = readCapture(fds[0], output);
+    close(fds[0]);
+    while(waitpid(pid, &status, 0) == -1){
+        if(errno != EINTR){
+            status = 1 << 8;
+            break;
+        }
+    }
+    foregroundValue = status;
+    if(WIFSIGNALED(status) && WTERMSIG(status) == SIGINT){
+        interrupted = true;     // ^C drops the output and the command waiting for it, and stops the loops around it.
+        return false;
+    }
+    return captured;
+}
+
+
+/*******************************************************************
+ * Name: bool readCapture(int fd, struct capture* output)
+ * Description: Reads a pipe to its end into a buffer in cmdArena,
+ *              doubling it as needed. Output larger than
+ *              CAPTURE_SPILL moves to a memfd instead, so it never
+ *              grows the arena.
+ * Arguments: The descriptor to read and a pointer to a capture
+ *            struct that receives the output.
+ * Returns: False after printing an error.
+ *******************************************************************/
+bool readCapture(int fd, struct capture* output)
+{
+    ssize_t got;
+    size_t newCapacity;
+
+    output->capacity = CAPTURE_START;
+    output->text = arenaAlloc(&cmdArena, output->capacity);
+    while(true){
+        if(output->used + 1 == output->capacity){
+            if(output->capacity >= CAPTURE_SPILL){
+                output->fd = memfd_create("substitution", MFD_CLOEXEC);
+                if(output->fd == -1){
+                    perror("memfd_create");
+                    return false;
+                }
+                return spillCapture(fd, output->fd, output);
+            }
+            newCapacity = output->capacity * 2;
+            output->text = arenaResize(&cmdArena, output->text, output->capacity, newCapacity);
+            output->capacity = newCapacity;
+        }
+        got = read(fd, output->text + output->used, output->capacity - output->used - 1);
+        if(got > 0){
+            output->used += got;
+        }
+        else if(got == 0 || errno != EINTR){
+            break;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool spillCapture(int pipeFd, int memfd,
+ *                         struct capture* output)
+ * Description: Maps a large output from a memfd. When it is still
+ *              arriving through a pipe, what was read so far is
+ *              written first and the rest is spliced in without
+ *              passing through the shell. The file is grown by one
+ *              zero byte, which ends the text.
+ * Arguments: The pipe to finish reading, or -1 when the memfd
+ *            already holds the whole output, the memfd, and a
+ *            pointer to a capture struct.
+ * Returns: False after printing an error.
+ *******************************************************************/
+bool spillCapture(int pipeFd, int memfd, struct capture* output)
+{
+    ssize_t got;
+
+    if(pipeFd != -1){
+        if(write(memfd, output->text, output->used) != (ssize_t)output->used){
+            perror("write");
+            return false;
+        }
+        while((got = splice(pipeFd, NULL, memfd, NULL, CAPTURE_SPILL, SPLICE_F_MOVE)) != 0){
+            if(got > 0){
+                output->used += got;
+            }
+            else if(errno != EINTR){
+                perror("splice");
+                return false;
+            }
+        }
+    }
+
+    ftruncate(memfd, output->used + 1);
+    output->text = mmap(NULL, output->used + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, memfd, 0);
+    if(output->text == MAP_FAILED){
+        perror("mmap");
+        output->text = "";
+        return false;
+    }
+    output->capacity = output->used + 1;
+    output->mapped = true;
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void releaseCapture(struct capture* output)
+ * Description: Unmaps and closes the memfd of a large output. A
+ *              small one stays in cmdArena until the command ends.
+ * Arguments: A pointer to a capture struct.
+ *******************************************************************/
+void releaseCapture(struct capture* output)
+{
+    if(output->mapped == true){
+        munmap(output->text, output->capacity);
+    }
+    if(output->fd != -1){
+        close(output->fd);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void enterSubshell()
+ * Description: Prepares a forked copy of the shell to run a command
+ *              substitution. It gets its own self-pipe and memfd,
+ *              launches without the parent's workers, leaves the
+ *              terminal and the trace alone, and forgets the
+ *              parent's jobs so "exit" cannot end them. A ^C simply
+ *              ends it; the parent prints the message.
+ * Arguments: None.
+ *******************************************************************/
+void enterSubshell()
+{
+    close(childPipe[0]);
+    close(childPipe[1]);
+    if(pipe2(childPipe, O_NONBLOCK | O_CLOEXEC) != 0){
+        perror("pipe2");
+        _exit(1);
+    }
+    if(captureFd != -1){
+        close(captureFd);   // Still written by the parent if a builtin there is being captured.
+        captureFd = -1;
+    }
+    captureBusy = false;
+    interactive = false;
+    jobControl = false;
+    tracing = false;
+    pool.helper = 0;
+    pool.count = 0;
+    jobList = NULL;
+    if(deadlineLoop != -1){
+        close(deadlineLoop);    // Shared with the parent, whose deadlines stay its own.
+        deadlineLoop = -1;
+    }
+    deadlineCount = 0;
+    signal(SIGINT, SIG_DFL);
+}
+
+
+/*******************************************************************
+ * Name: int lexOperator(struct lexer* lex, struct token* tok,
+ *                       char* read, char c, int fd)
+ * Description: Recognizes '|', '&', ';', "&&", "||", '(', ')' and
+ *              the redirection operators "<", ">", ">>", ">&", "&>"
+ *              and "<<<". The first
+ *              character is passed in c because a word ending right
+ *              before it has overwritten it with its terminator.
+ * Arguments: A pointer to a lexer struct, a pointer to a token
+ *            struct to fill in, pointer to char for the operator in
+ *            the line, its first character, and the descriptor
+ *            number written before it, or -1 for the default.
+ * Returns: The token type, or TOK_WORD if c is not an operator.
+ *******************************************************************/
+int lexOperator(struct lexer* lex, struct token* tok, char* read, char c, int fd)
+{
+    int length = 1;     // Characters in the operator.
+
+    switch(c)
+    {
+        case '|':
+            tok->type = TOK_PIPE;
+            if(read[1] == '|'){
+                tok->type = TOK_OR;
+                length = 2;
+            }
+            break;
+        case ';':
+            tok->type = TOK_SEMI;
+            break;
+        case '(':
+            tok->type = TOK_LPAREN;
+            break;
+        case ')':
+            tok->type = TOK_RPAREN;
+            break;
+        case '&':
+            tok->type = TOK_AMP;
+            if(read[1] == '&'){
+                tok->type = TOK_AND;
+                length = 2;
+            }
+            else if(read[1] == '>'){
+                tok->type = TOK_REDIRECT;
+                tok->redirect = REDIR_BOTH;
+                fd = 1;
+                length = 2;
+            }
+            break;
+        case '<':
+            tok->type = TOK_REDIRECT;
+            tok->redirect = REDIR_IN;
+            if(read[1] == '<' && read[2] == '<'){
+                tok->redirect = REDIR_STRING;
+                length = 3;
+            }
+            fd = (fd == -1) ? 0 : fd;
+            break;
+        case '>':
+            tok->type = TOK_REDIRECT;
+            tok->redirect = REDIR_OUT;
+            if(read[1] == '>'){
+                tok->redirect = REDIR_APPEND;
+                length = 2;
+            }
+            else if(read[1] == '&'){
+                tok->redirect = REDIR_DUP;
+                length = 2;
+            }
+            fd = (fd == -1) ? 1 : fd;
+            break;
+        default:
+            return TOK_WORD;
+    }
+    tok->fd = fd;
+    lex->pos = read + length;
+    return tok->type;
+}
+
+
+/*******************************************************************
+ * Name: char* removeQuotes(char* start, char* end)
+ * Description: Removes the quotes from a word of plain quoted text
+ *              in place, which only ever shrinks it.
+ * Arguments: Pointers to char for the start and end of the word.
+ * Returns: The new end of the word.
+ *******************************************************************/
+char* removeQuotes(char* start, char* end)
+{
+    char *write = start;    // Next byte of the word being rewritten.
+
+    for(; start < end; start++){
+        if(*start != '\'' && *start != '"'){
+            *write++ = *start;
+        }
+    }
+    return write;
+}
+
+
+/*******************************************************************
+ * Name: char* skipSubstitution(char* start)
+ * Description: Finds the end of the "$(...)" or `...` at start,
+ *              stepping over quotes, escaped characters and nested
+ *              substitutions so their parentheses and backquotes do
+ *              not end it early.
+ * Arguments: Pointer to char for the '$' or the opening backquote.
+ * Returns: A pointer to the closing ')' or backquote, or NULL if
+ *          the text ends first.
+ *******************************************************************/
+char* skipSubstitution(char* start)
+{
+    char *read;
+    char quote = '\0';     // Quote character currently open, if any.
+    int depth = 0;          // Parentheses opened inside "$(...)" and not yet closed.
+
+    if(*start == '`'){
+        for(read = start + 1; *read != '\0' && *read != '`'; read++){
+            if(*read == '\\' && read[1] != '\0'){
+                read++;     // An escaped backquote belongs to the command.
+            }
+        }
+        return (*read == '`') ? read : NULL;
+    }
+
+    for(read = start + 2; *read != '\0'; read++){
+        if(quote == '\''){
+            quote = (*read == '\'') ? '\0' : quote;
+        }
+        else if(*read == '\\' && read[1] != '\0'){
+            read++;
+        }
+        else if(*read == '"'){
+            quote = (quote == '\0') ? '"' : '\0';
+        }
+        else if(*read == '\'' && quote == '\0'){
+            quote = '\'';
+        }
+        else if(*read == '`' || (*read == '$' && read[1] == '(')){
+            read = skipSubstitution(read);
+            if(read == NULL){
+                return NULL;
+            }
+        }
+        else if(quote == '\0' && *read == '('){
+            depth++;
+        }
+        else if(quote == '\0' && *read == ')'){
+            if(depth == 0){
+                return read;
+            }
+            depth--;
+        }
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: int nextToken(struct lexer* lex, struct token* tok)
+ * Description: Scans the next token of the line in a single pass.
+ *              Words are terminated in place and left raw, quotes
+ *              and '$' included, for expandWord to handle each time
+ *              the command runs; a "$(...)" or `...` is kept whole
+ *              within its word. Quotes around plain text, as in
+ *              'a b', are simply removed here, once.
+ * Arguments: A pointer to a lexer struct and a pointer to a token
+ *            struct to fill in.
+ * Returns: The token type.
+ *******************************************************************/
+int nextToken(struct lexer* lex, struct token* tok)
+{
+    char *read = lex->pos;      // Next character to examine.
+    char *start;                // First byte of the word.
+    char *end;                  // End of the word once quotes are removed.
+    char quote = '\0';          // Quote character currently open, if any.
+    bool quoted = false;        // Indicates the word holds quotes, backslashes or '$'.
+    bool plain = true;          // Indicates the word is plain text once its quotes are removed.
+    char c = (lex->held != '\0') ? lex->held : *read;
+
+    lex->held = '\0';
+    tok->text = NULL;
+    tok->type = TOK_ERROR;
+    tok->expand = false;
+    tok->quoted = false;
+
+    while(c == ' ' || c == '\t'){
+        c = *++read;    // Skips spaces between tokens.
+    }
+    if(c == '#'){
+        read += strcspn(read, "\n");   // Skips a comment up to the end of its line.
+        c = *read;
+    }
+    if(c == '\0'){
+        lex->pos = read;
+        tok->type = TOK_END;
+        return tok->type;
+    }
+    if(c == '\n'){
+        lex->pos = read + 1;
+        tok->type = TOK_NEWLINE;
+        return tok->type;
+    }
+    if(lexOperator(lex, tok, read, c, -1) != TOK_WORD){
+        return tok->type;
+    }
+
+    /* Finds the end of the word, stepping over quoted text and escaped characters. */
+    start = read;
+    while(true){
+        read += strcspn(read, LEX_SPECIAL);     // Skips ordinary characters in one library call.
+        if((c = *read) == '\0'){
+            break;
+        }
+        if(quote == '\0' && strchr(" \t\n|<>&;()", c) != NULL){
+            break;  // An unquoted blank or operator ends the word.
+        }
+        if(quote != '\'' && (c == '`' || (c == '$' && read[1] == '('))){
+            end = skipSubstitution(read);   // Keeps the whole command in the word, operators and all.
+            if(end == NULL){
+                printf("unexpected end of line while looking for matching %c\n", (c == '`') ? '`' : ')');
+                return tok->type;
+            }
+            plain = false;
+            quoted = true;
+            read = end + 1;
+            continue;
+        }
+        if(c == '$' || c == '\\' || (quote != '\0' && (c == '\'' || c == '"') && c != quote)){
+            plain = false;  // Leaves the word whole for expandWord.
+        }
+        quoted = true;
+        if(quote != '"' && c == '\''){  // Opens or closes single quotes.
+            quote = (quote == '\0') ? '\'' : '\0';
+        }
+        else if(quote != '\'' && c == '"'){ // Opens or closes double quotes.
+            quote = (quote == '\0') ? '"' : '\0';
+        }
+        else if(quote != '\'' && c == '\\' && read[1] != '\0' && read[1] != '\n'){
+            read++;     // Keeps the escaped character in the word.
+        }
+        read++;
+    }
+    if(quote != '\0'){
+        printf("unexpected end of line while looking for matching %c\n", quote);
+        return tok->type;
+    }
+
+    /* Reads an unquoted digit directly before '<' or '>' as the descriptor to redirect. */
+    if((c == '<' || c == '>') && read - start == 1 && isdigit((unsigned char)*start)){
+        return lexOperator(lex, tok, read, c, *start - '0');
+    }
+
+    /* Terminates the word without losing an operator or newline that directly follows it. */
+    if(c != '\0' && c != ' ' && c != '\t'){
+        lex->held = c;
+        lex->pos = read;
+    }
+    else{
+        lex->pos = (c == '\0') ? read : read + 1;
+    }
+    end = read;
+    tok->quoted = quoted;
+    if(quoted == true){
+        if(plain == true){
+            end = removeQuotes(start, read);
+        }
+        else{
+            tok->expand = true;
+        }
+    }
+    *read = '\0';
+    *end = '\0';
+    tok->type = TOK_WORD;
+    tok->text = start;
+    return tok->type;
+}
+
+
+/*******************************************************************
+ * Name: void advance(struct parser* p)
+ * Description: Reads the next token. Running out of text in the
+ *              middle of a command reads another line, so compound
+ *              commands and lines ending in an operator can continue
+ *              on the lines that follow. The text of a command
+ *              substitution is complete, so it ends there instead.
+ * Arguments: A pointer to a parser struct.
+ *******************************************************************/
+void advance(struct parser* p)
+{
+    char *line;
+
+    while(nextToken(&p->lex, &p->tok) == TOK_END){
+        line = (p->nested == true) ? NULL : readMore();
+        if(line == NULL){
+            return;     // Leaves TOK_END at the end of input.
+        }
+        p->lex.pos = line;
+        p->lex.held = '\0';
+    }
+    if(p->tok.type == TOK_ERROR){
+        p->failed = true;   // nextToken has printed why.
+    }
+}
+
+
+/*******************************************************************
+ * Name: char* readMore()
+ * Description: Reads a continuation line for an unfinished command,
+ *              showing CONTINUE_PROMPT at a terminal.
+ * Arguments: None.
+ * Returns: The line, or NULL once input is exhausted.
+ *******************************************************************/
+char* readMore()
+{
+    char *line;
+
+    if(interactive == true){
+        prompt = CONTINUE_PROMPT;
+        printf("%s", prompt);
+        fflush(stdout);
+    }
+    line = readLine();
+    prompt = PROMPT;
+    if(line != NULL && interactive == true){
+        addHistory(line);
+    }
+    return line;
+}
+
+
+/*******************************************************************
+ * Name: bool isKeyword(struct parser* p, const char* keyword)
+ * Description: Checks whether the current token is the given
+ *              reserved word, written without quotes.
+ * Arguments: A pointer to a parser struct and pointer to char for
+ *            the word.
+ *******************************************************************/
+bool isKeyword(struct parser* p, const char* keyword)
+{
+    return p->tok.type == TOK_WORD && p->tok.text[0] == keyword[0] && p->tok.quoted == false
+        && strcmp(p->tok.text, keyword) == 0;   // Most words differ in the first character.
+}
+
+
+/*******************************************************************
+ * Name: bool expectKeyword(struct parser* p, const char* keyword)
+ * Description: Steps past the given reserved word, or reports a
+ *              syntax error if another token is there instead.
+ * Arguments: A pointer to a parser struct and pointer to char for
+ *            the word.
+ * Returns: False after a syntax error.
+ *******************************************************************/
+bool expectKeyword(struct parser* p, const char* keyword)
+{
+    if(p->failed == true){
+        return false;
+    }
+    if(isKeyword(p, keyword) == false){
+        syntaxError(p, keyword);
+        return false;
+    }
+    advance(p);
+    return p->failed == false;
+}
+
+
+/*******************************************************************
+ * Name: struct node* syntaxError(struct parser* p,
+ *                                const char* expected)
+ * Description: Prints a syntax error, once per command.
+ * Arguments: A pointer to a parser struct and pointer to char for
+ *            what was expected, or NULL.
+ * Returns: NULL, for the caller to return.
+ *******************************************************************/
+struct node* syntaxError(struct parser* p, const char* expected)
+{
+    if(p->failed == false){
+        if(p->tok.type == TOK_END){
+            printf("syntax error: unexpected end of file\n");
+        }
+        else if(expected != NULL){
+            printf("syntax error: expected %s\n", expected);
+        }
+        else{
+            printf("syntax error\n");
+        }
+    }
+    p->failed = true;
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: void skipNewlines(struct parser* p)
+ * Description: Steps past blank lines where a command may continue.
+ * Arguments: A pointer to a parser struct.
+ *******************************************************************/
+void skipNewlines(struct parser* p)
+{
+    while(p->tok.type == TOK_NEWLINE){
+        advance(p);
+    }
+}
+
+
+/*******************************************************************
+ * Name: struct node* newNode(int kind)
+ * Description: Creates an empty node in cmdArena.
+ * Arguments: An int for one of the NODE_ constants.
+ *******************************************************************/
+struct node* newNode(int kind)
+{
+    struct node *node = arenaAlloc(&cmdArena, sizeof(struct node));
+
+    memset(node, 0, sizeof(struct node));
+    node->kind = kind;
+    return node;
+}
+
+
+/*******************************************************************
+ * Name: struct parsedInput* parseSimple(struct parser* p)
+ * Description: Fills one parsedInput struct with the words and
+ *              redirections of a simple command, stopping at the
+ *              first other token. The command, its argument list
+ *              and its words all live in cmdArena alongside the
+ *              input line.
+ * Arguments: A pointer to a parser struct.
+ * Returns: The command, or NULL after printing a syntax error.
+ *******************************************************************/
+struct parsedInput* parseSimple(struct parser* p)
+{
+    struct parsedInput *obj = arenaAlloc(&cmdArena, sizeof(struct parsedInput));
+    struct redirect *added;             // Redirection being filled.
+    int kind;                           // Kind of the redirection being parsed.
+    int fd;                             // Descriptor of the redirection being parsed.
+
+    obj->backMode = false;
+    obj->expand = false;
+    obj->redirects = NULL;
+    obj->redirectNum = 0;
+    obj->redirectCapacity = 0;
+    obj->argNum = 0;
+    obj->argCapacity = ARGS_START;
+    obj->arguments = arenaAlloc(&cmdArena, (ARGS_START + 1) * sizeof(char*));
+    obj->arguments[0] = NULL;
+
+    while(p->failed == false && (p->tok.type == TOK_WORD || p->tok.type == TOK_REDIRECT)){
+        if(p->tok.type == TOK_WORD){
+            addArgument(obj, p->tok.text);  // Stores the command or an argument.
+            obj->expand |= p->tok.expand;
+            advance(p);
+            continue;
+        }
+        kind = p->tok.redirect;
+        fd = p->tok.fd;
+        advance(p);
+        if(p->tok.type != TOK_WORD){
+            syntaxError(p, "a file name");  // A redirection needs a file name, word or descriptor.
+            return NULL;
+        }
+        if(fd > 2 || (kind == REDIR_DUP && (p->tok.text[0] < '0' || p->tok.text[0] > '2' || p->tok.text[1] != '\0'))){
+            printf("syntax error: only descriptors 0, 1 and 2 can be redirected\n");
+            p->failed = true;
+            return NULL;
+        }
+        if(obj->redirectNum == obj->redirectCapacity){
+            obj->redirects = (obj->redirectCapacity == 0)
+                ? arenaAlloc(&cmdArena, 2 * sizeof(struct redirect))
+                : arenaResize(&cmdArena, obj->redirects, obj->redirectCapacity * sizeof(struct redirect),
+                              2 * obj->redirectCapacity * sizeof(struct redirect));
+            obj->redirectCapacity = (obj->redirectCapacity == 0) ? 2 : 2 * obj->redirectCapacity;
+        }
+        added = &obj->redirects[obj->redirectNum++];
+        added->kind = kind;
+        added->fd = fd;
+        added->target = p->tok.text;
+        obj->expand |= p->tok.expand;
+        advance(p);
+    }
+    return (p->failed == true) ? NULL : obj;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parsePipeline(struct parser* p)
+ * Description: Parses a compound command, a function definition,
+ *              or simple commands joined by '|', with an optional
+ *              leading '!'.
+ * Arguments: A pointer to a parser struct.
+ * Returns: The node, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parsePipeline(struct parser* p)
+{
+    struct node *node;
+    struct node *function;
+    struct parsedInput *obj;
+    int stageCapacity = ARGS_START;     // Room in stages.
+    bool negate = false;
+
+    if(isKeyword(p, "!")){
+        negate = true;
+        advance(p);
+    }
+    if(isKeyword(p, "if") || isKeyword(p, "while") || isKeyword(p, "until") || isKeyword(p, "for") || isKeyword(p, "{")){
+        node = parseCompound(p);
+        if(node != NULL && p->tok.type == TOK_PIPE){
+            return syntaxError(p, "';' or a newline after a compound command");
+        }
+        if(node != NULL){
+            node->negate = negate;
+        }
+        return node;
+    }
+
+    node = newNode(NODE_PIPELINE);
+    node->negate = negate;
+    node->stages = arenaAlloc(&cmdArena, stageCapacity * sizeof(struct parsedInput*));
+    while(true){
+        obj = parseSimple(p);
+        if(obj == NULL){
+            return NULL;
+        }
+        if(obj->argNum == 0){
+            return syntaxError(p, "a command");     // A command cannot start with an operator.
+        }
+        if(node->stageCount == stageCapacity){
+            node->stages = arenaResize(&cmdArena, node->stages, stageCapacity * sizeof(struct parsedInput*),
+                                       2 * stageCapacity * sizeof(struct parsedInput*));
+            stageCapacity *= 2;
+        }
+        node->stages[node->stageCount++] = obj;
+
+        /* Recognizes "name()" followed by the compound command that is the function's body. */
+        if(p->tok.type == TOK_LPAREN && node->stageCount == 1 && obj->argNum == 1 && obj->redirectNum == 0
+                && negate == false){
+            if(validName(obj->arguments[0], strlen(obj->arguments[0])) == false){
+                printf("syntax error: `%s' is not a valid function name\n", obj->arguments[0]);
+                p->failed = true;
+                return NULL;
+            }
+            advance(p);
+            if(p->tok.type != TOK_RPAREN){
+                return syntaxError(p, "')'");
+            }
+            advance(p);
+            skipNewlines(p);
+            function = newNode(NODE_FUNCTION);
+            function->name = obj->arguments[0];
+            if(isKeyword(p, "if") || isKeyword(p, "while") || isKeyword(p, "until") || isKeyword(p, "for")
+                    || isKeyword(p, "{")){
+                function->body = parseCompound(p);
+            }
+            else{
+                syntaxError(p, "'{' to start the function body");
+            }
+            return (function->body != NULL) ? function : NULL;
+        }
+        if(p->tok.type != TOK_PIPE){
+            return node;
+        }
+        advance(p);
+        skipNewlines(p);    // A pipeline may continue on the next line.
+    }
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseAndOr(struct parser* p)
+ * Description: Parses pipelines joined by "&&" and "||", which
+ *              group from the left.
+ * Arguments: A pointer to a parser struct.
+ * Returns: The node, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parseAndOr(struct parser* p)
+{
+    struct node *left = parsePipeline(p);
+    struct node *node;
+
+    while(left != NULL && (p->tok.type == TOK_AND || p->tok.type == TOK_OR)){
+        node = newNode((p->tok.type == TOK_AND) ? NODE_AND : NODE_OR);
+        node->condition = left;
+        advance(p);
+        skipNewlines(p);
+        node->body = parsePipeline(p);
+        if(node->body == NULL){
+            return NULL;
+        }
+        left = node;
+    }
+    return left;
+}
+
+
+/*******************************************************************
+ * Name: bool endsList(struct parser* p)
+ * Description: Checks for a token that closes the list being
+ *              parsed: a reserved word such as "then" or "done", a
+ *              ')', or the end of input.
+ * Arguments: A pointer to a parser struct.
+ *******************************************************************/
+bool endsList(struct parser* p)
+{
+    return p->tok.type == TOK_END || p->tok.type == TOK_RPAREN || isKeyword(p, "then") || isKeyword(p, "elif")
+        || isKeyword(p, "else") || isKeyword(p, "fi") || isKeyword(p, "do") || isKeyword(p, "done")
+        || isKeyword(p, "}");
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseList(struct parser* p, bool top)
+ * Description: Parses commands separated by ';', '&' or newlines.
+ *              A '&' runs the pipeline before it in the background.
+ *              The list at the top of a line ends at the newline,
+ *              which is left unread so no further line is read.
+ * Arguments: A pointer to a parser struct, and a bool, true for the
+ *            list at the top of a line.
+ * Returns: The first node of the list, which is NULL when the list
+ *          is empty or a syntax error was printed.
+ *******************************************************************/
+struct node* parseList(struct parser* p, bool top)
+{
+    struct node *head = NULL;
+    struct node **link = &head;     // Where the next command is linked in.
+    struct node *node;
+
+    if(top == false){
+        skipNewlines(p);
+    }
+    while(p->failed == false && endsList(p) == false && (top == false || p->tok.type != TOK_NEWLINE)){
+        node = parseAndOr(p);
+        if(node == NULL){
+            return NULL;
+        }
+        *link = node;
+        link = &node->next;
+
+        if(p->tok.type == TOK_AMP){
+            if(node->kind != NODE_PIPELINE){
+                return syntaxError(p, "a pipeline before '&'");
+            }
+            node->stages[node->stageCount - 1]->backMode = true;    // Runs the pipeline in the background.
+        }
+        else if(p->tok.type != TOK_SEMI && p->tok.type != TOK_NEWLINE){
+            break;  // Left for the caller, which expects a reserved word or the end of the line.
+        }
+        if(top == true && p->tok.type == TOK_NEWLINE){
+            break;
+        }
+        advance(p);
+        if(top == false){
+            skipNewlines(p);
+        }
+    }
+    return (p->failed == true) ? NULL : head;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseBody(struct parser* p,
+ *                              const char* opener,
+ *                              const char* closer)
+ * Description: Parses a list that must not be empty, between two
+ *              reserved words.
+ * Arguments: A pointer to a parser struct, and pointers to char for
+ *            the word that opens the list and the one that closes
+ *            it, or NULL when the caller checks what follows.
+ * Returns: The list, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parseBody(struct parser* p, const char* opener, const char* closer)
+{
+    struct node *list;
+
+    if(opener != NULL && expectKeyword(p, opener) == false){
+        return NULL;
+    }
+    list = parseList(p, false);
+    if(list == NULL){
+        return syntaxError(p, "a command");
+    }
+    if(closer != NULL && expectKeyword(p, closer) == false){
+        return NULL;
+    }
+    return list;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseIf(struct parser* p)
+ * Description: Parses an "if" command after its "if" or "elif".
+ *              An "elif" becomes another NODE_IF in the else part,
+ *              which reads the shared "fi".
+ * Arguments: A pointer to a parser struct.
+ * Returns: The node, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parseIf(struct parser* p)
+{
+    struct node *node = newNode(NODE_IF);
+
+    if((node->condition = parseBody(p, NULL, NULL)) == NULL || (node->body = parseBody(p, "then", NULL)) == NULL){
+        return NULL;
+    }
+    if(isKeyword(p, "elif")){
+        advance(p);
+        node->orElse = parseIf(p);
+        return (node->orElse != NULL) ? node : NULL;
+    }
+    if(isKeyword(p, "else") && (node->orElse = parseBody(p, "else", NULL)) == NULL){
+        return NULL;
+    }
+    return (expectKeyword(p, "fi") == true) ? node : NULL;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseFor(struct parser* p)
+ * Description: Parses a "for" command after its "for". Without an
+ *              "in" part the loop runs over the positional
+ *              parameters.
+ * Arguments: A pointer to a parser struct.
+ * Returns: The node, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parseFor(struct parser* p)
+{
+    struct node *node = newNode(NODE_FOR);
+
+    if(p->tok.type != TOK_WORD || p->tok.quoted == true || validName(p->tok.text, strlen(p->tok.text)) == false){
+        return syntaxError(p, "a variable name after for");
+    }
+    node->name = p->tok.text;
+    advance(p);
+    skipNewlines(p);
+    if(isKeyword(p, "in")){
+        advance(p);
+        node->words = parseSimple(p);   // Stops at the ';' or newline before "do".
+        if(node->words == NULL){
+            return NULL;
+        }
+        if(node->words->redirectNum > 0){
+            return syntaxError(p, "words after in");
+        }
+        if(p->tok.type != TOK_SEMI && p->tok.type != TOK_NEWLINE){
+            return syntaxError(p, "';' or a newline before do");
+        }
+        advance(p);
+    }
+    else if(p->tok.type == TOK_SEMI){
+        advance(p);
+    }
+    skipNewlines(p);
+    if((node->body = parseBody(p, "do", "done")) == NULL){
+        return NULL;
+    }
+    return node;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseCompound(struct parser* p)
+ * Description: Parses an "if", "while", "until" or "for" command,
+ *              or a list grouped by '{' and '}'.
+ * Arguments: A pointer to a parser struct, at the opening word.
+ * Returns: The node, or NULL after printing a syntax error.
+ *******************************************************************/
+struct node* parseCompound(struct parser* p)
+{
+    struct node *node;
+
+    if(isKeyword(p, "if")){
+        advance(p);
+        return parseIf(p);
+    }
+    if(isKeyword(p, "for")){
+        advance(p);
+        return parseFor(p);
+    }
+    if(isKeyword(p, "{")){
+        node = newNode(NODE_GROUP);
+        node->body = parseBody(p, "{", "}");
+        return (node->body != NULL) ? node : NULL;
+    }
+    node = newNode(isKeyword(p, "while") ? NODE_WHILE : NODE_UNTIL);
+    advance(p);
+    if((node->condition = parseBody(p, NULL, NULL)) == NULL || (node->body = parseBody(p, "do", "done")) == NULL){
+        return NULL;
+    }
+    return node;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseLine(char* inputBuffer, bool* failed)
+ * Description: Builds the tree for one line of input, reading more
+ *              lines while a compound command in it is unfinished.
+ *              The tree and the words it points at live in cmdArena
+ *              until the next line; loops run it as often as they
+ *              need without parsing again.
+ * Arguments: Pointer to char for the line, and a pointer to a bool
+ *            set when a syntax error was printed.
+ * Returns: The list of commands, which is NULL for a blank line,
+ *          a comment or a syntax error.
+ *******************************************************************/
+struct node* parseLine(char* inputBuffer, bool* failed)
+{
+    struct parser p;
+    struct node *list;
+
+    p.lex.pos = inputBuffer;
+    p.lex.held = '\0';
+    p.failed = false;
+    p.nested = false;
+    advance(&p);
+    list = parseList(&p, true);
+    if(p.failed == false && p.tok.type != TOK_NEWLINE && p.tok.type != TOK_END){
+        syntaxError(&p, NULL);  // A stray reserved word, ')' or redirection after a compound command.
+    }
+    *failed = p.failed;
+    return (p.failed == true) ? NULL : list;
+}
+
+
+/*******************************************************************
+ * Name: struct node* parseSubstitution(char* text, bool* failed)
+ * Description: Builds the tree for the command inside "$(...)" or
+ *              `...`, which may hold several lines but never reads
+ *              more. The tree lives in cmdArena with the command
+ *              that ran the substitution.
+ * Arguments: Pointer to char for the command, and a pointer to a
+ *            bool set when a syntax error was printed.
+ * Returns: The list of commands, which is NULL when it is empty or
+ *          a syntax error was printed.
+ *******************************************************************/
+struct node* parseSubstitution(char* text, bool* failed)
+{
+    struct parser p;
+    struct node *list;
+
+    p.lex.pos = text;
+    p.lex.held = '\0';
+    p.failed = false;
+    p.nested = true;
+    advance(&p);
+    list = parseList(&p, false);
+    if(p.failed == false && p.tok.type != TOK_END){
+        syntaxError(&p, NULL);  // A stray reserved word or ')'.
+    }
+    *failed = p.failed;
+    return (p.failed == true) ? NULL : list;
+}
+
+
+/*******************************************************************
+ * Name: bool unwinding()
+ * Description: Checks whether "break", "continue", "return" or a
+ *              ^C is leaving the commands being run.
+ * Arguments: None.
+ *******************************************************************/
+bool unwinding()
+{
+    return breakLevels > 0 || returning == true || interrupted == true;
+}
+
+
+/*******************************************************************
+ * Name: bool loopDone()
+ * Description: Decides after each pass whether the innermost loop
+ *              stops. A "break" or "continue" aimed at this loop is
+ *              used up here; one aimed further out keeps unwinding.
+ * Arguments: None.
+ * Returns: True if the loop stops.
+ *******************************************************************/
+bool loopDone()
+{
+    if(signalMessage == SIGINT && interrupted == false){
+        interrupted = true;     // ^C reached the shell while a builtin ran.
+        foregroundValue = (128 + SIGINT) << 8;
+    }
+    if(returning == true || interrupted == true){
+        return true;
+    }
+    if(breakLevels == 0){
+        return false;
+    }
+    breakLevels--;
+    if(breakLevels == 0 && continuing == true){
+        continuing = false;
+        return false;   // Goes on with the next pass.
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void runList(struct node* list)
+ * Description: Runs each command of a list in turn.
+ * Arguments: A pointer to the first node of the list.
+ *******************************************************************/
+void runList(struct node* list)
+{
+    for(; list != NULL && unwinding() == false; list = list->next){
+        runNode(list);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void runNode(struct node* node)
+ * Description: Runs one command of a parsed tree, leaving its
+ *              status in foregroundValue.
+ * Arguments: A pointer to a node struct.
+ *******************************************************************/
+void runNode(struct node* node)
+{
+    switch(node->kind)
+    {
+        case NODE_PIPELINE:
+            runCommand(node);
+            break;
+
+        /* Runs the right side only when the left side's status allows it. */
+        case NODE_AND:
+        case NODE_OR:
+            runNode(node->condition);
+            if(unwinding() == false && (foregroundValue == 0) == (node->kind == NODE_AND)){
+                runNode(node->body);
+            }
+            break;
+
+        case NODE_GROUP:
+            runList(node->body);
+            break;
+
+        case NODE_IF:
+            runList(node->condition);
+            if(unwinding() == true){
+                break;
+            }
+            if(foregroundValue == 0){
+                runList(node->body);
+            }
+            else if(node->orElse != NULL){
+                runList(node->orElse);
+            }
+            else{
+                foregroundValue = 0;    // No branch ran.
+            }
+            break;
+
+        case NODE_WHILE:
+        case NODE_UNTIL:
+            runLoop(node);
+            break;
+
+        case NODE_FOR:
+            runFor(node);
+            break;
+
+        case NODE_FUNCTION:
+            defineFunction(node);
+            break;
+    }
+    if(node->negate == true){
+        foregroundValue = (foregroundValue == 0) ? 1 << 8 : 0;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void runCommand(struct node* node)
+ * Description: Runs a pipeline from the tree. Its commands are
+ *              copied, so expansion never changes the tree, and
+ *              everything the run allocates is released afterwards,
+ *              so a loop runs in the same memory on every pass.
+ *              A single command may be an assignment, a function,
+ *              a builtin or a program; anything else is launched.
+ * Arguments: A pointer to a node struct of kind NODE_PIPELINE.
+ *******************************************************************/
+void runCommand(struct node* node)
+{
+    struct arenaPosition mark = arenaMark(&cmdArena);
+    struct parsedInput **stages;    // Points at each copy.
+    struct parsedInput *copies;     // Copies of the pipeline's commands, expanded for this run.
+    struct parsedInput *obj;        // Points at the first command.
+    struct function *func;
+    int stageCount = node->stageCount;
+    bool timed;                     // Indicates the line began with the "time" prefix.
+    bool limited;                   // Indicates a "timeout" or "ulimit" prefix applies, so the job is launched.
+    struct timespec started;        // Stores when the command started.
+    int i;                          // Index for loop.
+
+    if(childPending){
+        reapBackground();   // Keeps a long loop from filling the job table; notices wait for the prompt.
+    }
+    if(deadlineCount > 0){
+        checkDeadlines();   // Ends background jobs whose time is up, even in a loop of builtins.
+    }
+    i = (stageCount + 1) & ~1;      // Rounds the pointer array up so the copies stay 16-byte aligned.
+    stages = arenaAlloc(&cmdArena, i * sizeof(struct parsedInput*) + stageCount * sizeof(struct parsedInput));
+    copies = (struct parsedInput*)(stages + i);
+    for(i = 0; i < stageCount; i++){
+        copies[i] = *node->stages[i];
+        stages[i] = &copies[i];
+    }
+    obj = stages[0];
+    if(stageCount == 1 && runAssignments(obj) == true){
+        arenaRelease(&cmdArena, mark);
+        return;     // Sets shell variables; there is no command to run.
+    }
+
+    /* Expands every command of the pipeline before any of it runs. */
+    for(i = 0; i < stageCount; i++){
+        if(expandCommand(stages[i]) == false){
+            break;
+        }
+        if(stages[i]->argNum == 0 && stageCount > 1){
+            printf("syntax error: empty command in pipeline\n");
+            break;
+        }
+    }
+    if(i < stageCount){
+        if(interrupted == false){
+            foregroundValue = 1 << 8;   // Keeps the status of a substitution ended by ^C.
+        }
+        arenaRelease(&cmdArena, mark);
+        return;
+    }
+
+    /* Removes a leading "time", which reports this command even when timing is off. */
+    cmdTimeFormat = stripTimePrefix(obj);
+    timed = (cmdTimeFormat != TIME_OFF);
+    if(timed == false){
+        cmdTimeFormat = timingMode;
+    }
+    if(obj->argNum == 0 && stageCount > 1){
+        printf("syntax error: missing command after time\n");
+        foregroundValue = 2 << 8;
+        arenaRelease(&cmdArena, mark);
+        return;
+    }
+
+    /* Removes leading "timeout" and "ulimit" prefixes, which apply to this job alone. */
+    cmdTimeout = 0;
+    cmdLimitNum = 0;
+    if(stripJobPrefixes(obj) == false){
+        arenaRelease(&cmdArena, mark);
+        return;
+    }
+    limited = (cmdTimeout > 0 || cmdLimitNum > 0);
+    cmdBackground = (stages[stageCount - 1]->backMode == true && foregroundMode == false);
+    memset(&cmdUsage, 0, sizeof(cmdUsage));
+    cmdUsageCount = 0;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    /* Handles functions and built-in commands. */
+    if(obj->argNum == 0){
+        foregroundValue = 0;    // Times nothing, as "time" alone does.
+    }
+    else if(stageCount > 1 || obj->backMode == true || limited == true){
+        runPipeline(stages, stageCount);    // Runs each command, connected by pipes.
+    }
+    else if((func = findFunction(obj->arguments[0])) != NULL){
+        runFunction(func, obj);
+    }
+    else if(runBuiltin(obj) == false){  // Runs exit, cd, status, echo and the other builtins in the shell.
+        runPipeline(stages, stageCount);    // Runs the command as a child process.
+    }
+    if(WIFSIGNALED(foregroundValue) && WTERMSIG(foregroundValue) == SIGINT){
+        interrupted = true;     // ^C ended the command; the loops around it stop too.
+    }
+
+    /* Reports the foreground children's resource usage; background ones report when they end. */
+    if(cmdTimeFormat != TIME_OFF && cmdBackground == false && (timed == true || cmdUsageCount > 0)){
+        fflush(stdout);
+        printUsage(cmdTimeFormat, 0, foregroundValue, secondsSince(&started), &cmdUsage, false);
+    }
+    arenaRelease(&cmdArena, mark);
+}
+
+
+/*******************************************************************
+ * Name: void runLoop(struct node* node)
+ * Description: Runs a "while" or "until" loop. Its status is that
+ *              of the last pass of the body, or 0 if it never ran.
+ * Arguments: A pointer to a node struct.
+ *******************************************************************/
+void runLoop(struct node* node)
+{
+    int value = 0;  // Status of the body's last pass.
+
+    loopDepth++;
+    while(true){
+        runList(node->condition);
+        if(loopDone() == true || (foregroundValue == 0) != (node->kind == NODE_WHILE)){
+            break;
+        }
+        runList(node->body);
+        value = foregroundValue;
+        if(loopDone() == true){
+            break;
+        }
+    }
+    loopDepth--;
+    if(interrupted == false){
+        foregroundValue = value;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void runFor(struct node* node)
+ * Description: Runs a "for" loop, expanding its words once and
+ *              setting the variable to each field in turn.
+ * Arguments: A pointer to a node struct.
+ *******************************************************************/
+void runFor(struct node* node)
+{
+    struct arenaPosition mark = arenaMark(&cmdArena);
+    struct parsedInput words;   // The loop's words, expanded for this run.
+    char **fields = (positional != NULL) ? positional + 1 : NULL;
+    int fieldNum = positionalNum;
+    size_t length = strlen(node->name);
+    int value = 0;  // Status of the body's last pass.
+    int i;          // Index for loop.
+
+    if(node->words != NULL){
+        words = *node->words;
+        if(expandCommand(&words) == false){
+            foregroundValue = 1 << 8;
+            arenaRelease(&cmdArena, mark);
+            return;
+        }
+        fields = words.arguments;
+        fieldNum = words.argNum;
+    }
+
+    loopDepth++;
+    for(i = 0; i < fieldNum; i++){
+        setVariable(node->name, length, fields[i]);
+        runList(node->body);
+        value = foregroundValue;
+        if(loopDone() == true){
+            break;
+        }
+    }
+    loopDepth--;
+    if(interrupted == false){
+        foregroundValue = value;
+    }
+    arenaRelease(&cmdArena, mark);
+}
+
+
+/*******************************************************************
+ * Name: char* copyText(const char* text)
+ * Description: Copies a string into funcArena.
+ * Arguments: Pointer to char for the string, or NULL.
+ *******************************************************************/
+char* copyText(const char* text)
+{
+    char *copy;
+
+    if(text == NULL){
+        return NULL;
+    }
+    copy = arenaAlloc(&funcArena, strlen(text) + 1);
+    strcpy(copy, text);
+    return copy;
+}
+
+
+/*******************************************************************
+ * Name: struct parsedInput* copyCommand(struct parsedInput* obj)
+ * Description: Copies a parsed command, its words and its
+ *              redirections into funcArena.
+ * Arguments: A pointer to an parsedInput struct, or NULL.
+ *******************************************************************/
+struct parsedInput* copyCommand(struct parsedInput* obj)
+{
+    struct parsedInput *copy;
+    int i;  // Index for loop.
+
+    if(obj == NULL){
+        return NULL;
+    }
+    copy = arenaAlloc(&funcArena, sizeof(struct parsedInput));
+    *copy = *obj;
+    copy->argCapacity = obj->argNum;
+    copy->arguments = arenaAlloc(&funcArena, (obj->argNum + 1) * sizeof(char*));
+    for(i = 0; i <= obj->argNum; i++){
+        copy->arguments[i] = copyText(obj->arguments[i]);   // Includes the terminating NULL.
+    }
+    copy->redirectCapacity = obj->redirectNum;
+    if(obj->redirectNum > 0){
+        copy->redirects = arenaAlloc(&funcArena, obj->redirectNum * sizeof(struct redirect));
+        for(i = 0; i < obj->redirectNum; i++){
+            copy->redirects[i] = obj->redirects[i];
+            copy->redirects[i].target = copyText(obj->redirects[i].target);
+        }
+    }
+    return copy;
+}
+
+
+/*******************************************************************
+ * Name: struct node* copyNode(struct node* node)
+ * Description: Copies a parsed tree out of cmdArena into funcArena,
+ *              so a function body survives the line defining it.
+ * Arguments: A pointer to a node struct, or NULL.
+ *******************************************************************/
+struct node* copyNode(struct node* node)
+{
+    struct node *copy;
+    int i;  // Index for loop.
+
+    if(node == NULL){
+        return NULL;
+    }
+    copy = arenaAlloc(&funcArena, sizeof(struct node));
+    *copy = *node;
+    if(node->stageCount > 0){
+        copy->stages = arenaAlloc(&funcArena, node->stageCount * sizeof(struct parsedInput*));
+        for(i = 0; i < node->stageCount; i++){
+            copy->stages[i] = copyCommand(node->stages[i]);
+        }
+    }
+    copy->words = copyCommand(node->words);
+    copy->name = copyText(node->name);
+    copy->condition = copyNode(node->condition);
+    copy->body = copyNode(node->body);
+    copy->orElse = copyNode(node->orElse);
+    copy->next = copyNode(node->next);
+    return copy;
+}
+
+
+/*******************************************************************
+ * Name: struct function* findFunction(const char* name)
+ * Description: Looks up a shell function.
+ * Arguments: Pointer to char for the name.
+ * Returns: The function, or NULL if there is none by that name.
+ *******************************************************************/
+struct function* findFunction(const char* name)
+{
+    struct function *func;
+
+    for(func = functions[hashName(name)]; func != NULL; func = func->next){
+        if(strcmp(func->name, name) == 0){
+            return func;
+        }
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: void defineFunction(struct node* node)
+ * Description: Defines or redefines a shell function. A body that
+ *              is replaced stays in funcArena, as a call to it may
+ *              still be running.
+ * Arguments: A pointer to a node struct of kind NODE_FUNCTION.
+ *******************************************************************/
+void defineFunction(struct node* node)
+{
+    struct function *func = findFunction(node->name);
+    unsigned int bucket;
+
+    if(func == NULL){
+        func = malloc(sizeof(struct function));
+        if(func == NULL){
+            printf("Unable to allocate memory\n");
+            exit(1);
+        }
+        bucket = hashName(node->name);
+        func->name = copyText(node->name);
+        func->next = functions[bucket];
+        functions[bucket] = func;
+    }
+    func->body = copyNode(node->body);
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: void runFunction(struct function* func,
+ *                        struct parsedInput* obj)
+ * Description: Calls a shell function with the command's arguments
+ *              as its positional parameters. Redirections apply to
+ *              the whole body.
+ * Arguments: A pointer to a function struct and a pointer to the
+ *            expanded parsedInput struct that called it.
+ *******************************************************************/
+void runFunction(struct function* func, struct parsedInput* obj)
+{
+    char **savedPositional = positional;
+    int savedNum = positionalNum;
+    int savedLoops = loopDepth;
+    int saved[3] = {-1, -1, -1};    // The shell's own stdin, stdout and stderr while redirected.
+
+    if(functionDepth == FUNCTION_DEPTH){
+        printf("%s: maximum function nesting exceeded\n", obj->arguments[0]);
+        foregroundValue = 1 << 8;
+        return;
+    }
+    if(redirectShell(obj, saved) == false){
+        foregroundValue = 1 << 8;
+        return;
+    }
+    positional = obj->arguments;
+    positionalNum = obj->argNum - 1;
+    loopDepth = 0;  // "break" cannot leave a loop the caller is running.
+    functionDepth++;
+    foregroundValue = 0;
+
+    runNode(func->body);
+
+    functionDepth--;
+    returning = false;
+    loopDepth = savedLoops;
+    positional = savedPositional;
+    positionalNum = savedNum;
+    restoreShell(saved);
+}
+
+
+/*******************************************************************
+ * Name: unsigned int hashName(const char* name)
+ * Description: Computes the bucket for a command name.
+ * Arguments: Pointer to char for the command name.
+ *******************************************************************/
+unsigned int hashName(const char* name)
+{
+    unsigned int hash = 5381;
+
+    while(*name != '\0'){
+        hash = hash * 33 + (unsigned char)*name++;
+    }
+    return hash % HASH_BUCKETS;
+}
+
+
+/*******************************************************************
+ * Name: char* searchPath(const char* name)
+ * Description: Searches each PATH directory for an executable file
+ *              with the given name.
+ * Arguments: Pointer to char for the command name.
+ * Returns: A newly allocated full path, or NULL if not found.
+ *******************************************************************/
+char* searchPath(const char* name)
+{
+    const char *dir = cmdHash.pathValue;    // Start of the current PATH entry.
+    const char *colon;                      // End of the current PATH entry.
+    size_t size = strlen(cmdHash.pathValue) + strlen(name) + 3;
+    char *candidate = arenaAlloc(&cmdArena, size);  // Stores directory and name joined together.
+    struct stat info;
+    int dirLength;
+
+    while(dir != NULL){
+        colon = strchr(dir, ':');
+        dirLength = (colon != NULL) ? colon - dir : (int)strlen(dir);
+        if(dirLength == 0){
+            snprintf(candidate, size, "./%s", name);  // An empty entry means the working directory.
+        }
+        else{
+            snprintf(candidate, size, "%.*s/%s", dirLength, dir, name);
+        }
+        if(stat(candidate, &info) == 0 && S_ISREG(info.st_mode) && access(candidate, X_OK) == 0){
+            return strdup(candidate);
+        }
+        dir = (colon != NULL) ? colon + 1 : NULL;
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: char* lookupCommand(const char* name)
+ * Description: Resolves a command name to a full path, searching
+ *              PATH only on the first use. The table is cleared
+ *              whenever PATH has changed since it was filled.
+ * Arguments: Pointer to char for the command name.
+ * Returns: The full path, or NULL if the command was not found.
+ *******************************************************************/
+char* lookupCommand(const char* name)
+{
+    const char *pathValue = getVariable("PATH");
+    struct hashedCommand *entry;
+    unsigned int bucket;
+    char *path;
+
+    if(strchr(name, '/') != NULL){
+        return (char*)name;     // Names with a slash are used as given.
+    }
+    if(pathValue == NULL){
+        pathValue = "/bin:/usr/bin";    // Matches the default search used by execvp.
+    }
+    if(cmdHash.pathValue == NULL || strcmp(cmdHash.pathValue, pathValue) != 0){
+        clearHash();
+        cmdHash.pathValue = strdup(pathValue);
+    }
+
+    bucket = hashName(name);
+    for(entry = cmdHash.buckets[bucket]; entry != NULL; entry = entry->next){
+        if(strcmp(entry->name, name) == 0){
+            entry->hits++;
+            return entry->path;
+        }
+    }
+
+    path = searchPath(name);
+    if(path == NULL){
+        return NULL;
+    }
+    entry = malloc(sizeof(struct hashedCommand));
+    entry->name = strdup(name);
+    entry->path = path;
+    entry->hits = 1;
+    entry->next = cmdHash.buckets[bucket];
+    cmdHash.buckets[bucket] = entry;
+    return entry->path;
+}
+
+
+/*******************************************************************
+ * Name: void forgetCommand(const char* name)
+ * Description: Drops a remembered command, such as one whose
+ *              binary has disappeared.
+ * Arguments: Pointer to char for the command name.
+ *******************************************************************/
+void forgetCommand(const char* name)
+{
+    struct hashedCommand **link = &cmdHash.buckets[hashName(name)];
+    struct hashedCommand *entry;
+
+    while((entry = *link) != NULL){
+        if(strcmp(entry->name, name) == 0){
+            *link = entry->next;    // Unlinks the entry from its chain.
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+            return;
+        }
+        link = &entry->next;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void clearHash()
+ * Description: Forgets every remembered command.
+ * Arguments: None.
+ *******************************************************************/
+void clearHash()
+{
+    struct hashedCommand *entry;
+    int i;  // Index for loop.
+
+    for(i = 0; i < HASH_BUCKETS; i++){
+        while((entry = cmdHash.buckets[i]) != NULL){
+            cmdHash.buckets[i] = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+        }
+    }
+    free(cmdHash.pathValue);
+    cmdHash.pathValue = NULL;
+}
+
+
+/*******************************************************************
+ * Name: void hashBuiltin(struct parsedInput* obj)
+ * Description: Handles the "hash" command. With no arguments it
+ *              lists remembered commands, "-r" forgets them all,
+ *              and any names given are looked up and remembered. A
+ *              name with a slash is only checked, never remembered.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void hashBuiltin(struct parsedInput* obj)
+{
+    struct hashedCommand *entry;
+    struct stat info;
+    char *name;
+    bool empty = true;
+    bool found;         // Indicates the current name resolved to an executable.
+    int i;  // Index for loop.
+
+    if(obj->argNum == 1){
+        for(i = 0; i < HASH_BUCKETS; i++){
+            for(entry = cmdHash.buckets[i]; entry != NULL; entry = entry->next){
+                if(empty == true){
+                    printf("hits\tcommand\n");
+                    empty = false;
+                }
+                printf("%4d\t%s\n", entry->hits, entry->path);
+            }
+        }
+        if(empty == true){
+            printf("hash: hash table empty\n");
+        }
+        foregroundValue = 0;
+        return;
+    }
+
+    foregroundValue = 0;
+    for(i = 1; i < obj->argNum; i++){
+        name = obj->arguments[i];
+        if(strcmp(name, "-r") == 0){
+            clearHash();
+            continue;
+        }
+        if(strchr(name, '/') != NULL){
+            found = (stat(name, &info) == 0 && S_ISREG(info.st_mode) && access(name, X_OK) == 0);  // Used as given, so never remembered.
+        }
+        else{
+            forgetCommand(name);    // Re-resolves so the entry reflects the current PATH.
+            found = (lookupCommand(name) != NULL);
+            if(found == true){
+                cmdHash.buckets[hashName(name)]->hits = 0;  // lookupCommand put the new entry first in its chain.
+            }
+        }
+        if(found == false){
+            printf("hash: %s: not found\n", name);
+            foregroundValue = 1 << 8;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void initBuiltins()
+ * Description: Fills the builtin table, an open-addressed hash
+ *              keyed by command name, once at startup.
+ * Arguments: None.
+ *******************************************************************/
+void initBuiltins()
+{
+    unsigned int slot;
+    size_t i;   // Index for loop.
+
+    for(i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++){
+        slot = hashName(builtins[i].name);
+        while(builtinTable[slot] != NULL){
+            slot = (slot + 1) % HASH_BUCKETS;   // Probes the next slot on a collision.
+        }
+        builtinTable[slot] = &builtins[i];
+    }
+}
+
+
+/*******************************************************************
+ * Name: const struct builtinCommand* findBuiltin(const char* name)
+ * Description: Looks a command name up in the builtin table.
+ * Arguments: Pointer to char for the command name.
+ * Returns: The builtin, or NULL if the command must be launched.
+ *******************************************************************/
+const struct builtinCommand* findBuiltin(const char* name)
+{
+    unsigned int slot = hashName(name);
+
+    while(builtinTable[slot] != NULL){
+        if(strcmp(builtinTable[slot]->name, name) == 0){
+            return builtinTable[slot];
+        }
+        slot = (slot + 1) % HASH_BUCKETS;
+    }
+    return NULL;
+}
+
+
+/*******************************************************************
+ * Name: bool runBuiltin(struct parsedInput* obj)
+ * Description: Runs a builtin inside the shell, with redirections
+ *              applied around it for builtins that honor them.
+ * Arguments: A pointer to an parsedInput struct.
+ * Returns: False if the command is not a builtin.
+ *******************************************************************/
+bool runBuiltin(struct parsedInput* obj)
+{
+    const struct builtinCommand *command = findBuiltin(obj->arguments[0]);
+    int saved[3] = {-1, -1, -1};    // The shell's own stdin, stdout and stderr while redirected.
+
+    if(command == NULL){
+        return false;
+    }
+    if(command->redirects == false){
+        command->run(obj);
+        return true;
+    }
+    if(redirectShell(obj, saved) == false){
+        foregroundValue = 1 << 8;
+        return true;
+    }
+    command->run(obj);
+    restoreShell(saved);
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool redirectShell(struct parsedInput* obj, int* saved)
+ * Description: Applies a command's redirections to the shell
+ *              itself, for a builtin or function. The files are
+ *              opened as for a child and dup'd over stdin, stdout
+ *              and stderr, keeping copies of the originals.
+ * Arguments: A pointer to an parsedInput struct and a pointer to
+ *            three ints that receive the saved descriptors, or -1.
+ * Returns: False if a file could not be opened.
+ *******************************************************************/
+bool redirectShell(struct parsedInput* obj, int* saved)
+{
+    int base[3] = {-1, -1, -1};     // Builtins start from the shell's own descriptors.
+    struct fdPlan plan;             // Redirected file descriptors.
+    int i;                          // Index for loop; doubles as the descriptor replaced.
+
+    if(obj->redirectNum == 0){
+        return true;
+    }
+    if(redirectIO(obj, base, &plan) != 0){
+        return false;
+    }
+    fflush(stdout);     // Keeps earlier output out of the redirected file.
+    for(i = 0; i < 3; i++){
+        if(plan.fds[i] != -1){
+            saved[i] = fcntl(i, F_DUPFD_CLOEXEC, 10);
+            dup2(plan.fds[i], i);
+        }
+    }
+    closePlan(&plan);
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void restoreShell(int* saved)
+ * Description: Puts back the descriptors redirectShell replaced.
+ * Arguments: A pointer to the three saved descriptors, or -1.
+ *******************************************************************/
+void restoreShell(int* saved)
+{
+    int i;  // Index for loop; doubles as the descriptor restored.
+
+    if(saved[0] == -1 && saved[1] == -1 && saved[2] == -1){
+        return;     // Nothing was redirected.
+    }
+    fflush(stdout);     // Writes the output before stdout is restored.
+    for(i = 0; i < 3; i++){
+        if(saved[i] != -1){
+            dup2(saved[i], i);
+            close(saved[i]);
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void exitBuiltin(struct parsedInput* obj)
+ * Description: Handles "exit [n]" by ending background processes and
+ *              exiting from the shell with n, or with the status of
+ *              the last command when n is left out. A non-numeric n
+ *              exits with 2 after an error; a second argument is an
+ *              error and the shell keeps running.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void exitBuiltin(struct parsedInput* obj)
+{
+    int value = exitValue();
+    char *end;
+    long long number;
+
+    if(obj->argNum > 1){
+        errno = 0;
+        number = strtoll(obj->arguments[1], &end, 10);
+        if(end == obj->arguments[1] || *end != '\0' || errno != 0){
+            printf("exit: %s: numeric argument required\n", obj->arguments[1]);
+            value = 2;
+        }
+        else if(obj->argNum > 2){
+            printf("exit: too many arguments\n");
+            foregroundValue = 1 << 8;
+            return;
+        }
+        else{
+            value = number & 0xff;  // Keeps the low byte, as wait reports it.
+        }
+    }
+    endProcess();
+    exit(value);
+}
+
+
+/*******************************************************************
+ * Name: void cdBuiltin(struct parsedInput* obj)
+ * Description: Handles "cd" to change directories.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void cdBuiltin(struct parsedInput* obj)
+{
+    foregroundValue = changeDir(obj->arguments[1]) << 8;
+    if(pool.helper > 0){
+        close(pool.cwdFd);
+        pool.cwdFd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);   // Workers change to this before exec.
+    }
+}
+
+
+/*******************************************************************
+ * Name: void statusBuiltin(struct parsedInput* obj)
+ * Description: Handles "status" by printing the last exit value
+ *              from the foreground.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void statusBuiltin(struct parsedInput* obj)
+{
+    int fgStatus;   // Stores exit status or signal used to terminate.
+
+    if(WEXITSTATUS(foregroundValue)){
+        fgStatus = WEXITSTATUS(foregroundValue);    // Tests if process exited.
+    }
+    else{
+        fgStatus = WTERMSIG(foregroundValue); // Tests if process was terminated by a signal.
+    }
+    printf("exit value %d\n", fgStatus);
+}
+
+
+/*******************************************************************
+ * Name: void exportBuiltin(struct parsedInput* obj)
+ * Description: Handles "export NAME[=value] ...", which passes the
+ *              variables to commands from now on. Without arguments
+ *              lists the exported variables.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void exportBuiltin(struct parsedInput* obj)
+{
+    char *word;
+    size_t length;
+    int i;      // Index for loop.
+
+    foregroundValue = 0;
+    if(obj->argNum == 1){
+        for(i = 0; i < vars.envCount; i++){
+            printf("export %s\n", vars.envp[i]);
+        }
+        return;
+    }
+    for(i = 1; i < obj->argNum; i++){
+        word = obj->arguments[i];
+        length = strcspn(word, "=");
+        if(validName(word, length) == false){
+            printf("export: %s: not a valid identifier\n", word);
+            foregroundValue = 1 << 8;
+            continue;
+        }
+        if(word[length] == '='){
+            setVariable(word, length, word + length + 1);
+        }
+        exportVariable(findVariable(word, length, true));
+    }
+}
+
+
+/*******************************************************************
+ * Name: void unsetBuiltin(struct parsedInput* obj)
+ * Description: Handles "unset NAME ...", which removes the variables
+ *              from the shell and from the environment.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void unsetBuiltin(struct parsedInput* obj)
+{
+    int i;      // Index for loop.
+
+    foregroundValue = 0;
+    for(i = 1; i < obj->argNum; i++){
+        if(validName(obj->arguments[i], strlen(obj->arguments[i])) == false){
+            printf("unset: %s: not a valid identifier\n", obj->arguments[i]);
+            foregroundValue = 1 << 8;
+            continue;
+        }
+        unsetVariable(obj->arguments[i]);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void trueBuiltin(struct parsedInput* obj)
+ * Description: Handles "true", which only succeeds.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void trueBuiltin(struct parsedInput* obj)
+{
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: void falseBuiltin(struct parsedInput* obj)
+ * Description: Handles "false", which only fails.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void falseBuiltin(struct parsedInput* obj)
+{
+    foregroundValue = 1 << 8;
+}
+
+
+/*******************************************************************
+ * Name: void pwdBuiltin(struct parsedInput* obj)
+ * Description: Handles "pwd" by printing the working directory.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void pwdBuiltin(struct parsedInput* obj)
+{
+    char *directory = getcwd(NULL, 0);
+
+    if(directory == NULL){
+        perror("pwd");
+        foregroundValue = 1 << 8;
+        return;
+    }
+    printf("%s\n", directory);
+    free(directory);
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: const char* printEscape(const char* text, bool* stop)
+ * Description: Prints the backslash escape at text, as echo -e and
+ *              printf understand them, including octal "\0nnn" and
+ *              hexadecimal "\xHH". "\c" asks for output to stop.
+ * Arguments: Pointer to char at the backslash and a pointer to a
+ *            bool set when output should stop.
+ * Returns: Pointer to the last character of the escape.
+ *******************************************************************/
+const char* printEscape(const char* text, bool* stop)
+{
+    static const char codes[] = "abefnrtv\\";       // Letters after a backslash...
+    static const char values[] = "\a\b\033\f\n\r\t\v\\";    // ...and what they stand for.
+    const char *code = NULL;
+    int value = 0;
+    int digits = 0;
+
+    text++;
+    if(*text != '\0'){
+        code = strchr(codes, *text);
+    }
+    if(code != NULL){
+        putchar(values[code - codes]);
+        return text;
+    }
+    if(*text == 'c'){
+        *stop = true;
+        return text;
+    }
+    if(*text >= '0' && *text <= '7'){
+        /* Reads up to three octal digits, after an optional leading 0. */
+        if(*text == '0'){
+            text++;
+        }
+        while(digits < 3 && *text >= '0' && *text <= '7'){
+            value = value * 8 + (*text++ - '0');
+            digits++;
+        }
+        putchar(value);
+        return text - 1;
+    }
+    if(*text == 'x' && isxdigit((unsigned char)text[1])){
+        /* Reads up to two hexadecimal digits. */
+        text++;
+        while(digits < 2 && isxdigit((unsigned char)*text)){
+            value = value * 16 + (isdigit((unsigned char)*text) ? *text - '0' : tolower((unsigned char)*text) - 'a' + 10);
+            text++;
+            digits++;
+        }
+        putchar(value);
+        return text - 1;
+    }
+    putchar('\\');  // Keeps an unknown escape as it was written.
+    if(*text == '\0'){
+        return text - 1;
+    }
+    putchar(*text);
+    return text;
+}
+
+
+/*******************************************************************
+ * Name: void echoBuiltin(struct parsedInput* obj)
+ * Description: Handles "echo [-neE] [arguments]". -n leaves off the
+ *              newline and -e interprets backslash escapes.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void echoBuiltin(struct parsedInput* obj)
+{
+    bool newline = true;
+    bool escapes = false;
+    bool stop = false;      // Set by "\c".
+    const char *text;
+    int first = 1;          // Index of the first argument printed.
+    int i;                  // Index for loop.
+
+    /* Takes leading words made only of n, e and E as options. */
+    while(first < obj->argNum && obj->arguments[first][0] == '-' && obj->arguments[first][1] != '\0' &&
+          strspn(obj->arguments[first] + 1, "neE") == strlen(obj->arguments[first] + 1)){
+        for(text = obj->arguments[first] + 1; *text != '\0'; text++){
+            if(*text == 'n'){
+                newline = false;
+            }
+            else{
+                escapes = (*text == 'e');
+            }
+        }
+        first++;
+    }
+
+    for(i = first; i < obj->argNum && stop == false; i++){
+        if(i > first){
+            putchar(' ');
+        }
+        if(escapes == false){
+            fputs(obj->arguments[i], stdout);
+            continue;
+        }
+        for(text = obj->arguments[i]; *text != '\0' && stop == false; text++){
+            if(*text == '\\'){
+                text = printEscape(text, &stop);
+            }
+            else{
+                putchar(*text);
+            }
+        }
+    }
+    if(newline == true && stop == false){
+        putchar('\n');
+    }
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: bool printfNumber(const char* text, char conversion,
+ *                         long long* integer, double* real)
+ * Description: Reads a numeric argument for a printf conversion. A
+ *              leading quote stands for the code of the character
+ *              after it, and a missing or empty argument is 0.
+ * Arguments: Pointer to char for the argument, or NULL, the
+ *            conversion letter, and pointers that receive the value
+ *            as an integer and as a double.
+ * Returns: False after printing an error when the argument is not a
+ *          whole number; the value read up to the bad part is kept.
+ *******************************************************************/
+bool printfNumber(const char* text, char conversion, long long* integer, double* real)
+{
+    char *end;
+
+    *integer = 0;
+    *real = 0;
+    if(text == NULL || text[0] == '\0'){
+        return true;
+    }
+    if(text[0] == '\'' || text[0] == '"'){
+        *integer = (unsigned char)text[1];
+        *real = *integer;
+        return true;
+    }
+
+    errno = 0;
+    if(strchr("fFeEgGaA", conversion) != NULL){
+        *real = strtod(text, &end);
+    }
+    else if(strchr("uoxX", conversion) != NULL){
+        *integer = (long long)strtoull(text, &end, 0);     // Wraps negative values the way C does.
+    }
+    else{
+        *integer = strtoll(text, &end, 0);
+    }
+    if(end == text || *end != '\0' || errno != 0){
+        printf("printf: %s: invalid number\n", text);
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void printfBuiltin(struct parsedInput* obj)
+ * Description: Handles "printf format [arguments]". Supports the
+ *              d, i, u, o, x, X, f, F, e, E, g, G, a, A, c, s and b
+ *              conversions with flags, width and precision, either
+ *              of which may be '*' to take it from an argument, and
+ *              reuses the format until every argument has been
+ *              consumed. A bad number sets status 1.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void printfBuiltin(struct parsedInput* obj)
+{
+    const char *format;
+    const char *text;
+    const char *argument;
+    char spec[64];          // One conversion, rewritten for the C printf.
+    size_t length;          // Length of spec so far.
+    long long integer;
+    double real;
+    bool stop = false;      // Set by "\c".
+    bool valid;             // Cleared when spec will not fit or the conversion is unknown.
+    int next = 2;           // Next argument to consume.
+    int first;              // First argument consumed by this pass over the format.
+
+    if(obj->argNum < 2){
+        printf("usage: printf format [arguments]\n");
+        foregroundValue = 2 << 8;
+        return;
+    }
+    format = obj->arguments[1];
+    foregroundValue = 0;
+
+    do{
+        first = next;
+        for(text = format; *text != '\0' && stop == false; text++){
+            if(*text == '\\'){
+                text = printEscape(text, &stop);
+                continue;
+            }
+            if(*text != '%'){
+                putchar(*text);
+                continue;
+            }
+            if(text[1] == '%'){
+                putchar('%');
+                text++;
+                continue;
+            }
+
+            /* Copies the flags, width and precision, filling in each '*' from the next argument. */
+            spec[0] = '%';
+            length = 1;
+            valid = true;
+            for(text++; *text != '\0' && strchr("-+ #0", *text) != NULL && valid; text++){
+                spec[length++] = *text;
+                valid = (length < sizeof(spec) - 24);
+            }
+            if(*text == '*'){
+                argument = (next < obj->argNum) ? obj->arguments[next++] : NULL;
+                if(printfNumber(argument, 'd', &integer, &real) == false){
+                    foregroundValue = 1 << 8;
+                }
+                length += sprintf(spec + length, "%d", (int)integer);
+                text++;
+            }
+            for(; isdigit((unsigned char)*text) && valid; text++){
+                spec[length++] = *text;
+                valid = (length < sizeof(spec) - 24);
+            }
+            if(*text == '.'){
+                text++;
+                if(*text == '*'){
+                    argument = (next < obj->argNum) ? obj->arguments[next++] : NULL;
+                    if(printfNumber(argument, 'd', &integer, &real) == false){
+                        foregroundValue = 1 << 8;
+                    }
+                    if(integer >= 0){       // A negative precision counts as none.
+                        length += sprintf(spec + length, ".%d", (int)integer);
+                    }
+                    text++;
+                }
+                else{
+                    spec[length++] = '.';
+                    for(; isdigit((unsigned char)*text) && valid; text++){
+                        spec[length++] = *text;
+                        valid = (length < sizeof(spec) - 24);
+                    }
+                }
+            }
+            if(valid == false || *text == '\0' || strchr("diuoxXfFeEgGaAcsb", *text) == NULL){
+                printf("printf: invalid conversion in \"%s\"\n", format);
+                foregroundValue = 1 << 8;
+                return;
+            }
+            argument = (next < obj->argNum) ? obj->arguments[next++] : NULL;
+
+            switch(*text)
+            {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    if(printfNumber(argument, *text, &integer, &real) == false){
+                        foregroundValue = 1 << 8;
+                    }
+                    spec[length++] = 'l';
+                    spec[length++] = 'l';
+                    spec[length++] = (*text == 'i') ? 'd' : *text;
+                    spec[length] = '\0';
+                    printf(spec, integer);
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    if(printfNumber(argument, *text, &integer, &real) == false){
+                        foregroundValue = 1 << 8;
+                    }
+                    spec[length++] = *text;
+                    spec[length] = '\0';
+                    printf(spec, real);
+                    break;
+                case 'c':
+                    strcpy(spec + length, "c");
+                    if(argument != NULL && argument[0] != '\0'){
+                        printf(spec, argument[0]);
+                    }
+                    break;
+                case 's':
+                    strcpy(spec + length, "s");
+                    printf(spec, (argument != NULL) ? argument : "");
+                    break;
+                case 'b':
+                    /* Prints the argument with its backslash escapes interpreted. */
+                    for(argument = (argument != NULL) ? argument : ""; *argument != '\0' && stop == false; argument++){
+                        if(*argument == '\\'){
+                            argument = printEscape(argument, &stop);
+                        }
+                        else{
+                            putchar(*argument);
+                        }
+                    }
+                    break;
+            }
+        }
+    } while(stop == false && next < obj->argNum && next > first);
+}
+
+
+/*******************************************************************
+ * Name: int testNumber(const char* text, long long* value)
+ * Description: Reads an integer operand for "test".
+ * Arguments: Pointer to char for the operand and a pointer that
+ *            receives its value.
+ * Returns: 0 if the operand is an integer, otherwise 2 after
+ *          printing an error.
+ *******************************************************************/
+int testNumber(const char* text, long long* value)
+{
+    char *end;
+
+    errno = 0;
+    *value = strtoll(text, &end, 10);
+    while(isspace((unsigned char)*end)){
+        end++;
+    }
+    if(end == text || *end != '\0' || errno != 0){
+        printf("test: %s: integer expression expected\n", text);
+        return 2;
+    }
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: bool isUnaryTest(const char* op)
+ * Description: Tells whether op is a unary "test" operator.
+ * Arguments: Pointer to char for the word.
+ * Returns: True for -n -z -e -f -d -s -L -h -r -w -x.
+ *******************************************************************/
+bool isUnaryTest(const char* op)
+{
+    return op[0] == '-' && op[1] != '\0' && op[2] == '\0' && strchr("nzefdsLhrwx", op[1]) != NULL;
+}
+
+
+/*******************************************************************
+ * Name: bool isBinaryTest(const char* op)
+ * Description: Tells whether op is a binary "test" operator other
+ *              than -a and -o.
+ * Arguments: Pointer to char for the word.
+ * Returns: True for = == != -eq -ne -lt -le -gt -ge.
+ *******************************************************************/
+bool isBinaryTest(const char* op)
+{
+    if(strcmp(op, "=") == 0 || strcmp(op, "==") == 0 || strcmp(op, "!=") == 0){
+        return true;
+    }
+    return op[0] == '-' && strlen(op) == 3 && strstr("-eq-ne-lt-le-gt-ge", op) != NULL;
+}
+
+
+/*******************************************************************
+ * Name: int unaryTest(const char* op, const char* operand)
+ * Description: Evaluates a unary "test" operator: the file tests
+ *              -e -f -d -r -w -x -s -L -h and the string tests -n
+ *              and -z.
+ * Arguments: Pointers to char for the operator and its operand.
+ * Returns: 0 when true, 1 when false, 2 for an unknown operator.
+ *******************************************************************/
+int unaryTest(const char* op, const char* operand)
+{
+    struct stat info;
+
+    if(isUnaryTest(op) == false){
+        printf("test: %s: unary operator expected\n", op);
+        return 2;
+    }
+    switch(op[1])
+    {
+        case 'n': return (operand[0] != '\0') ? 0 : 1;
+        case 'z': return (operand[0] == '\0') ? 0 : 1;
+        case 'e': return (stat(operand, &info) == 0) ? 0 : 1;
+        case 'f': return (stat(operand, &info) == 0 && S_ISREG(info.st_mode)) ? 0 : 1;
+        case 'd': return (stat(operand, &info) == 0 && S_ISDIR(info.st_mode)) ? 0 : 1;
+        case 's': return (stat(operand, &info) == 0 && info.st_size > 0) ? 0 : 1;
+        case 'L':
+        case 'h': return (lstat(operand, &info) == 0 && S_ISLNK(info.st_mode)) ? 0 : 1;
+        case 'r': return (access(operand, R_OK) == 0) ? 0 : 1;
+        case 'w': return (access(operand, W_OK) == 0) ? 0 : 1;
+    }
+    return (access(operand, X_OK) == 0) ? 0 : 1;
+}
+
+
+/*******************************************************************
+ * Name: int binaryTest(const char* left, const char* op, const char* right)
+ * Description: Evaluates a binary "test" operator: the string tests
+ *              = == != and the integer comparisons -eq -ne -lt -le
+ *              -gt -ge.
+ * Arguments: Pointers to char for the operands and the operator.
+ * Returns: 0 when true, 1 when false, 2 on an unknown operator or a
+ *          bad integer.
+ *******************************************************************/
+int binaryTest(const char* left, const char* op, const char* right)
+{
+    long long leftValue;
+    long long rightValue;
+
+    if(strcmp(op, "=") == 0 || strcmp(op, "==") == 0){
+        return (strcmp(left, right) == 0) ? 0 : 1;
+    }
+    if(strcmp(op, "!=") == 0){
+        return (strcmp(left, right) != 0) ? 0 : 1;
+    }
+    if(isBinaryTest(op) == false){
+        printf("test: %s: binary operator expected\n", op);
+        return 2;
+    }
+    if(testNumber(left, &leftValue) != 0 || testNumber(right, &rightValue) != 0){
+        return 2;
+    }
+    switch(op[1] * 256 + op[2])
+    {
+        case 'e' * 256 + 'q': return (leftValue == rightValue) ? 0 : 1;
+        case 'n' * 256 + 'e': return (leftValue != rightValue) ? 0 : 1;
+        case 'l' * 256 + 't': return (leftValue < rightValue) ? 0 : 1;
+        case 'l' * 256 + 'e': return (leftValue <= rightValue) ? 0 : 1;
+        case 'g' * 256 + 't': return (leftValue > rightValue) ? 0 : 1;
+    }
+    return (leftValue >= rightValue) ? 0 : 1;
+}
+
+
+/*******************************************************************
+ * Name: int parseTest(char** args, int count, int* pos, int level)
+ * Description: Evaluates the "test" expression starting at args[*pos]
+ *              by recursive descent. Level 0 joins terms with -o,
+ *              level 1 joins factors with -a, which binds tighter,
+ *              and level 2 reads '!', a parenthesized expression or
+ *              one primary.
+ * Arguments: A pointer to the operands and their count, a pointer to
+ *            the index of the next one, advanced past what is read,
+ *            and the level to parse at.
+ * Returns: 0 when true, 1 when false, 2 on a malformed expression.
+ *******************************************************************/
+int parseTest(char** args, int count, int* pos, int level)
+{
+    const char *join = (level == 0) ? "-o" : "-a";
+    int result;
+    int other;
+
+    if(level < 2){
+        result = parseTest(args, count, pos, level + 1);
+        while(result != 2 && *pos < count && strcmp(args[*pos], join) == 0){
+            (*pos)++;
+            other = parseTest(args, count, pos, level + 1);
+            if(other == 2){
+                return 2;
+            }
+            if(level == 0){
+                result = (result == 0 || other == 0) ? 0 : 1;
+            }
+            else{
+                result = (result == 0 && other == 0) ? 0 : 1;
+            }
+        }
+        return result;
+    }
+
+    if(*pos >= count){
+        printf("test: argument expected\n");
+        return 2;
+    }
+    if(strcmp(args[*pos], "!") == 0){
+        (*pos)++;
+        result = parseTest(args, count, pos, 2);
+        return (result == 2) ? 2 : !result;
+    }
+    if(strcmp(args[*pos], "(") == 0){
+        (*pos)++;
+        result = parseTest(args, count, pos, 0);
+        if(result == 2){
+            return 2;
+        }
+        if(*pos >= count || strcmp(args[*pos], ")") != 0){
+            printf("test: ')' expected\n");
+            return 2;
+        }
+        (*pos)++;
+        return result;
+    }
+    if(count - *pos >= 3 && isBinaryTest(args[*pos + 1])){
+        *pos += 3;
+        return binaryTest(args[*pos - 3], args[*pos - 2], args[*pos - 1]);
+    }
+    if(count - *pos >= 2 && isUnaryTest(args[*pos])){
+        *pos += 2;
+        return unaryTest(args[*pos - 2], args[*pos - 1]);
+    }
+    (*pos)++;
+    return (args[*pos - 1][0] != '\0') ? 0 : 1;     // A lone string is true when not empty.
+}
+
+
+/*******************************************************************
+ * Name: int evalTest(char** args, int count)
+ * Description: Evaluates a "test" expression. Up to four operands
+ *              follow the POSIX rules that go by their count, so an
+ *              operand that looks like an operator is still read as
+ *              a string where it must be one; longer expressions
+ *              are parsed with '!', -a, -o and parentheses.
+ * Arguments: A pointer to the operands and their count.
+ * Returns: 0 when true, 1 when false, 2 on a malformed expression.
+ *******************************************************************/
+int evalTest(char** args, int count)
+{
+    int result;
+    int pos = 0;
+
+    switch(count)
+    {
+        case 0:
+            return 1;
+        case 1:
+            return (args[0][0] != '\0') ? 0 : 1;
+        case 2:
+            if(strcmp(args[0], "!") == 0){
+                return !evalTest(args + 1, 1);
+            }
+            return unaryTest(args[0], args[1]);
+        case 3:
+            if(isBinaryTest(args[1])){
+                return binaryTest(args[0], args[1], args[2]);
+            }
+            if(strcmp(args[1], "-a") == 0){
+                return (args[0][0] != '\0' && args[2][0] != '\0') ? 0 : 1;
+            }
+            if(strcmp(args[1], "-o") == 0){
+                return (args[0][0] != '\0' || args[2][0] != '\0') ? 0 : 1;
+            }
+            if(strcmp(args[0], "!") == 0){
+                result = evalTest(args + 1, 2);
+                return (result == 2) ? 2 : !result;
+            }
+            if(strcmp(args[0], "(") == 0 && strcmp(args[2], ")") == 0){
+                return evalTest(args + 1, 1);
+            }
+            printf("test: %s: binary operator expected\n", args[1]);
+            return 2;
+        case 4:
+            if(strcmp(args[0], "!") == 0){
+                result = evalTest(args + 1, 3);
+                return (result == 2) ? 2 : !result;
+            }
+            if(strcmp(args[0], "(") == 0 && strcmp(args[3], ")") == 0){
+                return evalTest(args + 1, 2);
+            }
+            break;
+    }
+
+    result = parseTest(args, count, &pos, 0);
+    if(result != 2 && pos < count){
+        printf("test: %s: unexpected argument\n", args[pos]);
+        return 2;
+    }
+    return result;
+}
+
+
+/*******************************************************************
+ * Name: void testBuiltin(struct parsedInput* obj)
+ * Description: Handles "test expression" and "[ expression ]".
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void testBuiltin(struct parsedInput* obj)
+{
+    int count = obj->argNum - 1;
+
+    if(strcmp(obj->arguments[0], "[") == 0){
+        if(count == 0 || strcmp(obj->arguments[count], "]") != 0){
+            printf("[: missing ]\n");
+            foregroundValue = 2 << 8;
+            return;
+        }
+        count--;    // Leaves the closing bracket out of the expression.
+    }
+    foregroundValue = evalTest(obj->arguments + 1, count) << 8;
+}
+
+
+/*******************************************************************
+ * Name: void loopBuiltin(struct parsedInput* obj)
+ * Description: Handles "break [n]" and "continue [n]", which leave
+ *              the n innermost loops, going on with the next pass
+ *              of the last one for "continue".
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void loopBuiltin(struct parsedInput* obj)
+{
+    int levels = (obj->argNum > 1) ? atoi(obj->arguments[1]) : 1;
+
+    if(loopDepth == 0){
+        printf("%s: only meaningful in a loop\n", obj->arguments[0]);
+        foregroundValue = 1 << 8;
+        return;
+    }
+    if(levels < 1){
+        printf("%s: %s: loop count out of range\n", obj->arguments[0], obj->arguments[1]);
+        foregroundValue = 1 << 8;
+        return;
+    }
+    breakLevels = (levels < loopDepth) ? levels : loopDepth;
+    continuing = (strcmp(obj->arguments[0], "continue") == 0);
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: void returnBuiltin(struct parsedInput* obj)
+ * Description: Handles "return [n]", which leaves the function
+ *              being run with status n, or with the last status.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void returnBuiltin(struct parsedInput* obj)
+{
+    if(functionDepth == 0){
+        printf("return: can only return from a function\n");
+        foregroundValue = 1 << 8;
+        return;
+    }
+    if(obj->argNum > 1){
+        foregroundValue = (atoi(obj->arguments[1]) & 0xff) << 8;
+    }
+    returning = true;
+}
+
+
+/*******************************************************************
+ * Name: int redirectIO(struct parsedInput* obj, int* base,
+ *                      struct fdPlan* plan)
+ * Description: Handles redirection by opening every file in the
+ *              shell, so each launch path only has to duplicate
+ *              plan->fds onto stdin, stdout and stderr. Redirections
+ *              apply left to right, so "2>&1 >f" and ">f 2>&1"
+ *              differ as they should. A descriptor copied from one
+ *              the shell itself holds open is first duplicated
+ *              above 2, which makes the order of the child's dup2
+ *              calls irrelevant. Here-strings are written to a
+ *              memfd. Everything is opened close-on-exec.
+ * Arguments: A pointer to an parsedInput struct, a pointer to
+ *            three ints for the descriptors the command receives
+ *            before its own redirections (-1 to inherit), and a
+ *            pointer to an fdPlan struct to fill in.
+ * Returns: 0 on success, or 1 if a file could not be opened.
+ *******************************************************************/
+int redirectIO(struct parsedInput* obj, int* base, struct fdPlan* plan)
+{
+    struct redirect *current;
+    int fd;
+    int i;      // Index for loop.
+
+    memcpy(plan->fds, base, sizeof(plan->fds));
+    plan->openedNum = 0;
+    plan->opened = NULL;
+    if(obj->redirectNum > 0){
+        plan->opened = arenaAlloc(&cmdArena, obj->redirectNum * sizeof(int));
+    }
+
+    for(i = 0; i < obj->redirectNum; i++){
+        current = &obj->redirects[i];
+        switch(current->kind)
+        {
+            case REDIR_IN:
+                fd = open(current->target, O_RDONLY | O_CLOEXEC);
+                if(fd < 0){
+                    printf("cannot open file for input\n");
+                }
+                break;
+            case REDIR_OUT:
+            case REDIR_BOTH:
+                fd = open(current->target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if(fd < 0){
+                    printf("Error opening or creating file\n");
+                }
+                break;
+            case REDIR_APPEND:
+                fd = open(current->target, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+                if(fd < 0){
+                    printf("Error opening or creating file\n");
+                }
+                break;
+            case REDIR_STRING:
+                fd = memfd_create("herestring", MFD_CLOEXEC);
+                if(fd < 0 || write(fd, current->target, strlen(current->target)) < 0
+                        || write(fd, "\n", 1) != 1 || lseek(fd, 0, SEEK_SET) != 0){
+                    printf("cannot create here-string\n");
+                    if(fd >= 0){
+                        close(fd);
+                        fd = -1;
+                    }
+                }
+                break;
+            default:    // REDIR_DUP; the parser only accepts 0, 1 and 2.
+                fd = plan->fds[current->target[0] - '0'];
+                if(fd != -1){
+                    plan->fds[current->fd] = fd;    // Shares a descriptor already in the plan.
+                    continue;
+                }
+                fd = fcntl(current->target[0] - '0', F_DUPFD_CLOEXEC, 3);
+                if(fd < 0){
+                    printf("%s: bad file descriptor\n", current->target);
+                }
+                break;
+        }
+        if(fd < 0){
+            closePlan(plan);
+            return 1;
+        }
+        plan->opened[plan->openedNum++] = fd;
+        plan->fds[current->fd] = fd;
+        if(current->kind == REDIR_BOTH){
+            plan->fds[2] = fd;
+        }
+    }
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: void closePlan(struct fdPlan* plan)
+ * Description: Closes the descriptors redirectIO opened, once the
+ *              child or builtin no longer needs them.
+ * Arguments: A pointer to an fdPlan struct.
+ *******************************************************************/
+void closePlan(struct fdPlan* plan)
+{
+    int i;      // Index for loop.
+
+    for(i = 0; i < plan->openedNum; i++){
+        close(plan->opened[i]);
+    }
+    plan->openedNum = 0;
+}
+
+
+/*******************************************************************
+ * Name: pid_t spawnChild(char* path, char** argList, int* fds,
+ *                        pid_t pgid)
+ * Description: Launches a command with posix_spawn, which avoids
+ *              copying the shell's page tables. Redirected files
+ *              are duplicated onto stdin, stdout and stderr by file
+ *              actions, and the process group is set by the spawn
+ *              attributes.
+ *              If a remembered binary has disappeared, the command
+ *              is looked up again once.
+ * Arguments: Pointer to char for the resolved path, a pointer to
+ *            the argument list, a pointer to the three file
+ *            descriptors from redirectIO, and a pid_t for the
+ *            process group to join, 0 for a new one, or -1 for the
+ *            shell's.
+ * Returns: The child's pid, or -1 if the command could not start.
+ *******************************************************************/
+pid_t spawnChild(char* path, char** argList, int* fds, pid_t pgid)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+    sigset_t defaults;  // Signals the shell ignores for job control, restored for the command.
+    short flags = POSIX_SPAWN_SETSIGDEF;
+    pid_t pid;
+    int result;
+    int i;      // Index for loop; doubles as the descriptor replaced.
+
+    posix_spawn_file_actions_init(&actions);
+    for(i = 0; i < 3; i++){
+        if(fds[i] != -1){
+            posix_spawn_file_actions_adddup2(&actions, fds[i], i);  // Redirects stdin, stdout or stderr.
+        }
+    }
+    posix_spawnattr_init(&attributes);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGTTIN);
+    sigaddset(&defaults, SIGTTOU);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    if(pgid != -1){
+        posix_spawnattr_setpgroup(&attributes, pgid);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attributes, flags);
+
+    result = posix_spawn(&pid, path, &actions, &attributes, argList, environ);
+    if(result == ENOENT && path != argList[0]){
+        forgetCommand(argList[0]);  // Binary moved or was removed since it was remembered.
+        path = lookupCommand(argList[0]);
+        if(path != NULL){
+            result = posix_spawn(&pid, path, &actions, &attributes, argList, environ);
+        }
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+
+    if(result != 0){
+        printf("%s: No such file or directory\n", argList[0]);
+        return -1;
+    }
+    return pid;
+}
+
+
+/*******************************************************************
+ * Name: pid_t forkChild(char* path, char** argList, int* fds,
+ *                       pid_t pgid)
+ * Description: Launches a command with fork and execv. Used when
+ *              the shell is started with -f, and for any command
+ *              with a "ulimit" prefix, whose limits the child sets
+ *              before exec. If a remembered binary has disappeared,
+ *              the child falls back to execvp.
+ * Arguments: Pointer to char for the resolved path, a pointer to
+ *            the argument list, a pointer to the three file
+ *            descriptors from redirectIO, and a pid_t for the
+ *            process group to join, 0 for a new one, or -1 for the
+ *            shell's.
+ * Returns: The child's pid.
+ *******************************************************************/
+pid_t forkChild(char* path, char** argList, int* fds, pid_t pgid)
+{
+    pid_t pid = fork();
+    int i;      // Index for loop; doubles as the descriptor replaced.
+
+    switch(pid)
+    {
+        /* If value returns as -1, then there was an error in the fork. */
+        case -1:
+            printf("Something went wrong with fork()\n");
+            exit(1);
+            break;
+
+        /* If value returns as 0, then this is a child process. */
+        case 0:
+            if(pgid != -1){
+                setpgid(0, pgid);
+            }
+            signal(SIGTTIN, SIG_DFL);   // Ignored by the shell for job control only.
+            signal(SIGTTOU, SIG_DFL);
+            if(cmdLimitNum > 0 && applyLimits(cmdLimits, cmdLimitNum) == false){
+                exit(1);
+            }
+            for(i = 0; i < 3; i++){
+                if(fds[i] != -1){
+                    dup2(fds[i], i);    // Duplicates file descriptor to redirect stdin, stdout or stderr.
+                }
+            }
+            execv(path, argList);       // Replaces current process with command.
+            execvp(argList[0], argList); // Searches PATH again if the remembered binary is gone.
+            printf("%s: No such file or directory\n", argList[0]);
+            exit(1);
+            break;
+    }
+    if(pgid != -1){
+        setpgid(pid, (pgid == 0) ? pid : pgid);     // Also set here, so the group exists before the terminal is handed over.
+    }
+    return pid;
+}
+
+
+/*******************************************************************
+ * Name: void startHelper()
+ * Description: Forks the long-lived helper while the shell is still
+ *              small, asks it for a full pool of workers, and opens
+ *              the working directory handed to each launch.
+ * Arguments: None.
+ *******************************************************************/
+void startHelper()
+{
+    int sockets[2];     // The shell's end and the helper's end of the control socket.
+    char request[WORKER_POOL];
+
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0){
+        perror("socketpair");
+        exit(1);
+    }
+    fflush(stdout);     // Keeps buffered output from being written twice.
+    pool.helper = fork();
+    if(pool.helper == -1){
+        perror("fork");
+        exit(1);
+    }
+    if(pool.helper == 0){
+        close(sockets[0]);
+        runHelper(sockets[1]);
+    }
+    close(sockets[1]);
+    pool.control = sockets[0];
+    pool.cwdFd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+
+    memset(request, 'w', sizeof(request));
+    send(pool.control, request, sizeof(request), MSG_DONTWAIT);   // One byte per worker wanted.
+    pool.requested = WORKER_POOL;
+}
+
+
+/*******************************************************************
+ * Name: void runHelper(int control)
+ * Description: Runs in the helper. Each request is one record
+ *              holding a byte per worker wanted, read whole since
+ *              the rest of a record is lost. For every byte it
+ *              creates a worker with CLONE_PARENT, so the worker is
+ *              the shell's child rather than the helper's, and
+ *              sends the shell its pid and its end of the worker's
+ *              launch socket. Forking this small process keeps the
+ *              cost of each worker out of the shell's own memory.
+ * Arguments: An int for the helper's end of the control socket.
+ *******************************************************************/
+void runHelper(int control)
+{
+    char request[WORKER_POOL];
+    char attachment[CMSG_SPACE(sizeof(int))];
+    struct iovec data;
+    struct msghdr header;
+    struct cmsghdr *attached;
+    int sockets[2];     // The shell's end and the worker's end of the launch socket.
+    ssize_t length;
+    ssize_t i;  // Index for loop.
+    pid_t pid;
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL);   // Never outlives the shell.
+    signal(SIGINT, SIG_IGN);            // ^C and ^Z are meant for the shell and its commands.
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGCHLD, SIG_DFL);
+
+    while(true){
+        length = recv(control, request, sizeof(request), 0);    // One record holds a byte per worker wanted.
+        if(length < 0 && errno == EINTR){
+            continue;
+        }
+        if(length <= 0){
+            break;  // The shell exited.
+        }
+        for(i = 0; i < length; i++){
+            if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0){
+                continue;
+            }
+            pid = syscall(SYS_clone, CLONE_PARENT | SIGCHLD, 0, NULL, NULL, 0);
+            if(pid == 0){
+                close(control);
+                close(sockets[0]);
+                runWorker(sockets[1]);
+            }
+            if(pid > 0){
+                memset(&header, 0, sizeof(header));
+                data.iov_base = &pid;
+                data.iov_len = sizeof(pid);
+                header.msg_iov = &data;
+                header.msg_iovlen = 1;
+                header.msg_control = attachment;
+                header.msg_controllen = sizeof(attachment);
+                attached = CMSG_FIRSTHDR(&header);
+                attached->cmsg_level = SOL_SOCKET;
+                attached->cmsg_type = SCM_RIGHTS;
+                attached->cmsg_len = CMSG_LEN(sizeof(int));
+                memcpy(CMSG_DATA(attached), &sockets[0], sizeof(int));
+                sendmsg(control, &header, MSG_NOSIGNAL);
+            }
+            close(sockets[0]);
+            close(sockets[1]);
+        }
+    }
+    _exit(0);
+}
+
+
+/*******************************************************************
+ * Name: void fillPool()
+ * Description: Collects workers the helper has finished creating
+ *              and asks for replacements for the ones used. Never
+ *              waits on the helper.
+ * Arguments: None.
+ *******************************************************************/
+void fillPool()
+{
+    char control[CMSG_SPACE(sizeof(int))];
+    char request[WORKER_POOL];
+    struct iovec data;
+    struct msghdr header;
+    struct cmsghdr *attached;
+    pid_t pid;
+    int sock;
+    int wanted;
+
+    if(pool.helper <= 0){
+        return;
+    }
+
+    /* Takes in every worker that is ready. */
+    while(pool.requested > 0){
+        memset(&header, 0, sizeof(header));
+        data.iov_base = &pid;
+        data.iov_len = sizeof(pid);
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        if(recvmsg(pool.control, &header, MSG_DONTWAIT | MSG_CMSG_CLOEXEC) != sizeof(pid)){
+            break;
+        }
+        attached = CMSG_FIRSTHDR(&header);
+        if(attached == NULL || attached->cmsg_type != SCM_RIGHTS){
+            break;
+        }
+        memcpy(&sock, CMSG_DATA(attached), sizeof(int));
+        pool.requested--;
+        pool.workers[pool.count].pid = pid;
+        pool.workers[pool.count].sock = sock;
+        pool.count++;
+    }
+
+    /* Asks for the workers used since the last call. */
+    wanted = WORKER_POOL - pool.count - pool.requested;
+    if(wanted > 0){
+        memset(request, 'w', wanted);
+        if(send(pool.control, request, wanted, MSG_DONTWAIT) == wanted){
+            pool.requested += wanted;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void restartPool()
+ * Description: Discards the helper and every idle worker and starts
+ *              a new helper from the shell as it is now. Used after
+ *              "ulimit" changes the shell's limits, which workers
+ *              cloned from the old helper would not have. Each
+ *              discarded worker sees its launch socket close and
+ *              exits; it is reaped like any other child.
+ * Arguments: None.
+ *******************************************************************/
+void restartPool()
+{
+    if(pool.helper <= 0){
+        return;
+    }
+    while(pool.count > 0){
+        close(pool.workers[--pool.count].sock);
+    }
+    close(pool.control);    // The helper exits, and workers still on their way are closed with the socket.
+    close(pool.cwdFd);
+    pool.requested = 0;
+    startHelper();
+}
+
+
+/*******************************************************************
+ * Name: void runWorker(int sock)
+ * Description: Runs in a pre-forked worker. Waits for one launch
+ *              message holding the path, arguments and environment,
+ *              with the redirected descriptors and the shell's
+ *              working directory attached as SCM_RIGHTS, then execs
+ *              the command in place of the worker.
+ * Arguments: An int for the worker's end of the launch socket.
+ *******************************************************************/
+void runWorker(int sock)
+{
+    static char message[WORKER_MESSAGE];    // Header, then the path, each argument and each variable.
+    char control[CMSG_SPACE(4 * sizeof(int))];
+    struct iovec data = {message, sizeof(message)};
+    struct msghdr header;
+    struct cmsghdr *attached;
+    struct launchHeader counts;
+    char **argList;
+    char **envList;
+    char *text;
+    char *path;
+    int fds[4];                 // Redirected stdin, stdout and stderr as sent, then the working directory.
+    int fdCount = 0;
+    ssize_t length;
+    int i;                      // Index for loop.
+    int used = 0;               // Received descriptors already duplicated.
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL);   // Never outlives the shell.
+
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    do{
+        length = recvmsg(sock, &header, MSG_CMSG_CLOEXEC);  // Received copies close on exec once dup'd.
+    } while(length < 0 && errno == EINTR);
+    if(length < (ssize_t)sizeof(counts)){
+        _exit(0);   // The shell discarded this worker.
+    }
+
+    attached = CMSG_FIRSTHDR(&header);
+    if(attached != NULL && attached->cmsg_type == SCM_RIGHTS){
+        fdCount = (attached->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(attached), fdCount * sizeof(int));
+    }
+    memcpy(&counts, message, sizeof(counts));
+    for(i = 0; i < 3; i++){
+        if(counts.redirects & (1 << i)){
+            dup2(fds[used++], i);   // Duplicates file descriptor to redirect stdin, stdout or stderr.
+        }
+    }
+    if(used < fdCount){
+        fchdir(fds[used]);  // Runs in the shell's current directory, not the helper's.
+    }
+
+    /* Points the argument and environment lists into the message. */
+    argList = malloc((counts.argCount + 1) * sizeof(char*));
+    envList = malloc((counts.envCount + 1) * sizeof(char*));
+    path = message + sizeof(counts);
+    text = path + strlen(path) + 1;
+    for(i = 0; i < counts.argCount; i++){
+        argList[i] = text;
+        text += strlen(text) + 1;
+    }
+    argList[i] = NULL;
+    for(i = 0; i < counts.envCount; i++){
+        envList[i] = text;
+        text += strlen(text) + 1;
+    }
+    envList[i] = NULL;
+    environ = envList;
+
+    if(counts.pgid != -1){
+        setpgid(0, counts.pgid);
+    }
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    execv(path, argList);           // Replaces the worker with the command.
+    execvp(argList[0], argList);    // Searches PATH again if the remembered binary is gone.
+    dprintf(STDOUT_FILENO, "%s: No such file or directory\n", argList[0]);
+    _exit(1);
+}
+
+
+/*******************************************************************
+ * Name: bool packString(char* message, size_t* length,
+ *                       const char* text)
+ * Description: Appends a NUL-terminated string to a launch message.
+ * Arguments: Pointer to char for the message, a pointer to its
+ *            length so far and pointer to char for the string.
+ * Returns: False if the string does not fit.
+ *******************************************************************/
+bool packString(char* message, size_t* length, const char* text)
+{
+    size_t size = strlen(text) + 1;
+
+    if(*length + size > WORKER_MESSAGE){
+        return false;
+    }
+    memcpy(message + *length, text, size);
+    *length += size;
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: pid_t launchWorker(char* path, char** argList, int* fds,
+ *                         pid_t pgid)
+ * Description: Launches a command on an idle pre-forked worker
+ *              with a single sendmsg. The worker is already the
+ *              shell's child, so it is waited on like any other.
+ *              The environment is packed once and reused until a
+ *              variable is exported, changed or unset. Falls back
+ *              to spawnChild when the command does not fit in one
+ *              message.
+ * Arguments: Pointer to char for the resolved path, a pointer to
+ *            the argument list, a pointer to the three file
+ *            descriptors the child receives, and a pid_t for the
+ *            process group to join, 0 for a new one, or -1 for the
+ *            shell's.
+ * Returns: The child's pid, or -1 if the command could not start.
+ *******************************************************************/
+pid_t launchWorker(char* path, char** argList, int* fds, pid_t pgid)
+{
+    static char message[WORKER_MESSAGE];    // Reused by every launch; cmdArena would grow by one per "parallel" job.
+    static char packedEnv[WORKER_MESSAGE];  // The environment as packed for the last launch.
+    static size_t packedLength = 0;         // Bytes of packedEnv, or more than a message when it does not fit.
+    static int packedCount = 0;             // Variables in packedEnv.
+    static unsigned long packedGeneration = 0;  // vars.generation when packedEnv was filled.
+    char control[CMSG_SPACE(4 * sizeof(int))];
+    struct iovec data;
+    struct msghdr header;
+    struct cmsghdr *attached;
+    struct launchHeader counts = {0, 0, 0, pgid};
+    struct worker chosen;
+    size_t length = sizeof(counts);
+    int sent[4];        // Descriptors attached to the message.
+    int fdCount = 0;
+    int i;              // Index for loop.
+
+    /* Packs the path, then the arguments, then the environment. */
+    if(packString(message, &length, path) == false){
+        return spawnChild(path, argList, fds, pgid);
+    }
+    for(counts.argCount = 0; argList[counts.argCount] != NULL; counts.argCount++){
+        if(packString(message, &length, argList[counts.argCount]) == false){
+            return spawnChild(path, argList, fds, pgid);
+        }
+    }
+    if(packedGeneration != vars.generation){
+        packedLength = 0;
+        for(packedCount = 0; environ[packedCount] != NULL; packedCount++){
+            if(packString(packedEnv, &packedLength, environ[packedCount]) == false){
+                packedLength = WORKER_MESSAGE + 1;  // Remembers that it cannot fit.
+                break;
+            }
+        }
+        packedGeneration = vars.generation;
+    }
+    if(length + packedLength > WORKER_MESSAGE){
+        return spawnChild(path, argList, fds, pgid);  // Too large for one message.
+    }
+    memcpy(message + length, packedEnv, packedLength);
+    length += packedLength;
+    counts.envCount = packedCount;
+    for(i = 0; i < 3; i++){
+        if(fds[i] != -1){
+            counts.redirects |= 1 << i;
+            sent[fdCount++] = fds[i];
+        }
+    }
+    if(pool.cwdFd != -1){
+        sent[fdCount++] = pool.cwdFd;
+    }
+    memcpy(message, &counts, sizeof(counts));
+
+    memset(&header, 0, sizeof(header));
+    data.iov_base = message;
+    data.iov_len = length;
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    if(fdCount > 0){
+        header.msg_control = control;
+        header.msg_controllen = CMSG_SPACE(fdCount * sizeof(int));
+        attached = CMSG_FIRSTHDR(&header);
+        attached->cmsg_level = SOL_SOCKET;
+        attached->cmsg_type = SCM_RIGHTS;
+        attached->cmsg_len = CMSG_LEN(fdCount * sizeof(int));
+        memcpy(CMSG_DATA(attached), sent, fdCount * sizeof(int));
+    }
+
+    chosen = pool.workers[--pool.count];
+    if(sendmsg(chosen.sock, &header, MSG_NOSIGNAL) < 0){
+        close(chosen.sock);
+        return spawnChild(path, argList, fds, pgid);  // The worker is gone; it is reaped like any child.
+    }
+    close(chosen.sock);
+    if(pgid != -1){
+        setpgid(chosen.pid, (pgid == 0) ? chosen.pid : pgid);   // Also set here, so the group exists before the terminal is handed over.
+    }
+    return chosen.pid;
+}
+
+
+/*******************************************************************
+ * Name: pid_t forkProcesses(struct parsedInput* obj, int* base,
+ *                           pid_t pgid)
+ * Description: Launches a child process for a command. The
+ *              command's own redirections apply on top of the pipe
+ *              ends it is given. Commands with per-job limits are
+ *              forked, as only a forked child can set them.
+ * Arguments: A pointer to an parsedInput struct, a pointer to
+ *            three ints for the pipe ends to use as stdin, stdout
+ *            and stderr, or -1 to inherit the shell's, and a pid_t
+ *            for the process group to join, 0 for a new one, or -1
+ *            for the shell's.
+ * Returns: The child's pid, or -1 if the command could not start.
+ *******************************************************************/
+pid_t forkProcesses(struct parsedInput* obj, int* base, pid_t pgid)
+{
+    pid_t pid = -1;
+    char **argList = obj->arguments;    // Command followed by its arguments.
+    char *path;     // Full path of the command from the hash table.
+    struct fdPlan plan;     // File descriptors the child receives.
+    long long spawnNs = 0;  // Time the launch began, for the trace.
+
+    if(tracing == true){
+        spawnNs = monotonicNs();
+    }
+    if(redirectIO(obj, base, &plan) != 0){  // Handles redirection for obj.
+        return -1;
+    }
+
+    path = lookupCommand(argList[0]);
+    if(path != NULL && path != argList[0] && (pool.count > 0 || spawnMode == false || cmdLimitNum > 0)
+            && access(path, X_OK) != 0){
+        /* Only posix_spawn tells the shell a remembered binary is gone; the other launchers fail in the child. */
+        forgetCommand(argList[0]);
+        path = lookupCommand(argList[0]);
+    }
+    if(path == NULL){
+        printf("%s: No such file or directory\n", argList[0]);
+    }
+    else if(pool.count > 0 && cmdLimitNum == 0){
+        pid = launchWorker(path, argList, plan.fds, pgid);
+    }
+    else if(spawnMode == true && cmdLimitNum == 0){
+        pid = spawnChild(path, argList, plan.fds, pgid);
+    }
+    else{
+        pid = forkChild(path, argList, plan.fds, pgid);
+    }
+    if(tracing == true && pid != -1){
+        traceLaunch(obj, pid, spawnNs, monotonicNs());
+    }
+
+    closePlan(&plan);   // The child holds its own copies of any redirected files.
+    return pid;
+}
+
+
+/*******************************************************************
+ * Name: void runPipeline(struct parsedInput** stages,
+ *                        int stageCount)
+ * Description: Launches every command of a pipeline at once as one
+ *              job, connecting neighbours with pipes. A background
+ *              job, or any job when the shell has job control, gets
+ *              its own process group led by its first command. Then
+ *              either lists the job as a background job or runs it
+ *              in the foreground until it ends or is stopped.
+ * Arguments: A pointer to the array of parsedInput pointers and an
+ *            int for the number of commands.
+ *******************************************************************/
+void runPipeline(struct parsedInput** stages, int stageCount)
+{
+    struct job *job = newJob(stages, stageCount);
+    int pipeFds[2];                 // Read and write ends of the pipe to the next command.
+    int inFd = -1;                  // Read end of the pipe from the previous command.
+    int outFd;
+    int base[3];                    // Pipe ends each command receives before its own redirections.
+    bool background = (stages[stageCount - 1]->backMode == true && foregroundMode == false);
+    int i;                          // Index for loop.
+
+    fflush(stdout);     // Keeps buffered builtin output ahead of the children's output.
+    job->pgid = (background == true || jobControl == true) ? 0 : -1;  // Otherwise ^C reaches it through the shell's group.
+    job->lastPid = -1;
+
+    for(i = 0; i < stageCount; i++){
+        outFd = -1;
+        if(i < stageCount - 1){
+            if(pipe2(pipeFds, O_CLOEXEC) != 0){
+                perror("pipe2");
+                stageCount = i;
+                break;
+            }
+            outFd = pipeFds[1];
+        }
+
+        base[0] = inFd;
+        base[1] = outFd;
+        base[2] = -1;
+        job->pids[i] = forkProcesses(stages[i], base, job->pgid);  // Runs commands and manages parent and child processes.
+        if(job->pids[i] != -1){
+            job->running++;
+            if(job->pgid == 0){
+                job->pgid = job->pids[i];   // The first command started leads the group.
+                if(background == false){
+                    tcsetpgrp(STDIN_FILENO, job->pgid); // Hands over the terminal before the rest can read it.
+                }
+            }
+        }
+
+        /* The children hold their own copies of the pipe ends. */
+        if(inFd != -1){
+            close(inFd);
+        }
+        inFd = -1;
+        if(outFd != -1){
+            close(outFd);
+            inFd = pipeFds[0];
+        }
+    }
+    if(inFd != -1){
+        close(inFd);
+    }
+    job->pidNum = stageCount;
+    if(stageCount == 0){
+        dropJob(job);
+        return;
+    }
+    job->lastPid = job->pids[stageCount - 1];
+    fillPool();     // Asks for replacements for the workers just used.
+    if(cmdTimeout > 0 && job->running > 0){
+        startDeadline(job);
+    }
+
+    if(background == true){ // Identifies background mode.
+        for(i = 0; i < stageCount; i++){
+            if(job->pids[i] != -1){
+                addBackPid(job->pids[i], job);  // Adds the process ID for a background process to the job table.
+            }
+        }
+        if(job->lastPid != -1){
+            printf("Background pid is %d\n", job->lastPid);
+            lastBackground = job->lastPid;  // Remembers it for "$!".
+            lastBackgroundValue = -1;
+        }
+        if(job->running > 0){
+            listJob(job);
+        }
+        else{
+            dropJob(job);
+        }
+        return;
+    }
+    foregroundJob(job);     // Waits for completion of every child process if background mode not enabled.
+}
+
+
+/*******************************************************************
+ * Name: double secondsSince(struct timespec* start)
+ * Description: Measures elapsed wall time on the monotonic clock.
+ * Arguments: A pointer to a timespec struct for the start time.
+ *******************************************************************/
+double secondsSince(struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/*******************************************************************
+ * Name: void addUsage(struct rusage* usage)
+ * Description: Adds a child's resource usage to the totals for the
+ *              current command line. Times and counters are summed;
+ *              max RSS keeps the largest child.
+ * Arguments: A pointer to an rusage struct.
+ *******************************************************************/
+void addUsage(struct rusage* usage)
+{
+    timeradd(&cmdUsage.ru_utime, &usage->ru_utime, &cmdUsage.ru_utime);
+    timeradd(&cmdUsage.ru_stime, &usage->ru_stime, &cmdUsage.ru_stime);
+    if(usage->ru_maxrss > cmdUsage.ru_maxrss){
+        cmdUsage.ru_maxrss = usage->ru_maxrss;
+    }
+    cmdUsage.ru_minflt += usage->ru_minflt;
+    cmdUsage.ru_majflt += usage->ru_majflt;
+    cmdUsage.ru_nvcsw += usage->ru_nvcsw;
+    cmdUsage.ru_nivcsw += usage->ru_nivcsw;
+    cmdUsageCount++;
+}
+
+
+/*******************************************************************
+ * Name: void printUsage(int format, pid_t processId,
+ *                       int processValue, double wall,
+ *                       struct rusage* usage, bool queued)
+ * Description: Writes a resource usage report, either as a
+ *              labelled line (TIME_HUMAN) or as key=value pairs
+ *              (TIME_MACHINE). Reports go to stderr, except that a
+ *              background job's report joins its completion message
+ *              in the notice queue.
+ * Arguments: An int for the format, a pid_t for the process ID (0
+ *            for a foreground command line), an int for the wait
+ *            status, a double for wall seconds, a pointer to an
+ *            rusage struct and a bool to queue the report.
+ *******************************************************************/
+void printUsage(int format, pid_t processId, int processValue, double wall, struct rusage* usage, bool queued)
+{
+    char report[256];
+    int used = 0;
+    double user = usage->ru_utime.tv_sec + usage->ru_utime.tv_usec / 1e6;
+    double sys = usage->ru_stime.tv_sec + usage->ru_stime.tv_usec / 1e6;
+
+    if(format == TIME_MACHINE){
+        snprintf(report, sizeof(report), "time pid=%d status=%d real=%.6f user=%.6f sys=%.6f maxrss=%ld minflt=%ld majflt=%ld nvcsw=%ld nivcsw=%ld\n",
+                 (int)processId, statusValue(processValue), wall, user, sys, usage->ru_maxrss,
+                 usage->ru_minflt, usage->ru_majflt, usage->ru_nvcsw, usage->ru_nivcsw);
+    }
+    else{
+        if(processId != 0){
+            used = snprintf(report, sizeof(report), "pid %d: ", (int)processId);
+        }
+        snprintf(report + used, sizeof(report) - used, "real %.3fs  user %.3fs  sys %.3fs  maxrss %ldKiB  faults %ld major %ld minor  switches %ld voluntary %ld involuntary\n",
+                 wall, user, sys, usage->ru_maxrss, usage->ru_majflt, usage->ru_minflt, usage->ru_nvcsw, usage->ru_nivcsw);
+    }
+    if(queued == true){
+        queueNotice("%s", report);
+    }
+    else{
+        fputs(report, stderr);
+    }
+}
+
+
+/*******************************************************************
+ * Name: int stripTimePrefix(struct parsedInput* obj)
+ * Description: Removes a leading "time" (and its -p or -m option)
+ *              from the first command of a line.
+ * Arguments: A pointer to an parsedInput struct.
+ * Returns: The report format the prefix asked for, or TIME_OFF if
+ *          the command did not start with "time".
+ *******************************************************************/
+int stripTimePrefix(struct parsedInput* obj)
+{
+    int format = TIME_HUMAN;
+
+    if(obj->argNum == 0 || strcmp(obj->arguments[0], "time") != 0){
+        return TIME_OFF;
+    }
+    obj->arguments++;   // The arguments live in cmdArena, so the array can simply start later.
+    obj->argNum--;
+    obj->argCapacity--;
+    if(obj->argNum > 0 && (strcmp(obj->arguments[0], "-m") == 0 || strcmp(obj->arguments[0], "-p") == 0)){
+        format = TIME_MACHINE;
+        obj->arguments++;
+        obj->argNum--;
+        obj->argCapacity--;
+    }
+    return format;
+}
+
+
+/*******************************************************************
+ * Name: void timingBuiltin(struct parsedInput* obj)
+ * Description: Handles "timing [off|human|machine]", which sets or
+ *              shows whether every command reports its resource
+ *              usage.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void timingBuiltin(struct parsedInput* obj)
+{
+    static const char *names[] = {"off", "human", "machine"};
+    int i;  // Index for loop.
+
+    foregroundValue = 0;
+    if(obj->argNum == 1){
+        printf("timing %s\n", names[timingMode]);
+        return;
+    }
+    for(i = 0; i < 3; i++){
+        if(strcmp(obj->arguments[1], names[i]) == 0){
+            timingMode = i;
+            return;
+        }
+    }
+    printf("usage: timing [off|human|machine]\n");
+    foregroundValue = 2 << 8;
+}
+
+
+/*******************************************************************
+ * Name: bool parseDuration(const char* text, double* seconds)
+ * Description: Reads a duration for "timeout": a number of seconds,
+ *              which may have a fraction, with an optional suffix
+ *              of s, m, h or d.
+ * Arguments: Pointer to char for the text and a pointer to double
+ *            for the seconds.
+ * Returns: False if the text is not a duration.
+ *******************************************************************/
+bool parseDuration(const char* text, double* seconds)
+{
+    char *end;
+
+    errno = 0;
+    *seconds = strtod(text, &end);
+    if(end == text || errno != 0 || !(*seconds >= 0 && *seconds < 1e9)){
+        return false;   // Also refuses "nan" and "inf".
+    }
+    if(*end == 'm'){
+        *seconds *= 60;
+    }
+    else if(*end == 'h'){
+        *seconds *= 3600;
+    }
+    else if(*end == 'd'){
+        *seconds *= 86400;
+    }
+    else if(*end != 's'){
+        return *end == '\0';
+    }
+    return end[1] == '\0';
+}
+
+
+/*******************************************************************
+ * Name: int signalNumber(const char* text)
+ * Description: Reads a signal given by number or by name, with or
+ *              without "SIG", in either case.
+ * Arguments: Pointer to char for the text.
+ * Returns: The signal, or -1 if there is no such signal.
+ *******************************************************************/
+int signalNumber(const char* text)
+{
+    const char *name;
+    char *end;
+    long number;
+    int i;  // Index for loop.
+
+    if(isdigit((unsigned char)text[0])){
+        number = strtol(text, &end, 10);
+        return (*end == '\0' && number > 0 && number < NSIG) ? (int)number : -1;
+    }
+    if(strncasecmp(text, "SIG", 3) == 0){
+        text += 3;
+    }
+    for(i = 1; i < NSIG; i++){
+        name = sigabbrev_np(i);
+        if(name != NULL && strcasecmp(text, name) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/*******************************************************************
+ * Name: int parseTimeout(char** args, int count)
+ * Description: Reads the rest of a "timeout [-s signal]
+ *              [-k duration] duration" prefix into cmdTimeout,
+ *              cmdTimeoutSignal and cmdKillAfter. A command must
+ *              follow the duration.
+ * Arguments: A pointer to the words after "timeout" and an int for
+ *            how many there are.
+ * Returns: Words used, or -1 after printing why they are wrong.
+ *******************************************************************/
+int parseTimeout(char** args, int count)
+{
+    int used = 0;
+
+    cmdTimeoutSignal = SIGTERM;
+    cmdKillAfter = 0;
+    while(used < count - 1 && (strcmp(args[used], "-s") == 0 || strcmp(args[used], "-k") == 0)){
+        if(args[used][1] == 's'){
+            cmdTimeoutSignal = signalNumber(args[used + 1]);
+            if(cmdTimeoutSignal == -1){
+                printf("timeout: %s: invalid signal\n", args[used + 1]);
+                return -1;
+            }
+        }
+        else if(parseDuration(args[used + 1], &cmdKillAfter) == false){
+            printf("timeout: %s: invalid time interval\n", args[used + 1]);
+            return -1;
+        }
+        used += 2;
+    }
+    if(used + 1 >= count){
+        printf("usage: timeout [-s signal] [-k duration] duration command [arg ...]\n");
+        return -1;
+    }
+    if(parseDuration(args[used], &cmdTimeout) == false){
+        printf("timeout: %s: invalid time interval\n", args[used]);
+        return -1;
+    }
+    return used + 1;
+}
+
+
+/*******************************************************************
+ * Name: int parseLimits(char** args, int count,
+ *                       struct limitSetting* settings,
+ *                       int* settingNum, bool* all)
+ * Description: Reads "ulimit" options. Each resource option may be
+ *              followed by a value, a number or "unlimited"; with
+ *              no resource named, the file size is meant, as in
+ *              other shells. -S and -H choose the soft or the hard
+ *              limit; a value sets both when neither is given. -a
+ *              names every resource. Reading stops at the first
+ *              other word, which starts the command of a prefix.
+ * Arguments: A pointer to the words after "ulimit", an int for how
+ *            many there are, a pointer to room for LIMIT_MAX
+ *            settings, a pointer to int for the number filled in,
+ *            and a pointer to bool, set when -a is given.
+ * Returns: Words used, or -1 after printing why they are wrong.
+ *******************************************************************/
+int parseLimits(char** args, int count, struct limitSetting* settings, int* settingNum, bool* all)
+{
+    struct limitSetting *setting = NULL;    // Setting the next value belongs to.
+    bool soft = false;
+    bool hard = false;
+    unsigned long long number;
+    char *letter;
+    char *end;
+    int used;
+    int i;  // Index for loop.
+    int j;
+
+    *settingNum = 0;
+    *all = false;
+    for(used = 0; used < count; used++){
+        letter = args[used];
+        if(letter[0] == '-' && letter[1] != '\0'){
+            for(letter++; *letter != '\0'; letter++){
+                if(*letter == 'a' || *letter == 'S' || *letter == 'H'){
+                    *all |= (*letter == 'a');
+                    soft |= (*letter == 'S');
+                    hard |= (*letter == 'H');
+                    continue;
+                }
+                for(i = 0; i < LIMIT_MAX && limitOptions[i].letter != *letter; i++){
+                }
+                if(i == LIMIT_MAX){
+                    printf("ulimit: -%c: invalid option\n", *letter);
+                    return -1;
+                }
+                for(j = 0; j < *settingNum && settings[j].option != &limitOptions[i]; j++){
+                }
+                if(j == *settingNum){
+                    (*settingNum)++;
+                }
+                setting = &settings[j];
+                setting->option = &limitOptions[i];
+                setting->shown = true;
+            }
+            continue;
+        }
+        if(isdigit((unsigned char)letter[0]) == false && strcmp(letter, "unlimited") != 0){
+            break;  // The command of a "ulimit" prefix.
+        }
+        if(setting == NULL){
+            for(i = 0; limitOptions[i].letter != 'f'; i++){
+            }
+            setting = &settings[(*settingNum)++];
+            setting->option = &limitOptions[i];
+        }
+        else if(setting->shown == false){
+            break;  // The option already has its value.
+        }
+        setting->value = RLIM_INFINITY;
+        if(letter[0] != 'u'){
+            errno = 0;
+            number = strtoull(letter, &end, 10);
+            if(*end != '\0' || errno != 0 || number > RLIM_INFINITY / setting->option->unit){
+                printf("ulimit: %s: invalid number\n", letter);
+                return -1;
+            }
+            setting->value = number * setting->option->unit;
+        }
+        setting->shown = false;
+    }
+
+    /* Fills in the resources named by -a, or the file size when none was named. */
+    for(i = 0; i < LIMIT_MAX; i++){
+        for(j = 0; j < *settingNum && settings[j].option != &limitOptions[i]; j++){
+        }
+        if(j == *settingNum && (*all == true || (*settingNum == 0 && limitOptions[i].letter == 'f'))){
+            settings[(*settingNum)++].option = &limitOptions[i];
+            settings[j].shown = true;
+        }
+    }
+    for(i = 0; i < *settingNum; i++){
+        settings[i].soft = (soft == true || hard == false);
+        settings[i].hard = (hard == true || (soft == false && settings[i].shown == false));
+    }
+    return used;
+}
+
+
+/*******************************************************************
+ * Name: bool stripJobPrefixes(struct parsedInput* obj)
+ * Description: Removes leading "timeout" and "ulimit" prefixes from
+ *              the first command of a line, in any order, leaving
+ *              the deadline in cmdTimeout and the limits in
+ *              cmdLimits for the job about to be launched. A
+ *              "ulimit" with nothing after its options is the
+ *              builtin, and is left in place.
+ * Arguments: A pointer to an parsedInput struct.
+ * Returns: False after printing why a prefix is wrong.
+ *******************************************************************/
+bool stripJobPrefixes(struct parsedInput* obj)
+{
+    struct limitSetting settings[LIMIT_MAX];
+    int settingNum;
+    bool all;
+    int used;
+    int i;  // Index for loop.
+    int j;
+
+    while(obj->argNum > 0){
+        if(strcmp(obj->arguments[0], "timeout") == 0){
+            used = parseTimeout(obj->arguments + 1, obj->argNum - 1);
+            if(used < 0){
+                foregroundValue = TIMEOUT_USAGE << 8;
+                return false;
+            }
+        }
+        else if(strcmp(obj->arguments[0], "ulimit") == 0){
+            used = parseLimits(obj->arguments + 1, obj->argNum - 1, settings, &settingNum, &all);
+            if(used < 0){
+                foregroundValue = 2 << 8;
+                return false;
+            }
+            if(used == obj->argNum - 1){
+                break;  // Nothing follows, so the builtin changes the shell's own limits.
+            }
+            for(i = 0; i < settingNum; i++){
+                if(settings[i].shown == true){
+                    printf("ulimit: -%c: a value is needed before a command\n", settings[i].option->letter);
+                    foregroundValue = 2 << 8;
+                    return false;
+                }
+                for(j = 0; j < cmdLimitNum && cmdLimits[j].option != settings[i].option; j++){
+                }
+                cmdLimits[j] = settings[i];
+                if(j == cmdLimitNum){
+                    cmdLimitNum++;
+                }
+            }
+        }
+        else{
+            break;
+        }
+        obj->arguments += used + 1;     // The arguments live in cmdArena, so the array can simply start later.
+        obj->argNum -= used + 1;
+        obj->argCapacity -= used + 1;
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: bool applyLimits(struct limitSetting* settings, int count)
+ * Description: Sets each limit that was given a value, changing its
+ *              soft limit, its hard limit, or both.
+ * Arguments: A pointer to the settings and an int for how many
+ *            there are.
+ * Returns: False after printing why a limit could not be set.
+ *******************************************************************/
+bool applyLimits(struct limitSetting* settings, int count)
+{
+    struct rlimit limit;
+    int i;  // Index for loop.
+
+    for(i = 0; i < count; i++){
+        if(settings[i].shown == true){
+            continue;
+        }
+        getrlimit(settings[i].option->resource, &limit);
+        if(settings[i].soft == true){
+            limit.rlim_cur = settings[i].value;
+        }
+        if(settings[i].hard == true){
+            limit.rlim_max = settings[i].value;
+        }
+        if(setrlimit(settings[i].option->resource, &limit) != 0){
+            printf("ulimit: %s: cannot modify limit: %s\n", settings[i].option->label, strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void printLimit(struct limitSetting* setting,
+ *                       bool labelled)
+ * Description: Prints a soft or hard limit in the units "ulimit"
+ *              takes, after its description when several are shown.
+ * Arguments: A pointer to a limitSetting struct and a bool, true to
+ *            print the description.
+ *******************************************************************/
+void printLimit(struct limitSetting* setting, bool labelled)
+{
+    struct rlimit limit;
+    rlim_t value;
+
+    getrlimit(setting->option->resource, &limit);
+    value = (setting->soft == true) ? limit.rlim_cur : limit.rlim_max;
+    if(labelled == true){
+        printf("%-28s(-%c) ", setting->option->label, setting->option->letter);
+    }
+    if(value == RLIM_INFINITY){
+        printf("unlimited\n");
+    }
+    else{
+        printf("%llu\n", (unsigned long long)(value / setting->option->unit));
+    }
+}
+
+
+/*******************************************************************
+ * Name: void ulimitBuiltin(struct parsedInput* obj)
+ * Description: Handles "ulimit [-SHa] [-cdfnstuv [value]] ...",
+ *              which shows or sets the shell's resource limits, and
+ *              so those of every command launched afterwards. With
+ *              a command after the options it is a prefix instead,
+ *              removed by stripJobPrefixes. Changing a limit
+ *              restarts the -z worker pool so it has the new ones.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void ulimitBuiltin(struct parsedInput* obj)
+{
+    struct limitSetting settings[LIMIT_MAX];
+    int settingNum;
+    int shownNum = 0;   // Counts limits to print; several are labelled.
+    bool all;
+    int i;  // Index for loop.
+
+    foregroundValue = 0;
+    if(parseLimits(obj->arguments + 1, obj->argNum - 1, settings, &settingNum, &all) < 0){
+        foregroundValue = 2 << 8;
+        return;
+    }
+    if(applyLimits(settings, settingNum) == false){
+        foregroundValue = 1 << 8;
+    }
+    for(i = 0; i < settingNum; i++){
+        shownNum += (settings[i].shown == true);
+    }
+    if(shownNum < settingNum){
+        restartPool();  // Workers forked before the change still have the old limits.
+    }
+    for(i = 0; i < settingNum; i++){
+        if(settings[i].shown == true){
+            printLimit(&settings[i], shownNum > 1);
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void startDeadline(struct job* job)
+ * Description: Gives a newly launched job the deadline in
+ *              cmdTimeout. A timerfd expires at the deadline, and a
+ *              pidfd for each process reports when it exits, all
+ *              watched by deadlineLoop, so any number of deadlines
+ *              cost nothing until one of them is due.
+ * Arguments: A pointer to a job struct.
+ *******************************************************************/
+void startDeadline(struct job* job)
+{
+    struct deadline *deadline;
+    struct epoll_event event;
+    int i;  // Index for loop.
+
+    if(deadlineLoop == -1){
+        deadlineLoop = epoll_create1(EPOLL_CLOEXEC);
+        if(deadlineLoop == -1){
+            perror("epoll_create1");
+            return;
+        }
+    }
+    deadline = calloc(1, sizeof(struct deadline));
+    if(deadline == NULL){
+        printf("Unable to allocate memory\n");
+        exit(1);
+    }
+    deadline->pidFds = malloc(job->pidNum * sizeof(int));
+    deadline->watches = malloc((job->pidNum + 1) * sizeof(struct watch));
+    if(deadline->pidFds == NULL || deadline->watches == NULL){
+        printf("Unable to allocate memory\n");
+        exit(1);
+    }
+    deadline->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(deadline->timerFd == -1){
+        perror("timerfd_create");
+        free(deadline->pidFds);
+        free(deadline->watches);
+        free(deadline);
+        return;
+    }
+    deadline->job = job;
+    deadline->signal = cmdTimeoutSignal;
+    deadline->killAfter = cmdKillAfter;
+
+    event.events = EPOLLIN;
+    deadline->watches[0].deadline = deadline;
+    deadline->watches[0].index = -1;
+    event.data.ptr = &deadline->watches[0];
+    epoll_ctl(deadlineLoop, EPOLL_CTL_ADD, deadline->timerFd, &event);
+    for(i = 0; i < job->pidNum; i++){
+        deadline->pidFds[i] = -1;
+        if(job->pids[i] == -1){
+            continue;   // Did not start.
+        }
+        deadline->live++;   // Also counts a process without a pidfd, so the deadline lasts until the job is dropped.
+        deadline->pidFds[i] = syscall(SYS_pidfd_open, job->pids[i], 0);
+        if(deadline->pidFds[i] == -1){
+            continue;   // Signalled by its pid instead, which is safe until the shell reaps it.
+        }
+        deadline->watches[i + 1].deadline = deadline;
+        deadline->watches[i + 1].index = i;
+        event.data.ptr = &deadline->watches[i + 1];
+        epoll_ctl(deadlineLoop, EPOLL_CTL_ADD, deadline->pidFds[i], &event);
+    }
+    armTimer(deadline->timerFd, cmdTimeout);
+    job->deadline = deadline;
+    deadlineCount++;
+}
+
+
+/*******************************************************************
+ * Name: void armTimer(int timerFd, double seconds)
+ * Description: Sets a timerfd to expire once, seconds from now.
+ * Arguments: An int for the timerfd and a double for the delay.
+ *******************************************************************/
+void armTimer(int timerFd, double seconds)
+{
+    struct itimerspec expiry = {{0, 0}, {0, 0}};
+
+    expiry.it_value.tv_sec = (time_t)seconds;
+    expiry.it_value.tv_nsec = (long)((seconds - expiry.it_value.tv_sec) * 1e9);
+    if(expiry.it_value.tv_sec == 0 && expiry.it_value.tv_nsec == 0){
+        expiry.it_value.tv_nsec = 1;    // All zeros would disarm the timer instead.
+    }
+    timerfd_settime(timerFd, 0, &expiry, NULL);
+}
+
+
+/*******************************************************************
+ * Name: void checkDeadlines()
+ * Description: Handles every event waiting in deadlineLoop without
+ *              blocking: a process that exited closes its pidfd,
+ *              and a timer that expired ends its job. Events are
+ *              taken one at a time, as each may retire a deadline
+ *              that another event in the same batch refers to.
+ * Arguments: None.
+ *******************************************************************/
+void checkDeadlines()
+{
+    struct epoll_event event;
+    struct watch *watch;
+    struct deadline *deadline;
+
+    while(deadlineCount > 0 && epoll_wait(deadlineLoop, &event, 1, 0) == 1){
+        watch = event.data.ptr;
+        deadline = watch->deadline;
+        if(watch->index == -1){
+            expireDeadline(deadline);
+            continue;
+        }
+        epoll_ctl(deadlineLoop, EPOLL_CTL_DEL, deadline->pidFds[watch->index], NULL);
+        close(deadline->pidFds[watch->index]);
+        deadline->pidFds[watch->index] = -1;
+        deadline->live--;
+        if(deadline->live == 0){
+            retireDeadline(deadline);   // Every process has exited in time.
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void expireDeadline(struct deadline* deadline)
+ * Description: Sends the job whose deadline passed its signal, and
+ *              SIGCONT after it if the job is stopped, then sets the
+ *              timer again for SIGKILL if "timeout -k" asked for it.
+ *              Each process is signalled through its pidfd, and a
+ *              job with its own process group through the group as
+ *              well, which reaches the commands' own children.
+ * Arguments: A pointer to a deadline struct.
+ *******************************************************************/
+void expireDeadline(struct deadline* deadline)
+{
+    struct job *job = deadline->job;
+    uint64_t expirations;
+    int signals[2];
+    int i;  // Index for loop.
+    int j;
+
+    if(read(deadline->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)){
+        return;     // Not due after all.
+    }
+    job->timedOut = true;
+    signals[0] = (deadline->fired == true) ? SIGKILL : deadline->signal;
+    signals[1] = SIGCONT;
+    for(j = 0; j < ((job->stopped == true) ? 2 : 1); j++){
+        if(job->pgid > 0 && job->running > 0){
+            kill(-job->pgid, signals[j]);
+        }
+        for(i = 0; i < job->pidNum; i++){
+            if(deadline->pidFds[i] != -1){
+                syscall(SYS_pidfd_send_signal, deadline->pidFds[i], signals[j], NULL, 0);
+            }
+            else if(job->pids[i] != -1){
+                kill(job->pids[i], signals[j]);
+            }
+        }
+    }
+    if(deadline->fired == false && deadline->killAfter > 0){
+        armTimer(deadline->timerFd, deadline->killAfter);
+    }
+    deadline->fired = true;
+}
+
+
+/*******************************************************************
+ * Name: void retireDeadline(struct deadline* deadline)
+ * Description: Stops watching a deadline and frees it. Descriptors
+ *              are removed from deadlineLoop before they are closed,
+ *              as a forked subshell may hold them open, which would
+ *              otherwise keep them in the loop.
+ * Arguments: A pointer to a deadline struct.
+ *******************************************************************/
+void retireDeadline(struct deadline* deadline)
+{
+    int i;  // Index for loop.
+
+    epoll_ctl(deadlineLoop, EPOLL_CTL_DEL, deadline->timerFd, NULL);
+    close(deadline->timerFd);
+    for(i = 0; i < deadline->job->pidNum; i++){
+        if(deadline->pidFds[i] != -1){
+            epoll_ctl(deadlineLoop, EPOLL_CTL_DEL, deadline->pidFds[i], NULL);
+            close(deadline->pidFds[i]);
+        }
+    }
+    deadline->job->deadline = NULL;
+    free(deadline->pidFds);
+    free(deadline->watches);
+    free(deadline);
+    deadlineCount--;
+}
+
+
+/*******************************************************************
+ * Name: pid_t waitChild(pid_t processId, int* processValue,
+ *                       int options, struct rusage* usage)
+ * Description: Waits for a child as wait4 does. While any deadline
+ *              is set, it sleeps in poll on the self-pipe and
+ *              deadlineLoop instead, so the deadlines of this job
+ *              and of background jobs are kept while it waits.
+ * Arguments: A pid_t for the process ID, a pointer to int for its
+ *            wait status, an int for the wait4 options and a
+ *            pointer to an rusage struct.
+ * Returns: What wait4 returns, including -1 with errno set to EINTR
+ *          when a signal cut the wait short.
+ *******************************************************************/
+pid_t waitChild(pid_t processId, int* processValue, int options, struct rusage* usage)
+{
+    struct pollfd fds[2];   // Watches the self-pipe and the deadlines.
+    char drain[64];         // Discards pending wakeup bytes.
+    pid_t result;
+
+    fds[0].fd = childPipe[0];
+    fds[0].events = POLLIN;
+    fds[1].events = POLLIN;
+    while(deadlineCount > 0){
+        while(read(childPipe[0], drain, sizeof(drain)) > 0); // Emptied first, so a child ending after the check below still wakes poll.
+        checkDeadlines();
+        result = wait4(processId, processValue, options | WNOHANG, usage);
+        if(result != 0){
+            return result;
+        }
+        fds[1].fd = deadlineLoop;
+        if(poll(fds, 2, -1) < 0 && errno == EINTR){
+            return -1;
+        }
+    }
+    return wait4(processId, processValue, options, usage);
+}
+
+
+/*******************************************************************
+ * Name: long long monotonicNs()
+ * Description: Reads the monotonic clock in nanoseconds.
+ * Arguments: None.
+ *******************************************************************/
+long long monotonicNs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+
+/*******************************************************************
+ * Name: void startTrace(const char* path)
+ * Description: Opens the trace file and starts the writer thread.
+ *              The shell only copies records into the ring, so a
+ *              slow trace file never holds up a command.
+ * Arguments: Pointer to char for the trace file's path.
+ *******************************************************************/
+void startTrace(const char* path)
+{
+    sigset_t allSignals;    // Blocked in the writer so the shell's handlers run on the main thread.
+    sigset_t oldSignals;
+    char record[128];
+
+    trace.fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(trace.fd < 0){
+        perror(path);
+        exit(1);
+    }
+    trace.wakeFd = eventfd(0, EFD_CLOEXEC);
+    trace.data = malloc(TRACE_RING);
+    if(trace.wakeFd < 0 || trace.data == NULL){
+        printf("Unable to start trace\n");
+        exit(1);
+    }
+    atomic_init(&trace.head, 0);
+    atomic_init(&trace.tail, 0);
+    atomic_init(&trace.stopping, false);
+    trace.dropped = 0;
+
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &oldSignals);
+    if(pthread_create(&trace.writer, NULL, traceWriter, NULL) != 0){
+        printf("Unable to start trace\n");
+        exit(1);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSignals, NULL);
+    tracing = true;
+
+    tracePublish(record, snprintf(record, sizeof(record), "{\"ev\":\"start\",\"pid\":%s,\"t\":%lld,\"launcher\":\"%s\"}\n",
+                                  pidString, monotonicNs(), (pool.helper > 0) ? "worker" : spawnMode ? "spawn" : "fork"));
+}
+
+
+/*******************************************************************
+ * Name: void stopTrace()
+ * Description: Records the shell's exit, then waits for the writer
+ *              thread to write out everything left in the ring.
+ * Arguments: None.
+ *******************************************************************/
+void stopTrace()
+{
+    char record[128];
+    uint64_t wake = 1;
+
+    tracePublish(record, snprintf(record, sizeof(record), "{\"ev\":\"exit\",\"pid\":%s,\"t\":%lld}\n",
+                                  pidString, monotonicNs()));
+    tracing = false;
+    atomic_store(&trace.stopping, true);
+    write(trace.wakeFd, &wake, sizeof(wake));
+    pthread_join(trace.writer, NULL);
+    close(trace.fd);
+}
+
+
+/*******************************************************************
+ * Name: void* traceWriter(void* unused)
+ * Description: Runs on its own thread. Sleeps on the eventfd, then
+ *              writes out everything the shell has published until
+ *              the ring is empty.
+ * Arguments: Unused thread argument.
+ *******************************************************************/
+void* traceWriter(void* unused)
+{
+    uint64_t wake;
+    unsigned long head;
+    unsigned long tail = 0;
+    size_t offset;
+    size_t chunk;
+    ssize_t written;
+
+    while(true){
+        read(trace.wakeFd, &wake, sizeof(wake));
+        while((head = atomic_load(&trace.head)) != tail){
+            offset = tail & (TRACE_RING - 1);
+            chunk = head - tail;
+            if(chunk > TRACE_RING - offset){
+                chunk = TRACE_RING - offset;    // Writes up to the end of the ring, then wraps.
+            }
+            written = write(trace.fd, trace.data + offset, chunk);
+            if(written < 0 && errno == EINTR){
+                continue;
+            }
+            tail += (written > 0) ? (size_t)written : chunk;    // Discards what cannot be written.
+            atomic_store(&trace.tail, tail);
+        }
+        if(atomic_load(&trace.stopping)){
+            return NULL;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: bool traceWrite(const char* record, size_t length)
+ * Description: Copies one record into the ring and publishes it.
+ *              The writer is woken only when it had caught up,
+ *              since otherwise it is still draining and will see
+ *              the new head.
+ * Arguments: Pointer to char for the record and its length.
+ * Returns: False if the ring had no room.
+ *******************************************************************/
+bool traceWrite(const char* record, size_t length)
+{
+    unsigned long head = atomic_load_explicit(&trace.head, memory_order_relaxed);
+    size_t offset = head & (TRACE_RING - 1);
+    size_t first;
+    uint64_t wake = 1;
+
+    if(TRACE_RING - (head - atomic_load(&trace.tail)) < length){
+        return false;
+    }
+    first = (length < TRACE_RING - offset) ? length : TRACE_RING - offset;
+    memcpy(trace.data + offset, record, first);
+    memcpy(trace.data, record + first, length - first);
+    atomic_store(&trace.head, head + length);
+
+    /* Both sides store then load, so either the writer sees this head or this sees its tail. */
+    if(atomic_load(&trace.tail) == head){
+        write(trace.wakeFd, &wake, sizeof(wake));
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void tracePublish(const char* record, size_t length)
+ * Description: Hands a record to the writer thread without ever
+ *              waiting for it. A full ring drops the record; the
+ *              number dropped is recorded once there is room again.
+ * Arguments: Pointer to char for the record and its length.
+ *******************************************************************/
+void tracePublish(const char* record, size_t length)
+{
+    char note[64];
+
+    if(trace.dropped > 0){
+        if(traceWrite(note, snprintf(note, sizeof(note), "{\"ev\":\"dropped\",\"count\":%lu}\n", trace.dropped)) == false){
+            trace.dropped++;
+            return;
+        }
+        trace.dropped = 0;
+    }
+    if(traceWrite(record, length) == false){
+        trace.dropped++;
+    }
+}
+
+
+/*******************************************************************
+ * Name: size_t jsonString(char* out, size_t room, const char* text)
+ * Description: Writes text as a quoted JSON string, or null when
+ *              text is NULL.
+ * Arguments: Pointer to char for the output, the bytes available
+ *            and pointer to char for the text.
+ * Returns: The bytes written, or 0 if it did not fit.
+ *******************************************************************/
+size_t jsonString(char* out, size_t room, const char* text)
+{
+    size_t used = 0;
+
+    if(text == NULL){
+        if(room < 4){
+            return 0;
+        }
+        memcpy(out, "null", 4);
+        return 4;
+    }
+    if(room < 2){
+        return 0;
+    }
+    out[used++] = '"';
+    for(; *text != '\0'; text++){
+        if(used + 8 > room){
+            return 0;
+        }
+        if(*text == '"' || *text == '\\'){
+            out[used++] = '\\';
+            out[used++] = *text;
+        }
+        else if((unsigned char)*text < 0x20){
+            used += sprintf(out + used, "\\u%04x", (unsigned char)*text);
+        }
+        else{
+            out[used++] = *text;
+        }
+    }
+    out[used++] = '"';
+    return used;
+}
+
+
+/*******************************************************************
+ * Name: void traceLaunch(struct parsedInput* obj, pid_t processId,
+ *                        long long spawnNs, long long execNs)
+ * Description: Records a launched command. With posix_spawn the
+ *              exec time is when the child had already exec'd; with
+ *              -f it is when fork returned.
+ * Arguments: A pointer to an parsedInput struct, a pid_t for the
+ *            process ID and two long longs for when the launch
+ *            began and ended.
+ *******************************************************************/
+void traceLaunch(struct parsedInput* obj, pid_t processId, long long spawnNs, long long execNs)
+{
+    char record[TRACE_RECORD];
+    size_t used;
+    size_t added;
+    size_t comma;   // Room for the separator before each argument after the first.
+    char written[256];  // One redirection as it would be typed.
+    int i;          // Index for loop.
+
+    used = snprintf(record, sizeof(record), "{\"ev\":\"launch\",\"pid\":%d,\"t_spawn\":%lld,\"t_exec\":%lld,\"mode\":\"%s\",\"redirects\":[",
+                    (int)processId, spawnNs, execNs, cmdBackground ? "bg" : "fg");
+    for(i = 0; i < obj->redirectNum && used < 1024; i++){
+        if(obj->redirects[i].kind == REDIR_BOTH){
+            snprintf(written, sizeof(written), "&>%s", obj->redirects[i].target);
+        }
+        else{
+            snprintf(written, sizeof(written), "%d%s%s", obj->redirects[i].fd,
+                     redirectOperators[obj->redirects[i].kind], obj->redirects[i].target);
+        }
+        if(i > 0){
+            record[used++] = ',';
+        }
+        used += jsonString(record + used, 2048, written);  // Enough for every character escaped.
+    }
+    memcpy(record + used, "],\"argv\":[", 10);
+    used += 10;
+    for(i = 0; i < obj->argNum; i++){
+        comma = (i > 0) ? 1 : 0;
+        added = jsonString(record + used + comma, sizeof(record) - used - comma - 3, obj->arguments[i]);
+        if(added == 0){
+            break;  // Leaves out arguments that no longer fit.
+        }
+        if(comma == 1){
+            record[used] = ',';
+        }
+        used += comma + added;
+    }
+    memcpy(record + used, "]}\n", 3);
+    tracePublish(record, used + 3);
+}
+
+
+/*******************************************************************
+ * Name: void traceReap(pid_t processId, int processValue,
+ *                      long long reapNs)
+ * Description: Records a reaped child with its exit value or
+ *              signal and the latest SIGCHLD time.
+ * Arguments: A pid_t for the process ID, an int for the wait status
+ *            and a long long for when it was reaped.
+ *******************************************************************/
+void traceReap(pid_t processId, int processValue, long long reapNs)
+{
+    char record[160];
+
+    tracePublish(record, snprintf(record, sizeof(record), "{\"ev\":\"reap\",\"pid\":%d,\"t_reap\":%lld,\"t_sigchld\":%lld,\"%s\":%d}\n",
+                                  (int)processId, reapNs, childSignalNs,
+                                  WIFSIGNALED(processValue) ? "signal" : "exit",
+                                  WIFSIGNALED(processValue) ? WTERMSIG(processValue) : WEXITSTATUS(processValue)));
+}
+
+
+/*******************************************************************
+ * Name: int compareNs(const void* a, const void* b)
+ * Description: Orders durations for qsort, shortest first.
+ * Arguments: Two pointers to long long.
+ *******************************************************************/
+int compareNs(const void* a, const void* b)
+{
+    long long left = *(const long long*)a;
+    long long right = *(const long long*)b;
+
+    return (left > right) - (left < right);
+}
+
+
+/*******************************************************************
+ * Name: void printLatency(const char* label, long long* samples,
+ *                         int count)
+ * Description: Prints the minimum, median, 99th percentile and
+ *              maximum of a set of durations in microseconds.
+ * Arguments: Pointer to char for the label, a pointer to the
+ *            durations in nanoseconds and their count.
+ *******************************************************************/
+void printLatency(const char* label, long long* samples, int count)
+{
+    if(count == 0){
+        printf("%-28s no samples\n", label);
+        return;
+    }
+    qsort(samples, count, sizeof(long long), compareNs);
+    printf("%-28s min %9.1f  median %9.1f  p99 %9.1f  max %9.1f us (%d)\n", label,
+           samples[0] / 1e3, samples[count / 2] / 1e3, samples[(count * 99) / 100] / 1e3,
+           samples[count - 1] / 1e3, count);
+}
+
+
+/*******************************************************************
+ * Name: long long jsonNumber(const char* line, const char* key)
+ * Description: Finds a numeric field in one trace record.
+ * Arguments: Pointers to char for the record and the quoted key.
+ * Returns: The number, or -1 if the field is missing.
+ *******************************************************************/
+long long jsonNumber(const char* line, const char* key)
+{
+    const char *field = strstr(line, key);
+
+    if(field == NULL){
+        return -1;
+    }
+    return strtoll(field + strlen(key) + 1, NULL, 10);  // Skips the key and its ':'.
+}
+
+
+/*******************************************************************
+ * Name: int analyzeTrace(const char* path)
+ * Description: Reads a trace written by -x, pairs each launch with
+ *              its reap by pid, and reports the slowest commands
+ *              along with the shell's own launch latency (start of
+ *              the launch to exec) and reap latency (SIGCHLD to
+ *              the wait that collected the child).
+ * Arguments: Pointer to char for the trace file's path.
+ * Returns: The exit value for the shell.
+ *******************************************************************/
+int analyzeTrace(const char* path)
+{
+    /* A launch record and, once seen, its reap. */
+    struct tracedCommand
+    {
+        pid_t pid;
+        long long spawnNs;
+        long long execNs;
+        long long reapNs;       // -1 until the reap record is found.
+        long long signalNs;
+        char *argv;             // The argv field as written, for display.
+    } *commands = NULL;
+    int count = 0;
+    int capacity = 0;
+    int reaped = 0;
+    long long dropped = 0;
+    long long *launchNs;        // Launch latency of each command.
+    long long *reapLatency;     // Reap latency of each reaped command.
+    long long *runNs;           // Wall time of each reaped command.
+    int *order;                 // Reaped commands, for sorting by wall time.
+    long long swapNs;
+    int swapIndex;
+    int reapCount = 0;
+    FILE *file;
+    char *line = NULL;
+    size_t lineSize = 0;
+    char *argv;
+    char *end;
+    pid_t pid;
+    int i;                      // Index for loop.
+    int j;                      // Index for loop.
+
+    file = fopen(path, "re");
+    if(file == NULL){
+        perror(path);
+        return 1;
+    }
+    while(getline(&line, &lineSize, file) != -1){
+        if(strstr(line, "\"ev\":\"launch\"") != NULL){
+            if(count == capacity){
+                capacity = (capacity == 0) ? 256 : capacity * 2;
+                commands = realloc(commands, capacity * sizeof(*commands));
+                if(commands == NULL){
+                    printf("Unable to allocate trace table\n");
+                    return 1;
+                }
+            }
+            argv = strstr(line, "\"argv\":");
+            end = strrchr(line, '}');
+            if(argv == NULL || end == NULL){
+                continue;
+            }
+            *end = '\0';
+            commands[count].pid = jsonNumber(line, "\"pid\"");
+            commands[count].spawnNs = jsonNumber(line, "\"t_spawn\"");
+            commands[count].execNs = jsonNumber(line, "\"t_exec\"");
+            commands[count].reapNs = -1;
+            commands[count].argv = strdup(argv + 7);
+            count++;
+        }
+        else if(strstr(line, "\"ev\":\"reap\"") != NULL){
+            /* Pairs with the latest unreaped launch of the same pid, since pids are reused. */
+            pid = jsonNumber(line, "\"pid\"");
+            for(i = count - 1; i >= 0; i--){
+                if(commands[i].pid == pid && commands[i].reapNs == -1){
+                    commands[i].reapNs = jsonNumber(line, "\"t_reap\"");
+                    commands[i].signalNs = jsonNumber(line, "\"t_sigchld\"");
+                    reaped++;
+                    break;
+                }
+            }
+        }
+        else if(strstr(line, "\"ev\":\"dropped\"") != NULL){
+            dropped += jsonNumber(line, "\"count\"");
+        }
+    }
+    free(line);
+    fclose(file);
+
+    launchNs = malloc((count + 1) * sizeof(long long));
+    reapLatency = malloc((count + 1) * sizeof(long long));
+    runNs = malloc((count + 1) * sizeof(long long));
+    order = malloc((count + 1) * sizeof(int));
+    for(i = 0; i < count; i++){
+        launchNs[i] = commands[i].execNs - commands[i].spawnNs;
+        if(commands[i].reapNs == -1){
+            continue;
+        }
+        runNs[reapCount] = commands[i].reapNs - commands[i].spawnNs;
+        order[reapCount++] = i;
+    }
+
+    /* Sorts the reaped commands by wall time, longest first, selecting only the top ten. */
+    printf("%d commands launched, %d reaped, %lld trace records dropped\n", count, reaped, dropped);
+    printf("slowest commands (launch to reap):\n");
+    for(i = 0; i < reapCount && i < 10; i++){
+        for(j = i + 1; j < reapCount; j++){
+            if(runNs[j] > runNs[i]){
+                swapNs = runNs[i];
+                swapIndex = order[i];
+                runNs[i] = runNs[j];
+                order[i] = order[j];
+                runNs[j] = swapNs;
+                order[j] = swapIndex;
+            }
+        }
+        printf("  %12.3f ms  pid %-7d %s\n", runNs[i] / 1e6, (int)commands[order[i]].pid, commands[order[i]].argv);
+    }
+
+    /* Reap latency only counts when SIGCHLD arrived before the reap it belongs to. */
+    j = 0;
+    for(i = 0; i < count; i++){
+        if(commands[i].reapNs != -1 && commands[i].signalNs > commands[i].execNs && commands[i].signalNs <= commands[i].reapNs){
+            reapLatency[j++] = commands[i].reapNs - commands[i].signalNs;
+        }
+    }
+    printLatency("launch (fork/exec)", launchNs, count);
+    printLatency("reap (SIGCHLD to wait)", reapLatency, j);
+
+    for(i = 0; i < count; i++){
+        free(commands[i].argv);
+    }
+    free(commands);
+    free(launchNs);
+    free(reapLatency);
+    free(runNs);
+    free(order);
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: int readItems(int fd, char*** items)
+ * Description: Reads every line from a file descriptor into
+ *              cmdArena, one item per non-empty line.
+ * Arguments: An int for the file descriptor and a pointer that
+ *            receives the array of items.
+ * Returns: The number of items.
+ *******************************************************************/
+int readItems(int fd, char*** items)
+{
+    size_t capacity = READ_BLOCK;
+    size_t length = 0;
+    char *data = arenaAlloc(&cmdArena, capacity);
+    char *line;
+    char *newline;
+    ssize_t bytesRead;
+    int itemCount = 0;
+    int itemCapacity = ARGS_START;
+
+    /* Reads the whole input, doubling the buffer as it fills. */
+    while((bytesRead = read(fd, data + length, capacity - length - 1)) != 0){
+        if(bytesRead < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        length += bytesRead;
+        if(length == capacity - 1){
+            data = arenaResize(&cmdArena, data, capacity, capacity * 2);
+            capacity *= 2;
+        }
+    }
+    data[length] = '\0';
+
+    /* Splits the input into lines in place. */
+    *items = arenaAlloc(&cmdArena, itemCapacity * sizeof(char*));
+    for(line = data; *line != '\0'; line = newline + 1){
+        newline = strchr(line, '\n');
+        if(newline == NULL){
+            newline = line + strlen(line) - 1;  // Treats the last unterminated line like any other.
+        }
+        else{
+            *newline = '\0';
+        }
+        if(*line == '\0'){
+            continue;   // Skips blank lines.
+        }
+        if(itemCount == itemCapacity){
+            *items = arenaResize(&cmdArena, *items, itemCapacity * sizeof(char*), 2 * itemCapacity * sizeof(char*));
+            itemCapacity *= 2;
+        }
+        (*items)[itemCount++] = line;
+    }
+    return itemCount;
+}
+
+
+/*******************************************************************
+ * Name: bool finishParallelJob(pid_t processId, int processValue,
+ *                              struct rusage* usage)
+ * Description: Reports a reaped job of the running "parallel"
+ *              command and frees its worker slot.
+ * Arguments: A pid_t for the process ID, an int for its status and
+ *            a pointer to its rusage struct.
+ * Returns: True if the process was one of the command's jobs.
+ *******************************************************************/
+bool finishParallelJob(pid_t processId, int processValue, struct rusage* usage)
+{
+    int slot;   // Index for loop.
+    int job;
+
+    for(slot = 0; slot < activeRun->slots; slot++){
+        if(activeRun->pids[slot] != processId){
+            continue;
+        }
+        job = activeRun->jobIndex[slot];
+        if(WIFEXITED(processValue)){
+            printf("[%d] exit value %d (%.3fs): %s\n", job + 1, WEXITSTATUS(processValue),
+                   secondsSince(&activeRun->started[slot]), activeRun->items[job]);
+        }
+        else{
+            printf("[%d] terminated by signal %d (%.3fs): %s\n", job + 1, WTERMSIG(processValue),
+                   secondsSince(&activeRun->started[slot]), activeRun->items[job]);
+        }
+        if(WIFEXITED(processValue) == false || WEXITSTATUS(processValue) != 0){
+            activeRun->failed++;
+        }
+        addUsage(usage);
+        if(cmdTimeFormat != TIME_OFF){
+            fflush(stdout);
+            printUsage(cmdTimeFormat, processId, processValue, secondsSince(&activeRun->started[slot]), usage, false);
+        }
+        activeRun->pids[slot] = -1;
+        activeRun->running--;
+        return true;
+    }
+    return false;
+}
+
+
+/*******************************************************************
+ * Name: void parallelBuiltin(struct parsedInput* obj)
+ * Description: Handles "parallel [-j N] command [args] ::: items".
+ *              Runs the command once per item with the item as its
+ *              last argument, keeping N jobs running (one per
+ *              online CPU by default). Without ":::" the items are
+ *              read one per line from the '<' file or stdin. A new
+ *              job is launched as soon as the SIGCHLD self-pipe
+ *              reports that one has been reaped. ^C stops the
+ *              launching and ends the jobs still running.
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void parallelBuiltin(struct parsedInput* obj)
+{
+    struct parallelRun run;
+    struct parsedInput job;         // Command line shared by every job.
+    struct pollfd wakeup;           // Waits on the self-pipe for reaped jobs.
+    struct timespec started;        // Stores when the command started.
+    char **items;                   // Stores the argument for each job.
+    int itemCount = 0;
+    int first = 1;                  // Index of the command within the arguments.
+    int separator;                  // Index of ":::", or argNum when absent.
+    int next = 0;                   // Next item to launch.
+    int base[3] = {-1, -1, -1};     // The shell's own descriptors.
+    struct fdPlan plan;             // Redirections of the parallel command itself.
+    int jobFds[3];                  // Descriptors every job receives.
+    long long deadline;             // When jobs still running after ^C are killed.
+    int timeout;                    // Milliseconds left before then, or -1 once they have been.
+    int slot;
+    int i;                          // Index for loop.
+
+    run.slots = sysconf(_SC_NPROCESSORS_ONLN);
+    if(obj->argNum > 1 && strncmp(obj->arguments[1], "-j", 2) == 0){
+        if(obj->arguments[1][2] != '\0'){
+            run.slots = atoi(obj->arguments[1] + 2);    // Accepts "-jN".
+            first = 2;
+        }
+        else{
+            run.slots = (obj->argNum > 2) ? atoi(obj->arguments[2]) : 0;
+            first = 3;
+        }
+    }
+    for(separator = first; separator < obj->argNum; separator++){
+        if(strcmp(obj->arguments[separator], ":::") == 0){
+            break;
+        }
+    }
+    if(run.slots < 1 || separator == first){
+        printf("usage: parallel [-j N] command [args...] [::: items...]\n");
+        foregroundValue = 2 << 8;
+        return;
+    }
+
+    if(redirectIO(obj, base, &plan) != 0){
+        foregroundValue = 1 << 8;
+        return;
+    }
+
+    /* Collects the items from the command line or one per input line. */
+    if(separator < obj->argNum){
+        items = obj->arguments + separator + 1;
+        itemCount = obj->argNum - separator - 1;
+    }
+    else{
+        itemCount = readItems((plan.fds[0] != -1) ? plan.fds[0] : STDIN_FILENO, &items);
+    }
+    jobFds[0] = -1;     // Jobs read the shell's stdin, not the item list.
+    jobFds[1] = plan.fds[1];
+    jobFds[2] = plan.fds[2];
+
+    /* Builds the shared command line with one slot left for the item. */
+    job.backMode = false;
+    job.expand = false;
+    job.redirects = NULL;
+    job.redirectNum = 0;
+    job.redirectCapacity = 0;
+    job.argNum = separator - first + 1;
+    job.argCapacity = job.argNum;
+    job.arguments = arenaAlloc(&cmdArena, (job.argNum + 1) * sizeof(char*));
+    for(i = first; i < separator; i++){
+        job.arguments[i - first] = obj->arguments[i];
+    }
+    job.arguments[job.argNum] = NULL;
+
+    run.items = items;
+    run.pids = arenaAlloc(&cmdArena, run.slots * sizeof(pid_t));
+    run.jobIndex = arenaAlloc(&cmdArena, run.slots * sizeof(int));
+    run.started = arenaAlloc(&cmdArena, run.slots * sizeof(struct timespec));
+    run.running = 0;
+    run.failed = 0;
+    for(slot = 0; slot < run.slots; slot++){
+        run.pids[slot] = -1;
+    }
+
+    wakeup.fd = childPipe[0];
+    wakeup.events = POLLIN;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    fflush(stdout);
+    signalMessage = 0;
+    activeRun = &run;
+
+    while(next < itemCount || run.running > 0){
+        /* Fills every idle worker slot with the next job. */
+        for(slot = 0; slot < run.slots && next < itemCount; slot++){
+            if(run.pids[slot] != -1){
+                continue;
+            }
+            job.arguments[job.argNum - 1] = items[next];
+            clock_gettime(CLOCK_MONOTONIC, &run.started[slot]);
+            run.pids[slot] = forkProcesses(&job, jobFds, -1);
+            if(run.pids[slot] == -1){
+                run.failed++;   // The command could not start; forkProcesses printed why.
+                next++;
+                slot--;         // Tries the same slot again with the next item.
+                continue;
+            }
+            run.jobIndex[slot] = next++;
+            run.running++;
+        }
+
+        /* Sleeps until SIGCHLD, then reaps whatever has finished. */
+        if(run.running > 0){
+            poll(&wakeup, 1, -1);
+            reapBackground();
+        }
+        if(signalMessage == SIGINT){
+            break;      // ^C stops the launching.
+        }
+    }
+
+    /* Interrupts the jobs still running after ^C, killing any left when END_GRACE milliseconds are over. */
+    if(signalMessage == SIGINT){
+        deadline = monotonicNs() + END_GRACE * 1000000LL;
+        timeout = END_GRACE;
+        for(slot = 0; slot < run.slots; slot++){
+            if(run.pids[slot] != -1){
+                kill(run.pids[slot], SIGINT);
+            }
+        }
+        while(true){
+            reapBackground();
+            if(run.running == 0){
+                break;
+            }
+            if(timeout == 0){
+                for(slot = 0; slot < run.slots; slot++){
+                    if(run.pids[slot] != -1){
+                        kill(run.pids[slot], SIGKILL);
+                    }
+                }
+                timeout = -1;
+            }
+            poll(&wakeup, 1, timeout);
+            if(timeout > 0){
+                timeout = (deadline - monotonicNs()) / 1000000;
+                if(timeout < 0){
+                    timeout = 0;
+                }
+            }
+        }
+    }
+
+    activeRun = NULL;
+    closePlan(&plan);
+    printf("parallel: %d jobs, %d failed, %.3fs wall\n", itemCount, run.failed, secondsSince(&started));
+    foregroundValue = (run.failed > 0) ? 1 << 8 : 0;
+    if(signalMessage == SIGINT){
+        interrupted = true;     // The loops around the command stop too.
+        foregroundValue = (128 + SIGINT) << 8;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void trapStopSig(int sig)
+ * Description: Handles the stop signal (^z) to enter or exit from
+ *              foreground mode.
+ * Arguments: An int representing the signal.
+ *******************************************************************/
+void trapStopSig(int sig)
+{
+    /* Enters foreground mode. */
+    if(foregroundMode == false){
+        char* message = ("\nEntering foreground-only mode (& is now ignored)\n");
+        write(STDOUT_FILENO, message, 50);
+        signalMessage = sig;
+        foregroundMode = true;  // Updates status of foreground mode global variable.
+    }
+    /* Exits from foreground mode. */
+    else{
+        char* message = "\nExiting foreground-only mode\n"; // exit Fg mode.
+        write(STDOUT_FILENO, message, 31);
+        signalMessage = sig;
+        foregroundMode = false; // Updates status of foreground mode global variable.
+    }
+}
+
+
+/*******************************************************************
+ * Name: void trapChildSig(int sig)
+ * Description: Handles signal when a child process is ending by
+ *              waking the main loop through the self-pipe. Reaping
+ *              happens outside the handler in reapBackground.
+ * Arguments: An int representing the signal.
+ *******************************************************************/
+void trapChildSig(int sig)
+{
+    int savedErrno = errno; // Preserves errno for the interrupted code.
+    struct timespec now;
+
+    if(tracing == true){
+        clock_gettime(CLOCK_MONOTONIC, &now);   // Async-signal-safe; lets the trace measure reap latency.
+        childSignalNs = now.tv_sec * 1000000000LL + now.tv_nsec;
+    }
+    childPending = 1;
+    write(childPipe[1], "c", 1);    // A full pipe already holds a pending wakeup, so failure is harmless.
+    errno = savedErrno;
+}
+
+
+/*******************************************************************
+ * Name: bool reapBackground()
+ * Description: Drains the self-pipe and queues a completion
+ *              message for each background process that exited or
+ *              was terminated, and one for each background job that
+ *              was stopped. A job is freed once all of its processes
+ *              have ended.
+ * Arguments: None.
+ * Returns: True if any message was queued.
+ *******************************************************************/
+bool reapBackground()
+{
+    char drain[64];     // Discards pending wakeup bytes.
+    pid_t childPid;
+    int childStatus;
+    struct rusage usage;    // Resource usage of each child, from wait4.
+    struct jobSlot slot;    // Copy of the ended process's slot in the job table.
+    struct jobSlot *found;  // Slot of a stopped or continued process.
+    const char *late;       // Notes a process ended by its job's deadline.
+    bool queued = false;
+
+    childPending = 0;
+    while(read(childPipe[0], drain, sizeof(drain)) > 0); // Empties the self-pipe before checking children.
+
+    /* Collects every child that exited, was terminated, stopped or continued, one wait4 per child. */
+    while((childPid = wait4(-1, &childStatus, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0){
+        if(WIFSTOPPED(childStatus) || WIFCONTINUED(childStatus)){
+            found = findBackPid(childPid);
+            if(found == NULL || found->job->stopped == WIFSTOPPED(childStatus)){
+                continue;   // Not a background job, or already known.
+            }
+            found->job->stopped = WIFSTOPPED(childStatus);
+            if(found->job->stopped == true){
+                listJob(found->job);    // A job that stops becomes the current job.
+                queueNotice("\n[%d]+  Stopped                 %s\n", found->job->number, found->job->command);
+                queued = true;
+            }
+            continue;
+        }
+        if(tracing == true){
+            traceReap(childPid, childStatus, monotonicNs());
+        }
+        if(activeRun != NULL && finishParallelJob(childPid, childStatus, &usage) == true){
+            continue;   // Reported by the "parallel" command.
+        }
+        if(removeBackPid(childPid, &slot) == false){
+            continue;   // Not a background process; nothing to report.
+        }
+        late = (slot.job->timedOut == true) ? "timed out, " : "";
+        if(WIFEXITED(childStatus)){ // Handles messaging if process exited.
+            queueNotice("\nBackground pid %d is done: %sexit value %d\n", childPid, late, WEXITSTATUS(childStatus));
+        }
+        else{   // Handles messaging if process was terminated.
+            queueNotice("\nBackground pid %d is done: %sterminated by signal %d\n", childPid, late, WTERMSIG(childStatus));
+        }
+        if(slot.job->timeFormat != TIME_OFF){
+            printUsage(slot.job->timeFormat, childPid, childStatus, secondsSince(&slot.job->started), &usage, true);
+        }
+        if(endJobProcess(slot.job, childPid, childStatus) == true){
+            dropJob(slot.job);
+        }
+        queued = true;
+    }
+    return queued;
+}
+
+
+/*******************************************************************
+ * Name: void queueNotice(const char* format, ...)
+ * Description: Adds a formatted completion message to the notice
+ *              queue, growing it as needed.
+ * Arguments: Pointer to char for a printf format and its values.
+ *******************************************************************/
+void queueNotice(const char* format, ...)
+{
+    va_list values;
+    int needed;
+
+    while(true){
+        va_start(values, format);
+        needed = vsnprintf(notices.data + notices.length, notices.capacity - notices.length, format, values);
+        va_end(values);
+        if(needed < 0 || notices.length + needed < notices.capacity){
+            break;
+        }
+        /* Grows the queue until the message fits, then formats it again. */
+        if(notices.capacity == 0){
+            notices.capacity = 1024;
+        }
+        while(notices.capacity <= notices.length + needed){
+            notices.capacity *= 2;
+        }
+        notices.data = realloc(notices.data, notices.capacity);
+        if(notices.data == NULL){
+            printf("Unable to allocate memory\n");
+            exit(1);
+        }
+    }
+    if(needed > 0){
+        notices.length += needed;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void flushNotices()
+ * Description: Prints every queued completion message with a
+ *              single write, after anything already buffered on
+ *              stdout.
+ * Arguments: None.
+ *******************************************************************/
+void flushNotices()
+{
+    size_t written = 0;
+    ssize_t result;
+
+    if(notices.length == 0){
+        return;
+    }
+    fflush(stdout);
+    while(written < notices.length){
+        result = write(STDOUT_FILENO, notices.data + written, notices.length - written);
+        if(result < 0 && errno == EINTR){
+            continue;
+        }
+        if(result <= 0){
+            break;  // Drops what cannot be written rather than holding up the prompt.
+        }
+        written += result;
+    }
+    notices.length = 0;
+}
+
+
+/*******************************************************************
+ * Name: void openInput(int argc, char *argv[], char* command)
+ * Description: Chooses where commands come from: the -c string, a
+ *              script file named after the options (mapped into
+ *              memory), or stdin. Only a terminal on stdin gets a
+ *              prompt; other input is read in large blocks.
+ * Arguments: The command line argument count and vector, and a
+ *            pointer to char for the -c string or NULL.
+ *******************************************************************/
+void openInput(int argc, char *argv[], char* command)
+{
+    struct stat info;
+    int scriptFd;
+
+    reader.start = 0;
+    reader.fd = -1;
+    reader.eof = true;
+    interactive = false;
+
+    if(command != NULL){
+        reader.data = command;
+        reader.end = strlen(command);
+        return;
+    }
+    if(optind < argc){
+        scriptFd = open(argv[optind], O_RDONLY | O_CLOEXEC);
+        if(scriptFd < 0 || fstat(scriptFd, &info) != 0){
+            fprintf(stderr, "%s: cannot open script\n", argv[optind]);
+            exit(127);
+        }
+        reader.data = "";
+        reader.end = info.st_size;
+        if(info.st_size > 0){
+            reader.data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, scriptFd, 0);
+            if(reader.data == MAP_FAILED){
+                fprintf(stderr, "%s: cannot read script\n", argv[optind]);
+                exit(127);
+            }
+            madvise(reader.data, info.st_size, MADV_SEQUENTIAL);
+        }
+        close(scriptFd);
+        return;
+    }
+
+    interactive = isatty(STDIN_FILENO);
+    if(interactive == true){
+        initEditor();   // Edits lines typed at the terminal.
+    }
+    reader.capacity = (interactive == true) ? MAX_CHARS : READ_BLOCK;
+    reader.data = malloc(reader.capacity);
+    reader.end = 0;
+    reader.fd = STDIN_FILENO;
+    reader.eof = false;
+}
+
+
+/*******************************************************************
+ * Name: char* readLine()
+ * Description: Reads one line of input of any length into cmdArena.
+ *              While waiting at a prompt, polls the self-pipe so
+ *              ended background processes are reported without
+ *              delay.
+ * Arguments: None.
+ * Returns: The line ending in a newline, or NULL once input is
+ *          exhausted.
+ *******************************************************************/
+char* readLine()
+{
+    struct pollfd fds[3];   // Watches stdin, the self-pipe and the deadlines.
+    char *inputBuffer;      // Stores the line handed back.
+    char *newline;          // Locates the end of the buffered line.
+    size_t length;          // Length of the line handed back.
+    ssize_t bytesRead;
+
+    if(editor.enabled == true){
+        return editLine();
+    }
+    fds[0].fd = reader.fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = childPipe[0];
+    fds[1].events = POLLIN;
+    fds[2].events = POLLIN;
+
+    while(true){
+        newline = memchr(reader.data + reader.start, '\n', reader.end - reader.start);
+        length = reader.end - reader.start;
+        if(newline != NULL){
+            length = newline - (reader.data + reader.start) + 1;    // Includes the newline.
+        }
+        if(newline != NULL || (reader.eof && length > 0)){
+            inputBuffer = arenaAlloc(&cmdArena, length + 2);    // Leaves room to add a missing newline.
+            memcpy(inputBuffer, reader.data + reader.start, length);
+            reader.start += length;
+            if(inputBuffer[length - 1] != '\n'){
+                inputBuffer[length++] = '\n';   // Terminates a final unterminated line like any other.
+            }
+            inputBuffer[length] = '\0';
+            return inputBuffer;
+        }
+        if(reader.eof){
+            return NULL;
+        }
+
+        /* Moves the partial line to the front so there is room to read more. */
+        memmove(reader.data, reader.data + reader.start, length);
+        reader.start = 0;
+        reader.end = length;
+        if(reader.end == reader.capacity){
+            reader.capacity *= 2;   // Grows the buffer for a line longer than it.
+            reader.data = realloc(reader.data, reader.capacity);
+            if(reader.data == NULL){
+                printf("Unable to allocate memory\n");
+                exit(1);
+            }
+        }
+
+        if(interactive == true){
+            fds[2].fd = deadlineLoop;   // Ignored by poll while it is -1.
+            if(poll(fds, 3, -1) < 0){
+                continue;   // Interrupted by a signal; checks again.
+            }
+            if(fds[2].revents & POLLIN){
+                checkDeadlines();
+            }
+            if(fds[1].revents & POLLIN){
+                if(reapBackground() == true){
+                    flushNotices();
+                    printf("%s", prompt);   // Reprints the prompt after background messages.
+                    fflush(stdout);
+                }
+            }
+            if((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0){
+                continue;
+            }
+        }
+        bytesRead = read(reader.fd, reader.data + reader.end, reader.capacity - reader.end);
+        if(bytesRead > 0){
+            reader.end += bytesRead;
+        }
+        else if(bytesRead == 0 || errno != EINTR){
+            reader.eof = true;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: void initEditor()
+ * Description: Turns the line editor on when both stdin and stdout
+ *              are a terminal that understands cursor movement.
+ * Arguments: None.
+ *******************************************************************/
+void initEditor()
+{
+    char *term = getenv("TERM");
+
+    editor.enabled = false;
+    if(isatty(STDOUT_FILENO) == false || term == NULL || strcmp(term, "dumb") == 0
+            || tcgetattr(STDIN_FILENO, &editor.cooked) != 0){
+        return;     // Falls back to reading whole lines as the terminal delivers them.
+    }
+    editor.enabled = true;
+    editor.columns = 80;
+}
+
+
+/*******************************************************************
+ * Name: void reserveBuffer(struct editBuffer* buf, size_t length)
+ * Description: Makes room for at least length bytes in a buffer,
+ *              doubling it as needed.
+ * Arguments: A pointer to an editBuffer struct and the room needed.
+ *******************************************************************/
+void reserveBuffer(struct editBuffer* buf, size_t length)
+{
+    size_t capacity = (buf->capacity > 0) ? buf->capacity : EDIT_START;
+
+    if(length <= buf->capacity){
+        return;
+    }
+    while(capacity < length){
+        capacity *= 2;
+    }
+    buf->data = realloc(buf->data, capacity);
+    if(buf->data == NULL){
+        printf("Unable to allocate memory\n");
+        exit(1);
+    }
+    buf->capacity = capacity;
+}
+
+
+/*******************************************************************
+ * Name: void insertText(struct editBuffer* buf, size_t at,
+ *                       const char* text, size_t length)
+ * Description: Inserts text into a buffer at the given offset.
+ * Arguments: A pointer to an editBuffer struct, the offset, and
+ *            pointer to char for the text and its length.
+ *******************************************************************/
+void insertText(struct editBuffer* buf, size_t at, const char* text, size_t length)
+{
+    reserveBuffer(buf, buf->length + length);
+    memmove(buf->data + at + length, buf->data + at, buf->length - at);
+    memcpy(buf->data + at, text, length);
+    buf->length += length;
+}
+
+
+/*******************************************************************
+ * Name: void eraseText(struct editBuffer* buf, size_t at,
+ *                      size_t length)
+ * Description: Removes length bytes from a buffer at the given
+ *              offset.
+ * Arguments: A pointer to an editBuffer struct, the offset and the
+ *            number of bytes.
+ *******************************************************************/
+void eraseText(struct editBuffer* buf, size_t at, size_t length)
+{
+    memmove(buf->data + at, buf->data + at + length, buf->length - at - length);
+    buf->length -= length;
+}
+
+
+/*******************************************************************
+ * Name: void editorPrintf(const char* format, ...)
+ * Description: Adds formatted text to the editor's output, which is
+ *              written to the terminal in one call by writeEditor.
+ * Arguments: A format string as for printf, and its values.
+ *******************************************************************/
+void editorPrintf(const char* format, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, format);
+    length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    reserveBuffer(&editor.out, editor.out.length + length + 1);
+    va_start(args, format);
+    vsnprintf(editor.out.data + editor.out.length, length + 1, format, args);
+    va_end(args);
+    editor.out.length += length;
+}
+
+
+/*******************************************************************
+ * Name: void writeEditor()
+ * Description: Writes the editor's gathered output to the terminal.
+ * Arguments: None.
+ *******************************************************************/
+void writeEditor()
+{
+    size_t written = 0;
+    ssize_t result;
+
+    while(written < editor.out.length){
+        result = write(STDOUT_FILENO, editor.out.data + written, editor.out.length - written);
+        if(result < 0 && errno == EINTR){
+            continue;
+        }
+        if(result <= 0){
+            break;
+        }
+        written += result;
+    }
+    editor.out.length = 0;
+}
+
+
+/*******************************************************************
+ * Name: size_t textColumns(const char* text, size_t length)
+ * Description: Counts the screen columns text takes, one for each
+ *              character, so UTF-8 continuation bytes count for
+ *              nothing.
+ * Arguments: Pointer to char for the text and its length in bytes.
+ * Returns: The number of columns.
+ *******************************************************************/
+size_t textColumns(const char* text, size_t length)
+{
+    size_t columns = 0;
+    size_t i;   // Index for loop.
+
+    for(i = 0; i < length; i++){
+        if(((unsigned char)text[i] & 0xc0) != 0x80){
+            columns++;
+        }
+    }
+    return columns;
+}
+
+
+/*******************************************************************
+ * Name: void moveCursor(size_t from, size_t to)
+ * Description: Adds the shortest escape sequences that move the
+ *              terminal's cursor between two columns of the view,
+ *              counting from the start of the prompt across
+ *              wrapped rows.
+ * Arguments: The column the cursor is at and the one it should be.
+ *******************************************************************/
+void moveCursor(size_t from, size_t to)
+{
+    size_t width = editor.columns;
+
+    if(to / width < from / width){
+        editorPrintf("\x1b[%zuA", from / width - to / width);
+    }
+    else if(to / width > from / width){
+        editorPrintf("\x1b[%zuB", to / width - from / width);
+    }
+    if(to % width == from % width){
+        return;
+    }
+    if(to % width == 0){
+        editorPrintf("\r");
+    }
+    else if(to % width > from % width){
+        editorPrintf("\x1b[%zuC", to % width - from % width);
+    }
+    else{
+        editorPrintf("\x1b[%zuD", from % width - to % width);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void refreshLine()
+ * Description: Brings the terminal up to date with the line being
+ *              edited. The new view is compared with what is on
+ *              screen and only the part from the first difference
+ *              on is rewritten, so typing at the end of a line
+ *              sends a single byte even over a slow link.
+ * Arguments: None.
+ *******************************************************************/
+void refreshLine()
+{
+    struct winsize size;
+    struct editBuffer *view = &editor.view;
+    struct editBuffer *shown = &editor.shown;
+    size_t same = 0;    // Bytes at the start of the view already on screen.
+    size_t columns;     // Columns the new view takes.
+
+    /* Builds the prompt and line as they should appear. */
+    view->length = 0;
+    if(editor.searching == true){
+        insertText(view, 0, "(reverse-i-search)`", 19);
+        insertText(view, view->length, editor.pattern.data, editor.pattern.length);
+        insertText(view, view->length, "': ", 3);
+    }
+    else{
+        insertText(view, 0, prompt, strlen(prompt));
+    }
+    editor.viewCursor = view->length + editor.cursor;
+    insertText(view, view->length, editor.line.data, editor.line.length);
+
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0){
+        editor.columns = size.ws_col;
+    }
+
+    while(same < view->length && same < shown->length && view->data[same] == shown->data[same]){
+        same++;
+    }
+    while(same > 0 && same < view->length && ((unsigned char)view->data[same] & 0xc0) == 0x80){
+        same--;     // Starts rewriting at the beginning of a character.
+    }
+    if(same < view->length || same < shown->length){
+        moveCursor(textColumns(shown->data, editor.screenCursor), textColumns(view->data, same));
+        insertText(&editor.out, editor.out.length, view->data + same, view->length - same);
+        columns = textColumns(view->data, view->length);
+        if(columns > 0 && columns % editor.columns == 0){
+            editorPrintf("\n");     // Leaves the last column, where the cursor's position is ambiguous.
+        }
+        if(textColumns(shown->data, shown->length) > columns){
+            editorPrintf("\x1b[J");     // Clears the rest of a longer old line.
+        }
+        shown->length = 0;
+        insertText(shown, 0, view->data, view->length);
+        editor.screenCursor = view->length;
+    }
+    moveCursor(textColumns(view->data, editor.screenCursor), textColumns(view->data, editor.viewCursor));
+    editor.screenCursor = editor.viewCursor;
+    writeEditor();
+}
+
+
+/*******************************************************************
+ * Name: void leaveLine()
+ * Description: Moves the cursor to the end of the line being
+ *              edited, so other output can follow it. The next
+ *              refreshLine draws the prompt and line again in full.
+ * Arguments: None.
+ *******************************************************************/
+void leaveLine()
+{
+    moveCursor(textColumns(editor.shown.data, editor.screenCursor), textColumns(editor.shown.data, editor.shown.length));
+    writeEditor();
+    editor.shown.length = 0;
+    editor.screenCursor = 0;
+}
+
+
+/*******************************************************************
+ * Name: int decodeKey(const char* data, size_t length, size_t* used)
+ * Description: Decodes one key from the bytes the terminal sent:
+ *              a plain byte, an Alt combination, or a CSI or SS3
+ *              escape sequence for the arrows and editing keys.
+ * Arguments: Pointer to char for the bytes and their number, and a
+ *            pointer to size_t that receives how many were used.
+ * Returns: The byte, one of the KEY_ constants, or KEY_PARTIAL when
+ *          an escape sequence is not complete yet.
+ *******************************************************************/
+int decodeKey(const char* data, size_t length, size_t* used)
+{
+    size_t i = 2;   // Index past the sequence's parameters.
+    bool modified;  // Indicates Ctrl or Alt was held with an arrow.
+
+    *used = 1;
+    if(data[0] != '\x1b'){
+        return (unsigned char)data[0];
+    }
+    if(length < 2){
+        return KEY_PARTIAL;
+    }
+    *used = 2;
+    if(data[1] != '[' && data[1] != 'O'){
+        switch(data[1])     // Alt held with a key.
+        {
+            case 'b':
+                return KEY_WORD_LEFT;
+            case 'f':
+                return KEY_WORD_RIGHT;
+            case 'd':
+                return KEY_KILL_WORD;
+            case 0x7f:
+            case 0x08:
+                return KEY_RUBOUT_WORD;
+            default:
+                return KEY_UNKNOWN;
+        }
+    }
+
+    while(i < length && data[i] >= 0x30 && data[i] <= 0x3f){
+        i++;    // Skips parameter bytes such as "1;5".
+    }
+    if(i == length){
+        return KEY_PARTIAL;
+    }
+    *used = i + 1;
+    modified = (memchr(data + 2, ';', i - 2) != NULL);
+    switch(data[i])
+    {
+        case 'A':
+            return KEY_UP;
+        case 'B':
+            return KEY_DOWN;
+        case 'C':
+            return (modified == true) ? KEY_WORD_RIGHT : KEY_RIGHT;
+        case 'D':
+            return (modified == true) ? KEY_WORD_LEFT : KEY_LEFT;
+        case 'H':
+            return KEY_HOME;
+        case 'F':
+            return KEY_END;
+        case '~':
+            switch(atoi(data + 2))
+            {
+                case 1:
+                case 7:
+                    return KEY_HOME;
+                case 4:
+                case 8:
+                    return KEY_END;
+                case 3:
+                    return KEY_DELETE;
+            }
+    }
+    return KEY_UNKNOWN;
+}
+
+
+/*******************************************************************
+ * Name: int readKey()
+ * Description: Returns the next key typed. Everything already read
+ *              is handled before the screen is redrawn, so a paste
+ *              costs one redraw. While waiting, background process
+ *              messages are printed above the line, and a ^C drops
+ *              the line being typed.
+ * Arguments: None.
+ * Returns: The key, or KEY_EOF once the terminal is closed.
+ *******************************************************************/
+int readKey()
+{
+    struct pollfd fds[3];   // Watches stdin, the self-pipe and the deadlines.
+    size_t used;
+    int key;
+    int ready;
+    ssize_t bytesRead;
+    bool partial = false;   // Indicates an escape sequence is waiting for its other bytes.
+
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    fds[1].fd = childPipe[0];
+    fds[1].events = POLLIN;
+    fds[2].events = POLLIN;
+
+    while(true){
+        if(editor.inputStart < editor.inputEnd){
+            key = decodeKey(editor.input + editor.inputStart, editor.inputEnd - editor.inputStart, &used);
+            if(key != KEY_PARTIAL){
+                editor.inputStart += used;
+                return key;
+            }
+            partial = true;
+        }
+        else{
+            refreshLine();
+        }
+
+        /* Moves a partial escape sequence to the front so there is room to read the rest. */
+        memmove(editor.input, editor.input + editor.inputStart, editor.inputEnd - editor.inputStart);
+        editor.inputEnd -= editor.inputStart;
+        editor.inputStart = 0;
+
+        fds[2].fd = deadlineLoop;   // Ignored by poll while it is -1.
+        ready = poll(fds, (partial == true) ? 1 : 3, (partial == true) ? ESCAPE_WAIT : -1);
+        if(ready == 0){
+            editor.inputStart++;    // A lone Escape, with nothing following it.
+            return KEY_UNKNOWN;
+        }
+        if(signalMessage != 0){
+            if(signalMessage == SIGINT){
+                editor.line.length = 0;     // Drops the line, as ^C does in other shells.
+                editor.cursor = 0;
+                editor.searching = false;
+                editor.browsing = 0;
+            }
+            signalMessage = 0;
+            editor.shown.length = 0;    // The handler's message took the cursor to a new line.
+            editor.screenCursor = 0;
+        }
+        if(ready < 0){
+            continue;   // Interrupted by a signal; checks again.
+        }
+        if(partial == false && (fds[2].revents & POLLIN)){
+            checkDeadlines();
+        }
+        if(partial == false && (fds[1].revents & POLLIN)){
+            if(reapBackground() == true && notices.length > 0){
+                leaveLine();
+                flushNotices();     // Prints the messages, which start on a new line, above a fresh copy of the line.
+            }
+        }
+        if((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0){
+            continue;
+        }
+        bytesRead = read(STDIN_FILENO, editor.input + editor.inputEnd, EDIT_READ - editor.inputEnd);
+        if(bytesRead > 0){
+            editor.inputEnd += bytesRead;
+        }
+        else if(bytesRead == 0 || errno != EINTR){
+            return KEY_EOF;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * Name: size_t previousChar(size_t at)
+ * Description: Finds the start of the character before an offset
+ *              in the line.
+ * Arguments: A byte offset in the line, above zero.
+ * Returns: The offset of the previous character.
+ *******************************************************************/
+size_t previousChar(size_t at)
+{
+    do{
+        at--;
+    } while(at > 0 && ((unsigned char)editor.line.data[at] & 0xc0) == 0x80);
+    return at;
+}
+
+
+/*******************************************************************
+ * Name: size_t nextChar(size_t at)
+ * Description: Finds the start of the character after an offset in
+ *              the line.
+ * Arguments: A byte offset in the line, below its length.
+ * Returns: The offset of the next character.
+ *******************************************************************/
+size_t nextChar(size_t at)
+{
+    do{
+        at++;
+    } while(at < editor.line.length && ((unsigned char)editor.line.data[at] & 0xc0) == 0x80);
+    return at;
+}
+
+
+/*******************************************************************
+ * Name: size_t wordStart(size_t at)
+ * Description: Finds the start of the word before an offset, where
+ *              words are letters, digits and underscores.
+ * Arguments: A byte offset in the line.
+ * Returns: The offset of the word's first character.
+ *******************************************************************/
+size_t wordStart(size_t at)
+{
+    char *line = editor.line.data;
+
+    while(at > 0 && !(isalnum((unsigned char)line[at - 1]) || line[at - 1] == '_')){
+        at--;
+    }
+    while(at > 0 && (isalnum((unsigned char)line[at - 1]) || line[at - 1] == '_')){
+        at--;
+    }
+    return at;
+}
+
+
+/*******************************************************************
+ * Name: size_t wordEnd(size_t at)
+ * Description: Finds the end of the word after an offset, where
+ *              words are letters, digits and underscores.
+ * Arguments: A byte offset in the line.
+ * Returns: The offset just past the word's last character.
+ *******************************************************************/
+size_t wordEnd(size_t at)
+{
+    char *line = editor.line.data;
+
+    while(at < editor.line.length && !(isalnum((unsigned char)line[at]) || line[at] == '_')){
+        at++;
+    }
+    while(at < editor.line.length && (isalnum((unsigned char)line[at]) || line[at] == '_')){
+        at++;
+    }
+    return at;
+}
+
+
+/*******************************************************************
+ * Name: void killText(size_t start, size_t end)
+ * Description: Removes part of the line into the kill buffer for a
+ *              later yank. Kills made one after another are joined,
+ *              in the order the text appeared.
+ * Arguments: Byte offsets of the start and end of the text.
+ *******************************************************************/
+void killText(size_t start, size_t end)
+{
+    if(editor.killing == false){
+        editor.killed.length = 0;
+    }
+    if(start < editor.cursor){
+        insertText(&editor.killed, 0, editor.line.data + start, end - start);  // Killing backwards puts the text first.
+    }
+    else{
+        insertText(&editor.killed, editor.killed.length, editor.line.data + start, end - start);
+    }
+    eraseText(&editor.line, start, end - start);
+    editor.cursor = start;
+    editor.killing = true;
+}
+
+
+/*******************************************************************
+ * Name: void setLine(const char* text, size_t length)
+ * Description: Replaces the whole line, leaving the cursor at its
+ *              end.
+ * Arguments: Pointer to char for the text and its length.
+ *******************************************************************/
+void setLine(const char* text, size_t length)
+{
+    editor.line.length = 0;
+    insertText(&editor.line, 0, text, length);
+    editor.cursor = length;
+}
+
+
+/*******************************************************************
+ * Name: bool startBrowsing()
+ * Description: Catches up with lines other shells added to the
+ *              history and keeps the new line aside, before history
+ *              is browsed or searched.
+ * Arguments: None.
+ * Returns: False if there is no history.
+ *******************************************************************/
+bool startBrowsing()
+{
+    if(hist.fd == -1){
+        return false;
+    }
+    if(editor.browsing == 0){
+        flock(hist.fd, LOCK_SH);
+        mapHistory();
+        flock(hist.fd, LOCK_UN);
+        editor.draft.length = 0;
+        insertText(&editor.draft, 0, editor.line.data, editor.line.length);
+        editor.browsing = hist.header->count + 1;
+    }
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void browseHistory(int direction)
+ * Description: Shows the previous or next history entry in place of
+ *              the line. Moving past the newest entry brings back
+ *              the line that was being typed.
+ * Arguments: An int, -1 for older and 1 for newer.
+ *******************************************************************/
+void browseHistory(int direction)
+{
+    long next;
+    char *text;
+    size_t length;
+
+    if(editor.browsing == 0 && direction > 0){
+        return;     // Already on the new line.
+    }
+    if(startBrowsing() == false || editor.browsing + direction < 1){
+        editorPrintf("\a");
+        return;
+    }
+    next = editor.browsing + direction;
+    text = historyLine(next, &length);
+    if(text == NULL){
+        setLine(editor.draft.data, editor.draft.length);
+        editor.browsing = 0;
+        return;
+    }
+    setLine(text, length);
+    editor.browsing = next;
+}
+
+
+/*******************************************************************
+ * Name: bool searchKey(int key)
+ * Description: Handles a key during a ^R search. Typed characters
+ *              narrow the search, ^R finds an older match, ^G gives
+ *              up, and any other key keeps the match and is then
+ *              handled as usual.
+ * Arguments: An int for the key.
+ * Returns: False once the search has ended and the key still needs
+ *          handling.
+ *******************************************************************/
+bool searchKey(int key)
+{
+    struct editBuffer *pattern = &editor.pattern;
+    long before;    // Entries older than this are searched.
+    long found;
+    char *text;
+    char c = key;
+    size_t length;
+
+    if(key == CTRL_KEY('G')){
+        editor.searching = false;
+        setLine(editor.draft.data, editor.draft.length);
+        editor.browsing = 0;
+        return true;
+    }
+    if(key == CTRL_KEY('R')){
+        before = (editor.found > 0) ? editor.found : (long)hist.header->count + 1;
+    }
+    else if(key == 0x7f || key == CTRL_KEY('H')){
+        if(pattern->length > 0){
+            pattern->length--;
+        }
+        before = hist.header->count + 1;    // Starts again from the newest entry.
+    }
+    else if((key >= ' ' && key != 0x7f && key < 256)){
+        insertText(pattern, pattern->length, &c, 1);
+        before = (editor.found > 0) ? editor.found + 1 : (long)hist.header->count + 1;
+    }
+    else{
+        editor.searching = false;
+        return false;
+    }
+
+    found = searchHistory(pattern->data, pattern->length, before);
+    if(found == 0){
+        if(key != CTRL_KEY('R') && key != 0x7f && key != CTRL_KEY('H')){
+            pattern->length--;  // Keeps the last match rather than showing none.
+        }
+        editorPrintf("\a");
+        return true;
+    }
+    text = historyLine(found, &length);
+    setLine(text, length);
+    editor.cursor = (char*)memmem(text, length, pattern->data, pattern->length) - text;
+    editor.found = found;
+    editor.browsing = found;
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: int compareEntries(const void* a, const void* b, void* text)
+ * Description: Orders directory entries by name for qsort_r.
+ * Arguments: Pointers to the two entry offsets, and the listing's
+ *            block of names.
+ * Returns: Less than, equal to or greater than zero, as strcmp.
+ *******************************************************************/
+int compareEntries(const void* a, const void* b, void* text)
+{
+    return strcmp((char*)text + *(const size_t*)a, (char*)text + *(const size_t*)b);
+}
+
+
+/*******************************************************************
+ * Name: struct dirListing* listDirectory(const char* path)
+ * Description: Returns a directory's entries, sorted, from the
+ *              cache. The directory is only read again once its
+ *              mtime changes, so repeated completions cost one
+ *              stat. A listing read in the same second as the
+ *              change it saw is checked again next time, in case a
+ *              second change shares that mtime.
+ * Arguments: Pointer to char for the directory's path.
+ * Returns: The listing, or NULL if the directory cannot be read.
+ *******************************************************************/
+struct dirListing* listDirectory(const char* path)
+{
+    struct dirListing *listing;
+    struct stat info;
+    struct dirent *entry;
+    DIR *dir;
+    size_t length;
+    size_t used = 0;        // Bytes of the names block filled.
+    size_t capacity = 0;    // Room in the names block.
+    int room = 0;           // Room in the offsets array.
+    unsigned int bucket = hashName(path);
+
+    if(stat(path, &info) != 0 || S_ISDIR(info.st_mode) == false){
+        return NULL;
+    }
+    for(listing = dirCache[bucket]; listing != NULL; listing = listing->next){
+        if(strcmp(listing->path, path) == 0){
+            break;
+        }
+    }
+    if(listing != NULL && listing->settled == true
+            && listing->mtime.tv_sec == info.st_mtim.tv_sec && listing->mtime.tv_nsec == info.st_mtim.tv_nsec){
+        return listing;     // Nothing was added or removed since the last read.
+    }
+
+    dir = opendir(path);
+    if(dir == NULL){
+        return NULL;
+    }
+    if(listing == NULL){
+        listing = calloc(1, sizeof(struct dirListing));
+        listing->path = strdup(path);
+        listing->next = dirCache[bucket];
+        dirCache[bucket] = listing;
+    }
+    else{
+        capacity = listing->capacity;
+        room = listing->room;
+    }
+    listing->count = 0;
+    while((entry = readdir(dir)) != NULL){
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0){
+            continue;
+        }
+        length = strlen(entry->d_name) + 1;
+        if(used + length > capacity){
+            capacity = (capacity > 0) ? capacity * 2 : EDIT_START * 16;
+            while(used + length > capacity){
+                capacity *= 2;
+            }
+            listing->names = realloc(listing->names, capacity);
+        }
+        if(listing->count == room){
+            room = (room > 0) ? room * 2 : EDIT_START;
+            listing->offsets = realloc(listing->offsets, room * sizeof(size_t));
+        }
+        if(listing->names == NULL || listing->offsets == NULL){
+            printf("Unable to allocate memory\n");
+            exit(1);
+        }
+        memcpy(listing->names + used, entry->d_name, length);
+        listing->offsets[listing->count++] = used;
+        used += length;
+    }
+    closedir(dir);
+    qsort_r(listing->offsets, listing->count, sizeof(size_t), compareEntries, listing->names);
+
+    listing->capacity = capacity;
+    listing->room = room;
+    listing->mtime = info.st_mtim;
+    listing->settled = (time(NULL) > info.st_mtim.tv_sec + 1);
+    return listing;
+}
+
+
+/*******************************************************************
+ * Name: void addMatches(struct dirListing* listing,
+ *                       const char* prefix, size_t length,
+ *                       struct completion* found)
+ * Description: Adds the names in a listing that start with a prefix
+ *              to the completions. A binary search finds the first
+ *              one, so large directories cost little. Hidden names
+ *              only match a prefix that starts with a dot.
+ * Arguments: A pointer to a dirListing struct, pointer to char for
+ *            the prefix and its length, and a pointer to a
+ *            completion struct.
+ *******************************************************************/
+void addMatches(struct dirListing* listing, const char* prefix, size_t length, struct completion* found)
+{
+    int low = 0;
+    int high = listing->count;
+    int middle;
+    char *name;
+
+    while(low < high){
+        middle = (low + high) / 2;
+        if(strncmp(listing->names + listing->offsets[middle], prefix, length) < 0){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+    for(; low < listing->count; low++){
+        name = listing->names + listing->offsets[low];
+        if(strncmp(name, prefix, length) != 0){
+            break;
+        }
+        if(name[0] == '.' && (length == 0 || prefix[0] != '.')){
+            continue;
+        }
+        addCompletion(found, name);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void addCompletion(struct completion* found, char* name)
+ * Description: Adds a name to the completions, which live in
+ *              cmdArena until the line is done.
+ * Arguments: A pointer to a completion struct and pointer to char
+ *            for the name.
+ *******************************************************************/
+void addCompletion(struct completion* found, char* name)
+{
+    if(found->count == found->capacity){
+        found->names = arenaResize(&cmdArena, found->names, found->capacity * sizeof(char*),
+                2 * found->capacity * sizeof(char*));
+        found->capacity *= 2;
+    }
+    found->names[found->count++] = name;
+}
+
+
+/*******************************************************************
+ * Name: int compareNames(const void* a, const void* b)
+ * Description: Orders completions by name for qsort.
+ * Arguments: Pointers to the two names.
+ * Returns: Less than, equal to or greater than zero, as strcmp.
+ *******************************************************************/
+int compareNames(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+
+/*******************************************************************
+ * Name: void insertEscaped(const char* text, size_t length)
+ * Description: Inserts completed text at the cursor, with a
+ *              backslash before each character the lexer would
+ *              otherwise treat specially.
+ * Arguments: Pointer to char for the text and its length.
+ *******************************************************************/
+void insertEscaped(const char* text, size_t length)
+{
+    size_t i;   // Index for loop.
+
+    for(i = 0; i < length; i++){
+        if(strchr(" \t'\"\\$|&<>;#!", text[i]) != NULL){
+            insertText(&editor.line, editor.cursor++, "\\", 1);
+        }
+        insertText(&editor.line, editor.cursor++, text + i, 1);
+    }
+}
+
+
+/*******************************************************************
+ * Name: void listCompletions(struct completion* found)
+ * Description: Prints the completions below the line in columns,
+ *              down then across as ls does. The line is drawn again
+ *              under them.
+ * Arguments: A pointer to a completion struct.
+ *******************************************************************/
+void listCompletions(struct completion* found)
+{
+    size_t width = 0;   // Widest name.
+    int perRow;
+    int rows;
+    int row;
+    int i;      // Index for loop.
+
+    leaveLine();
+    editorPrintf("\n");
+    if(found->count > LIST_LIMIT){
+        editorPrintf("%d possibilities\n", found->count);
+        return;
+    }
+    for(i = 0; i < found->count; i++){
+        if(textColumns(found->names[i], strlen(found->names[i])) > width){
+            width = textColumns(found->names[i], strlen(found->names[i]));
+        }
+    }
+    width += 2;
+    perRow = (editor.columns > (int)width) ? editor.columns / width : 1;
+    rows = (found->count + perRow - 1) / perRow;
+    for(row = 0; row < rows; row++){
+        for(i = row; i < found->count; i += rows){
+            if(i + rows < found->count){
+                editorPrintf("%s%*s", found->names[i],
+                        (int)(width - textColumns(found->names[i], strlen(found->names[i]))), "");
+            }
+            else{
+                editorPrintf("%s", found->names[i]);
+            }
+        }
+        editorPrintf("\n");
+    }
+}
+
+
+/*******************************************************************
+ * Name: void completeWord(bool list)
+ * Description: Completes the word before the cursor. The first word
+ *              of a command is completed from the builtins and the
+ *              PATH directories; other words, and any word with a
+ *              '/', from the files in their directory. A single
+ *              match is completed in full; otherwise the text all
+ *              matches share is added, and a second tab lists them.
+ * Arguments: A bool, true when the previous key was also a tab.
+ *******************************************************************/
+void completeWord(bool list)
+{
+    struct completion found;
+    struct dirListing *listing;
+    struct stat info;
+    char *line = editor.line.data;
+    char *word;             // The word typed, with backslashes and quotes removed.
+    char *prefix;           // Part of word matched against names.
+    char *directory;        // Directory searched, with a trailing '/'.
+    char *path;             // Copy of PATH, split up by strsep.
+    char *entry;            // Each PATH directory in turn.
+    char *slash;
+    size_t start = editor.cursor;   // Start of the word in the line.
+    size_t before;          // End of whatever precedes the word.
+    size_t length = 0;
+    size_t shared;          // Bytes every match has in common.
+    bool command;           // Indicates the word names a command.
+    int i;      // Index for loop.
+
+    while(start > 0 && (strchr(" \t|&;<>", line[start - 1]) == NULL || (start > 1 && line[start - 2] == '\\'))){
+        start--;
+    }
+    word = arenaAlloc(&cmdArena, editor.cursor - start + 1);
+    for(i = start; i < (int)editor.cursor; i++){
+        if(line[i] == '\\' && i + 1 < (int)editor.cursor){
+            i++;
+        }
+        else if(line[i] == '\'' || line[i] == '"'){
+            continue;
+        }
+        word[length++] = line[i];
+    }
+    word[length] = '\0';
+    for(before = start; before > 0 && (line[before - 1] == ' ' || line[before - 1] == '\t'); before--){
+    }
+    command = (before == 0 || strchr("|&;", line[before - 1]) != NULL) && strchr(word, '/') == NULL;
+
+    found.capacity = ARGS_START;
+    found.count = 0;
+    found.names = arenaAlloc(&cmdArena, found.capacity * sizeof(char*));
+    directory = "";
+    prefix = word;
+    if(command == true){
+        for(i = 0; i < (int)(sizeof(builtins) / sizeof(builtins[0])); i++){
+            if(strncmp(builtins[i].name, word, length) == 0){
+                addCompletion(&found, (char*)builtins[i].name);
+            }
+        }
+        entry = getVariable("PATH");
+        path = arenaAlloc(&cmdArena, strlen(entry != NULL ? entry : "") + 1);
+        strcpy(path, entry != NULL ? entry : "");
+        while(path != NULL){
+            entry = strsep(&path, ":");
+            listing = listDirectory(*entry != '\0' ? entry : ".");     // An empty entry means the working directory.
+            if(listing != NULL){
+                addMatches(listing, word, length, &found);
+            }
+        }
+    }
+    else{
+        slash = strrchr(word, '/');
+        if(slash != NULL){
+            prefix = slash + 1;
+            directory = arenaAlloc(&cmdArena, prefix - word + 1);
+            memcpy(directory, word, prefix - word);
+            directory[prefix - word] = '\0';
+        }
+        listing = listDirectory(*directory != '\0' ? directory : ".");
+        if(listing != NULL){
+            addMatches(listing, prefix, strlen(prefix), &found);
+        }
+    }
+    if(found.count == 0){
+        editorPrintf("\a");
+        return;
+    }
+
+    /* Sorts the matches and drops names found in more than one PATH directory. */
+    qsort(found.names, found.count, sizeof(char*), compareNames);
+    length = 1;
+    for(i = 1; i < found.count; i++){
+        if(strcmp(found.names[i], found.names[length - 1]) != 0){
+            found.names[length++] = found.names[i];
+        }
+    }
+    found.count = length;
+
+    length = strlen(prefix);
+    if(found.count == 1){
+        insertEscaped(found.names[0] + length, strlen(found.names[0]) - length);
+        path = arenaAlloc(&cmdArena, strlen(directory) + strlen(found.names[0]) + 1);
+        sprintf(path, "%s%s", directory, found.names[0]);
+        if(command == false && stat(path, &info) == 0 && S_ISDIR(info.st_mode)){
+            insertText(&editor.line, editor.cursor++, "/", 1);
+        }
+        else{
+            insertText(&editor.line, editor.cursor++, " ", 1);
+        }
+        return;
+    }
+    for(shared = length; found.names[0][shared] != '\0'; shared++){
+        for(i = 1; i < found.count && found.names[i][shared] == found.names[0][shared]; i++){
+        }
+        if(i < found.count){
+            break;
+        }
+    }
+    if(shared > length){
+        insertEscaped(found.names[0] + length, shared - length);
+    }
+    else if(list == true){
+        listCompletions(&found);
+    }
+    else{
+        editorPrintf("\a");
+    }
+}
+
+
+/*******************************************************************
+ * Name: int handleKey(int key)
+ * Description: Carries out one key of line editing.
+ * Arguments: An int for the key.
+ * Returns: EDIT_MORE to keep editing, EDIT_DONE once the line is
+ *          entered, or EDIT_EOF for ^D on an empty line.
+ *******************************************************************/
+int handleKey(int key)
+{
+    size_t at = editor.cursor;
+    size_t length = editor.line.length;
+    int last = editor.lastKey;  // Previous key, so a second tab lists the matches.
+    char c = key;
+
+    editor.lastKey = key;
+    if(key != CTRL_KEY('K') && key != CTRL_KEY('U') && key != CTRL_KEY('W')
+            && key != KEY_KILL_WORD && key != KEY_RUBOUT_WORD){
+        editor.killing = false;     // Later kills start the kill buffer afresh.
+    }
+    if(editor.searching == true && searchKey(key) == true){
+        return EDIT_MORE;
+    }
+
+    switch(key)
+    {
+        case '\r':
+        case '\n':
+            return EDIT_DONE;
+        case KEY_EOF:
+            return EDIT_EOF;
+        case CTRL_KEY('D'):
+            if(length == 0){
+                return EDIT_EOF;
+            }
+            /* Falls through to delete the character under the cursor. */
+        case KEY_DELETE:
+            if(at < length){
+                eraseText(&editor.line, at, nextChar(at) - at);
+            }
+            break;
+        case 0x7f:
+        case CTRL_KEY('H'):
+            if(at > 0){
+                editor.cursor = previousChar(at);
+                eraseText(&editor.line, editor.cursor, at - editor.cursor);
+            }
+            break;
+        case CTRL_KEY('A'):
+        case KEY_HOME:
+            editor.cursor = 0;
+            break;
+        case CTRL_KEY('E'):
+        case KEY_END:
+            editor.cursor = length;
+            break;
+        case CTRL_KEY('B'):
+        case KEY_LEFT:
+            if(at > 0){
+                editor.cursor = previousChar(at);
+            }
+            break;
+        case CTRL_KEY('F'):
+        case KEY_RIGHT:
+            if(at < length){
+                editor.cursor = nextChar(at);
+            }
+            break;
+        case KEY_WORD_LEFT:
+            editor.cursor = wordStart(at);
+            break;
+        case KEY_WORD_RIGHT:
+            editor.cursor = wordEnd(at);
+            break;
+        case CTRL_KEY('K'):
+            killText(at, length);
+            break;
+        case CTRL_KEY('U'):
+            killText(0, at);
+            break;
+        case CTRL_KEY('W'):
+            while(at > 0 && (editor.line.data[at - 1] == ' ' || editor.line.data[at - 1] == '\t')){
+                at--;
+            }
+            while(at > 0 && editor.line.data[at - 1] != ' ' && editor.line.data[at - 1] != '\t'){
+                at--;
+            }
+            killText(at, editor.cursor);
+            break;
+        case KEY_RUBOUT_WORD:
+            killText(wordStart(at), at);
+            break;
+        case KEY_KILL_WORD:
+            killText(at, wordEnd(at));
+            break;
+        case CTRL_KEY('Y'):
+            insertText(&editor.line, at, editor.killed.data, editor.killed.length);
+            editor.cursor += editor.killed.length;
+            break;
+        case CTRL_KEY('L'):
+            editorPrintf("\x1b[H\x1b[2J");  // Clears the screen; the line is drawn again at the top.
+            editor.shown.length = 0;
+            editor.screenCursor = 0;
+            break;
+        case CTRL_KEY('P'):
+        case KEY_UP:
+            browseHistory(-1);
+            break;
+        case CTRL_KEY('N'):
+        case KEY_DOWN:
+            browseHistory(1);
+            break;
+        case CTRL_KEY('R'):
+            if(startBrowsing() == false){
+                editorPrintf("\a");
+                break;
+            }
+            editor.searching = true;
+            editor.pattern.length = 0;
+            editor.found = 0;
+            break;
+        case '\t':
+            completeWord(last == '\t');
+            break;
+        default:
+            if((key >= ' ' && key < 0x7f) || (key >= 0x80 && key < 256)){
+                insertText(&editor.line, at, &c, 1);
+                editor.cursor++;
+            }
+            break;
+    }
+    return EDIT_MORE;
+}
+
+
+/*******************************************************************
+ * Name: char* editLine()
+ * Description: Reads a line from the terminal with editing. The
+ *              terminal is in raw mode only while the line is typed,
+ *              so commands run with the settings they expect. Keys
+ *              typed ahead of the prompt are kept for the next line.
+ * Arguments: None.
+ * Returns: The line ending in a newline, in cmdArena, or NULL at
+ *          the end of input.
+ *******************************************************************/
+char* editLine()
+{
+    struct termios raw;
+    char *inputBuffer;      // Stores the line handed back.
+    int result = EDIT_MORE;
+
+    tcgetattr(STDIN_FILENO, &editor.cooked);
+    raw = editor.cooked;
+    raw.c_iflag &= ~(ICRNL | IXON | INLCR);     // Delivers Enter as '\r' and ^S and ^Q as keys.
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN);   // Leaves ISIG on, so ^C and ^Z still signal the shell.
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    editor.line.length = 0;
+    editor.cursor = 0;
+    editor.browsing = 0;
+    editor.searching = false;
+    editor.lastKey = 0;
+    editor.killing = false;
+    editor.shown.length = 0;
+    insertText(&editor.shown, 0, prompt, strlen(prompt));   // The main loop or readMore has printed the prompt.
+    editor.screenCursor = editor.shown.length;
+    signalMessage = 0;
+
+    while(result == EDIT_MORE){
+        result = handleKey(readKey());
+    }
+    if(result == EDIT_DONE){
+        editor.searching = false;
+        editor.cursor = editor.line.length;
+        refreshLine();
+        editorPrintf("\n");
+        writeEditor();
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &editor.cooked);
+    if(result == EDIT_EOF){
+        printf("\n");
+        return NULL;
+    }
+
+    inputBuffer = arenaAlloc(&cmdArena, editor.line.length + 2);
+    memcpy(inputBuffer, editor.line.data, editor.line.length);
+    inputBuffer[editor.line.length] = '\n';
+    inputBuffer[editor.line.length + 1] = '\0';
+    return inputBuffer;
+}
+
+
+/*******************************************************************
+ * Name: bool openHistory()
+ * Description: Opens the history file named by $HISTFILE, or
+ *              ~/.smallsh_history, and its index beside it with an
+ *              ".idx" suffix. The index is brought up to date with
+ *              any lines other shells wrote since it was last used,
+ *              so opening never rescans the whole file.
+ * Arguments: None.
+ * Returns: False if there is no history to use.
+ *******************************************************************/
+bool openHistory()
+{
+    char path[4096];        // Stores the history file name.
+    char indexPath[4100];   // Stores the index file name, four bytes longer.
+    const char *name = getVariable("HISTFILE");
+    const char *home = getVariable("HOME");
+    struct stat info;
+    size_t smallest = sizeof(struct historyHeader) + HISTORY_GROW * sizeof(struct historyEntry);
+
+    if(hist.fd != -1){
+        return true;
+    }
+    if(name != NULL && *name != '\0'){
+        snprintf(path, sizeof(path), "%s", name);
+    }
+    else if(home != NULL){
+        snprintf(path, sizeof(path), "%s/.smallsh_history", home);
+    }
+    else{
+        return false;
+    }
+    snprintf(indexPath, sizeof(indexPath), "%s.idx", path);
+
+    hist.fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    hist.indexFd = open(indexPath, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(hist.fd < 0 || hist.indexFd < 0){
+        printf("history: cannot open %s\n", (hist.fd < 0) ? path : indexPath);
+        if(hist.fd >= 0){
+            close(hist.fd);
+        }
+        if(hist.indexFd >= 0){
+            close(hist.indexFd);
+        }
+        hist.fd = hist.indexFd = -1;
+        return false;
+    }
+
+    flock(hist.fd, LOCK_EX);    // Every change to either file happens under this lock.
+    if(fstat(hist.indexFd, &info) == 0 && (size_t)info.st_size < smallest){
+        ftruncate(hist.indexFd, smallest);  // Creates an empty index; zeroed bytes fail the magic check.
+    }
+    syncHistory();
+    flock(hist.fd, LOCK_UN);
+    return true;
+}
+
+
+/*******************************************************************
+ * Name: void mapHistory()
+ * Description: Maps the history and index files again when either
+ *              has grown since they were last mapped, whether this
+ *              shell or another one appended to them.
+ * Arguments: None.
+ *******************************************************************/
+void mapHistory()
+{
+    struct stat info;
+
+    if(fstat(hist.indexFd, &info) == 0 && (size_t)info.st_size > hist.indexSize){
+        if(hist.header != NULL){
+            munmap(hist.header, hist.indexSize);
+        }
+        hist.header = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, hist.indexFd, 0);
+        if(hist.header == MAP_FAILED){
+            printf("history: cannot map index\n");
+            exit(1);
+        }
+        hist.indexSize = info.st_size;
+    }
+    if(fstat(hist.fd, &info) == 0 && (size_t)info.st_size > hist.textSize){
+        if(hist.text != NULL){
+            munmap(hist.text, hist.textSize);
+        }
+        hist.text = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, hist.fd, 0);
+        if(hist.text == MAP_FAILED){
+            printf("history: cannot map history\n");
+            exit(1);
+        }
+        hist.textSize = info.st_size;
+    }
+}
+
+
+/*******************************************************************
+ * Name: void syncHistory()
+ * Description: Indexes every complete line of the history file
+ *              past the bytes the index already covers. An index
+ *              that does not match the file (a new index, or a
+ *              history file truncated by hand) is rebuilt from the
+ *              start. Called with the history file locked.
+ * Arguments: None.
+ *******************************************************************/
+void syncHistory()
+{
+    struct historyHeader *header;
+    char *newline;      // Locates the end of each unindexed line.
+    uint64_t offset;    // Start of the next line to index.
+
+    mapHistory();
+    header = hist.header;
+    if(header->magic != HISTORY_MAGIC || header->buckets != HISTORY_BUCKETS
+            || header->indexedBytes > hist.textSize
+            || sizeof(struct historyHeader) + header->count * sizeof(struct historyEntry) > hist.indexSize
+            || (header->indexedBytes > 0 && hist.text[header->indexedBytes - 1] != '\n')){
+        memset(header, 0, hist.indexSize);
+        header->magic = HISTORY_MAGIC;
+        header->buckets = HISTORY_BUCKETS;
+    }
+
+    offset = header->indexedBytes;
+    while(offset < hist.textSize){
+        newline = memchr(hist.text + offset, '\n', hist.textSize - offset);
+        if(newline == NULL){
+            break;  // Leaves a partial line for whoever finishes it.
+        }
+        indexHistory(offset, newline - (hist.text + offset));
+        offset = newline - hist.text + 1;
+    }
+}
+
+
+/*******************************************************************
+ * Name: unsigned int historyBucket(const char* text, size_t length,
+ *                                  int key)
+ * Description: Chooses a prefix chain for a line from its first
+ *              historyKeys[key] bytes, or all of it when shorter.
+ * Arguments: Pointer to char for the line, its length, and which
+ *            key length to use.
+ *******************************************************************/
+unsigned int historyBucket(const char* text, size_t length, int key)
+{
+    unsigned int hash = 2166136261u;
+    size_t i;   // Index for loop.
+
+    if(length > historyKeys[key]){
+        length = historyKeys[key];
+    }
+    for(i = 0; i < length; i++){
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash & (HISTORY_BUCKETS - 1);
+}
+
+
+/*******************************************************************
+ * Name: void indexHistory(uint64_t offset, uint32_t length)
+ * Description: Adds a line of the history file to the index and
+ *              to the front of its prefix chains, growing the index
+ *              file when it is full. Called with the history file
+ *              locked.
+ * Arguments: The line's offset in the history file and its length
+ *            without the newline.
+ *******************************************************************/
+void indexHistory(uint64_t offset, uint32_t length)
+{
+    struct historyEntry *entry;
+    uint64_t count = hist.header->count;
+    uint64_t grow = (count < HISTORY_GROW) ? HISTORY_GROW : count;  // Doubles the index once it is large.
+    unsigned int bucket;
+    int key;    // Index for loop.
+
+    if(sizeof(struct historyHeader) + (count + 1) * sizeof(struct historyEntry) > hist.indexSize){
+        ftruncate(hist.indexFd, sizeof(struct historyHeader) + (count + grow) * sizeof(struct historyEntry));
+        mapHistory();
+    }
+    entry = (struct historyEntry*)(hist.header + 1) + count;
+    entry->offset = offset;
+    entry->length = length;
+    for(key = 0; key < HISTORY_KEYS; key++){
+        bucket = historyBucket(hist.text + offset, length, key);
+        entry->previous[key] = hist.header->heads[key][bucket];
+        hist.header->heads[key][bucket] = count + 1;
+    }
+    hist.header->indexedBytes = offset + length + 1;
+    hist.header->count = count + 1;     // Publishes the entry once it is complete.
+}
+
+
+/*******************************************************************
+ * Name: void addHistory(const char* line)
+ * Description: Appends a command line to the history file with a
+ *              single write and indexes it, along with anything
+ *              other shells appended in the meantime. Blank lines
+ *              are not recorded.
+ * Arguments: Pointer to char for the line, ending in a newline.
+ *******************************************************************/
+void addHistory(const char* line)
+{
+    if(hist.fd == -1 || line[strspn(line, " \t\n")] == '\0'){
+        return;
+    }
+    flock(hist.fd, LOCK_EX);
+    syncHistory();
+    if(hist.header->indexedBytes < hist.textSize){
+        write(hist.fd, "\n", 1);    // Ends a partial line left by something else, so ours starts a line.
+    }
+    write(hist.fd, line, strlen(line));
+    syncHistory();
+    flock(hist.fd, LOCK_UN);
+}
+
+
+/*******************************************************************
+ * Name: char* historyLine(long number, size_t* length)
+ * Description: Finds a history entry by its number in the index,
+ *              without touching any other line.
+ * Arguments: The entry number, counting from 1, and a pointer to
+ *            size_t that receives the line's length.
+ * Returns: The line within the mapped history file, not
+ *          NUL-terminated, or NULL (with a length of 0) if there
+ *          is no such entry.
+ *******************************************************************/
+char* historyLine(long number, size_t* length)
+{
+    struct historyEntry *entry;
+
+    if(number < 1 || (uint64_t)number > hist.header->count){
+        *length = 0;
+        return NULL;
+    }
+    entry = (struct historyEntry*)(hist.header + 1) + (number - 1);
+    *length = entry->length;
+    return hist.text + entry->offset;
+}
+
+
+/*******************************************************************
+ * Name: long findHistory(const char* prefix, size_t length)
+ * Description: Finds the newest entry starting with a prefix. Only
+ *              the entries in the prefix chain for the longest key
+ *              the prefix covers are visited, so "!make" skips
+ *              commands such as "man ls" that only share "ma". A
+ *              one-byte prefix is checked against entries from the
+ *              newest back.
+ *              Called with the history file locked.
+ * Arguments: Pointer to char for the prefix and its length.
+ * Returns: The entry number, or 0 if no entry matches.
+ *******************************************************************/
+long findHistory(const char* prefix, size_t length)
+{
+    struct historyEntry *entries = (struct historyEntry*)(hist.header + 1);
+    uint64_t current;   // Entry number being checked.
+    int key = HISTORY_KEYS - 1;
+
+    while(key >= 0 && length < historyKeys[key]){
+        key--;  // Picks the longest key the prefix covers.
+    }
+    if(key >= 0){
+        current = hist.header->heads[key][historyBucket(prefix, length, key)];
+        for(; current != 0; current = entries[current - 1].previous[key]){
+            if(entries[current - 1].length >= length
+                    && memcmp(hist.text + entries[current - 1].offset, prefix, length) == 0){
+                return current;
+            }
+        }
+        return 0;
+    }
+    for(current = hist.header->count; current != 0; current--){
+        if(entries[current - 1].length >= length
+                && memcmp(hist.text + entries[current - 1].offset, prefix, length) == 0){
+            return current;
+        }
+    }
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: long searchHistory(const char* text, size_t length,
+ *                          long before)
+ * Description: Finds the newest entry older than a given one that
+ *              contains some text, for reverse search.
+ * Arguments: Pointer to char for the text, its length, and the
+ *            entry number to search back from.
+ * Returns: The entry number, or 0 if no entry matches.
+ *******************************************************************/
+long searchHistory(const char* text, size_t length, long before)
+{
+    struct historyEntry *entries = (struct historyEntry*)(hist.header + 1);
+    long current;   // Entry number being checked.
+
+    for(current = before - 1; current > 0; current--){
+        if(memmem(hist.text + entries[current - 1].offset, entries[current - 1].length, text, length) != NULL){
+            return current;
+        }
+    }
+    return 0;
+}
+
+
+/*******************************************************************
+ * Name: char* expandHistory(char* line)
+ * Description: Replaces history events in a line read from the
+ *              terminal: "!!" for the last entry, "!n" and "!-n"
+ *              by number, "!?text?" for the newest entry containing
+ *              text and "!prefix" for the newest entry starting
+ *              with prefix. A '!' inside single quotes, after a
+ *              backslash or '$', or before a blank, '=' or '(' is
+ *              left alone. The expanded line is echoed, as in sh.
+ * Arguments: Pointer to char for the line, ending in a newline.
+ * Returns: The line, which lives in cmdArena once expanded, or NULL
+ *          after printing that an event was not found.
+ *******************************************************************/
+char* expandHistory(char* line)
+{
+    char *read = line;          // Next character to copy.
+    char *end;                  // First character after an event.
+    char *event;                // Entry that replaces an event.
+    char *expanded;             // Stores the expanded line.
+    size_t used = 0;            // Bytes of expanded filled so far.
+    size_t capacity;            // Room in expanded.
+    size_t length;              // Length of an entry.
+    size_t needed;
+    long number;                // Entry number of an event.
+    bool quoted = false;        // Indicates single quotes are open.
+
+    if(hist.fd == -1 || strchr(line, '!') == NULL){
+        return line;    // Nothing to expand, without touching the history.
+    }
+    capacity = strlen(line) + 1;
+    expanded = arenaAlloc(&cmdArena, capacity);
+
+    flock(hist.fd, LOCK_SH);
+    mapHistory();
+    while(*read != '\0'){
+        if(*read == '\''){
+            quoted = !quoted;
+        }
+        if(*read == '\\' && read[1] == '!'){
+            expanded[used++] = *read++;     // Keeps the backslash for the lexer to remove.
+        }
+        else if(*read == '!' && quoted == false && strchr(" \t\n=(", read[1]) == NULL
+                && (read == line || read[-1] != '$')){
+            end = read + 2;
+            if(read[1] == '!'){
+                number = hist.header->count;
+            }
+            else if(isdigit((unsigned char)read[1]) || (read[1] == '-' && isdigit((unsigned char)read[2]))){
+                number = strtol(read + 1, &end, 10);
+                if(number < 0){
+                    number += hist.header->count + 1;   // Counts back from the newest entry.
+                }
+            }
+            else if(read[1] == '?'){
+                end = read + 2 + strcspn(read + 2, "?\n");
+                number = searchHistory(read + 2, end - (read + 2), hist.header->count + 1);
+                if(*end == '?'){
+                    end++;
+                }
+            }
+            else{
+                end = read + 1 + strcspn(read + 1, " \t\n|<>&;'\"");
+                number = findHistory(read + 1, end - (read + 1));
+            }
+
+            event = historyLine(number, &length);
+            if(event == NULL){
+                flock(hist.fd, LOCK_UN);
+                printf("%.*s: event not found\n", (int)(end - read), read);
+                return NULL;
+            }
+            needed = used + length + strlen(end) + 1;
+            if(needed > capacity){
+                expanded = arenaResize(&cmdArena, expanded, capacity, 2 * needed);
+                capacity = 2 * needed;
+            }
+            memcpy(expanded + used, event, length);
+            used += length;
+            read = end;
+            continue;
+        }
+        expanded[used++] = *read++;
+    }
+    flock(hist.fd, LOCK_UN);
+    expanded[used] = '\0';
+
+    if(strcmp(expanded, line) != 0){
+        printf("%s", expanded);     // Shows the command about to run.
+        fflush(stdout);
+    }
+    return expanded;
+}
+
+
+/*******************************************************************
+ * Name: void historyBuiltin(struct parsedInput* obj)
+ * Description: Handles "history [N]", which lists every entry or
+ *              the newest N, and "history -s TEXT", which lists the
+ *              entries containing TEXT from the newest back. Entries
+ *              are numbered for use with "!n".
+ * Arguments: A pointer to an parsedInput struct.
+ *******************************************************************/
+void historyBuiltin(struct parsedInput* obj)
+{
+    char *line;
+    size_t length;
+    long count;
+    long number;    // Entry number being listed.
+    long first = 1; // Oldest entry listed.
+
+    if(openHistory() == false){
+        foregroundValue = 1 << 8;
+        return;
+    }
+    if(obj->argNum > 1 && (strcmp(obj->arguments[1], "-s") == 0 ? obj->argNum != 3 : atol(obj->arguments[1]) <= 0)){
+        printf("usage: history [N] | history -s TEXT\n");
+        foregroundValue = 2 << 8;
+        return;
+    }
+
+    flock(hist.fd, LOCK_SH);
+    mapHistory();
+    count = hist.header->count;
+    if(obj->argNum == 3){
+        length = strlen(obj->arguments[2]);
+        for(number = searchHistory(obj->arguments[2], length, count + 1); number != 0;
+                number = searchHistory(obj->arguments[2], length, number)){
+            line = historyLine(number, &length);
+            printf("%5ld  %.*s\n", number, (int)length, line);
+            length = strlen(obj->arguments[2]);
+        }
+    }
+    else{
+        if(obj->argNum > 1 && atol(obj->arguments[1]) < count){
+            first = count - atol(obj->arguments[1]) + 1;
+        }
+        for(number = first; number <= count; number++){
+            line = historyLine(number, &length);
+            printf("%5ld  %.*s\n", number, (int)length, line);
+        }
+    }
+    flock(hist.fd, LOCK_UN);
+    foregroundValue = 0;
+}
+
+
+/*******************************************************************
+ * Name: int exitValue()
+ * Description: Converts the last foreground status into the value
+ *              the shell exits with at the end of its input.
+ * Arguments: None.
+ *******************************************************************/
+int exitValue()
+{
+    return statusValue(foregroundValue);
+}
+
+
+/*******************************************************************
+ * Name: int statusValue(int processValue)
+ * Description: Converts a wait status into a shell exit value,
+ *              128 plus the signal for a terminated process.
+ * Arguments: An int for the wait status.
+ *******************************************************************/
+int statusValue(int processValue)
+{
+    if(WIFSIGNALED(processValue)){
+        return 128 + WTERMSIG(processValue);
+    }
+    return WEXITSTATUS(processValue);
+}
+
+
+/*******************************************************************
+ * Name: void trapTermSig(int sig)
+ * Description: Handles the terminate signal (^c).
+ * Arguments: An int representing the signal.
+ *******************************************************************/
+void trapTermSig(int sig)
+{
+    char message[] = "\nterminated by signal 00\n";   // Digits are filled in here since printf is not async-signal-safe.
+    size_t length = sizeof(message) - 1;
+    int savedErrno = errno; // Preserves errno for the interrupted code.
+
+    if(sig < 10){
+        message[22] = '0' + sig;
+        message[23] = '\n';
+        length--;
+    }
+    else{
+        message[22] = '0' + (sig / 10) % 10;
+        message[23] = '0' + sig % 10;
+    }
+    write(STDOUT_FILENO, message, length);  // Indicates signal that terminated the process.
+    signalMessage = sig;
+    errno = savedErrno;
+}
+
+
+/*******************************************************************
+ * Name: void endProcess()
+ * Description: Facilitates exiting by interupting every remaining
+ *              job, one signal per process group, and reaping each
+ *              process as SIGCHLD reports it. Jobs still running
+ *              after END_GRACE milliseconds are killed.
+ * Arguments: None.
+ *******************************************************************/
+void endProcess()
+{
+    struct pollfd wakeup = {childPipe[0], POLLIN, 0};
+    struct job *job;
+    long long deadline = monotonicNs() + END_GRACE * 1000000LL;
+    int timeout;    // Milliseconds left before the remaining jobs are killed, or -1 once they have been.
+    int i;          // Index for loop.
+
+    /* Interrupts every job at once; a stopped job is continued so it can act on it. */
+    for(job = jobList; job != NULL; job = job->next){
+        kill(-job->pgid, SIGINT);
+        if(job->stopped == true){
+            kill(-job->pgid, SIGCONT);
+        }
+    }
+
+    /* Reaps the jobs as they end, killing any left when the grace period is over. */
+    timeout = END_GRACE;
+    while(true){
+        reapBackground();
+        if(jobList == NULL){
+            break;
+        }
+        if(timeout == 0){
+            for(job = jobList; job != NULL; job = job->next){
+                kill(-job->pgid, SIGKILL);
+                for(i = 0; i < job->pidNum; i++){
+                    if(job->pids[i] != -1){
+                        kill(job->pids[i], SIGKILL);    // Also reaches a process that left the group.
+                    }
+                }
+            }
+            timeout = -1;
+        }
+        poll(&wakeup, 1, timeout);
+        if(timeout > 0){
+            timeout = (deadline - monotonicNs()) / 1000000;
+            if(timeout < 0){
+                timeout = 0;
+            }
+        }
+    }
+    flushNotices();     // Prints messages for processes that ended after the last prompt.
+    if(tracing == true){
+        stopTrace();    // Writes out the rest of the trace before the shell exits.
+    }
+}
+
+
+/*******************************************************************
+ * Name: void testBackMode()
+ * Description: If a stop signal is caught, the foreground mode is
+ *              switched.
+ * Arguments: None.
+ *******************************************************************/
+void testBackMode()
+{
+    /* Exits from foreground mode if already in mode when a stop signal is caught. */
+    if(WTERMSIG(foregroundValue) == 11 && foregroundMode == true){
+        printf("\nExiting foreground-only mode\n");
+        foregroundMode = false; // Toggles foreground mode status to false.
+    }
+    /* Enters foreground mode if not already in mode when a stop signal is caught. */
+    else if(WTERMSIG(foregroundValue) == 11 && foregroundMode == false){
+        printf("\nEntering foreground-only mode (& is now ignored)\n");
+        foregroundMode = true;  // Toggles foreground mode status to true.
+    }
 }
\ No newline at end of file
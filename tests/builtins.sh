@@ -0,0 +1,42 @@
+# printf, test and echo builtins.
+printf '[%5.2f]\n' 1
+printf '[%e] [%E]\n' 1234.5 0.001
+printf '[%g] [%G] [%g]\n' 0.0001 1e20 100
+printf '[%*d] [%-*d] [%.*f]\n' 5 42 4 7 2 3.14159
+printf '[%x] [%o] [%u] [%i]\n' 255 8 -1 0x10
+printf '[%d] [%d]\n' "'A" '"a'
+printf '%s=%d\n' a 1 b 2
+printf '[%d]\n' abc
+echo "bad number $?"
+printf '[%d]\n' 12abc
+echo "partial number $?"
+printf '[%f]\n' x
+echo "bad float $?"
+printf '[%q]\n' x
+echo "bad conversion $?"
+printf '%b|\x41\x62|\x7e\n' 'tab\there'
+test a = a -a b = b; echo "and $?"
+test a = a -a b = c; echo "and false $?"
+test a = b -o b = b; echo "or $?"
+test \( 1 -eq 1 \); echo "parens $?"
+test \( 1 -eq 2 \); echo "parens false $?"
+[ -d / -o -f x ]; echo "dir or file $?"
+[ -f x -o -d x ]; echo "neither $?"
+test ! \( a = b \) -a -n x; echo "not parens $?"
+test 1 -eq 1 -o 1 -eq 2 -a 1 -eq 3; echo "precedence $?"
+test a -a ''; echo "three and $?"
+test '' -o a; echo "three or $?"
+test ! -z ''; echo "not unary $?"
+test ! a = b; echo "not binary $?"
+test \( '' \); echo "parens string $?"
+test ! \( a \); echo "four not $?"
+test \( ! a \); echo "four parens $?"
+test = = =; echo "operator operands $?"
+test \( a = a; echo "unclosed $?"
+test a = a -a; echo "dangling $?"
+test a b c; echo "bad binary $?"
+test a = a b c; echo "extra $?"
+test 1 -eq x -o a; echo "bad integer $?"
+echo -e '\x41\x4a\x6b|\x|\xg|\x414'
+echo -e 'oct\0101 \101'
+echo '\x41'
@@ -0,0 +1,19 @@
+# cd with and without HOME.
+mkdir sub
+cd sub
+pwd | sed 's|.*/||'
+cd
+test "$(pwd)" = "$HOME" && echo home
+cd /cd/sub
+pwd | sed 's|.*/||'
+cd ~
+test "$(pwd)" = "$HOME" && echo tilde
+cd missing
+echo "missing $?"
+unset HOME
+cd
+echo "no home $?"
+cd ~
+echo "no home tilde $?"
+cd /tmp
+pwd
@@ -0,0 +1,43 @@
+# Lists, conditionals, loops and functions.
+true && echo and-ran
+false && echo and-skipped
+false || echo or-ran
+true || echo or-skipped
+! false && echo negated
+echo first; echo second
+if test a = b; then
+    echo wrong
+elif test a = a; then
+    echo elif-branch
+else
+    echo wrong
+fi
+x=a
+while test $x != aaaa; do
+    x=${x}a
+done
+echo while $x
+until test $x = a; do x=a; done
+echo until $x
+for i in 1 2 3 4 5; do
+    if test $i = 2; then continue; fi
+    if test $i = 4; then break; fi
+    echo for $i
+done
+for i in a b; do
+    for j in 1 2; do
+        if test $j = 2; then continue 2; fi
+        echo nested $i$j
+    done
+done
+{ echo group; echo braces; }
+greet() {
+    echo hi $1, $# args
+    return 3
+}
+greet you there
+echo returned $?
+count() { for w in $@; do echo word $w; done; }
+count x y
+if false; then echo no; fi
+echo empty-if $?
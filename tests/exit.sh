@@ -0,0 +1,23 @@
+# "exit" with and without a status.
+/proc/$$/exe -c 'exit 3'
+echo "exit 3: $?"
+/proc/$$/exe -c 'false; exit'
+echo "false then exit: $?"
+/proc/$$/exe -c 'true; exit'
+echo "true then exit: $?"
+/proc/$$/exe -c 'exit 256'
+echo "exit 256: $?"
+/proc/$$/exe -c 'exit -1'
+echo "exit -1: $?"
+/proc/$$/exe -c 'exit abc; echo not reached'
+echo "exit abc: $?"
+/proc/$$/exe -c 'exit 1 2; echo still running $?'
+echo "two arguments: $?"
+/proc/$$/exe -c 'for i in 1 2; do exit 4; done; echo not reached'
+echo "exit in a loop: $?"
+printf 'echo in script\nsh -c "exit 5"\nexit\necho not reached\n' > script
+/proc/$$/exe script
+echo "script: $?"
+printf 'exit 7\n' > script
+/proc/$$/exe script
+echo "script exit 7: $?"
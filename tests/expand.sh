@@ -0,0 +1,22 @@
+# Variables, quoting and parameter forms.
+name=world
+echo hello $name
+echo "hello $name" 'hello $name'
+echo ${name}wide $name.txt
+greeting="a  b"
+echo $greeting
+echo "$greeting"
+echo pre"mid"post 'single'"double"
+empty=
+echo [$empty] [$unset]
+false
+echo status $?
+true
+echo status $?
+echo args $# [$@]
+export SHARED=yes
+env | grep '^SHARED='
+unset name
+echo [$name]
+echo \$name "\"quoted\""
+echo a#notcomment # comment
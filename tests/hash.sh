@@ -0,0 +1,43 @@
+# The hash builtin and the remembered command table. PATH only holds the
+# test's own directories, so the table lists nothing else; other
+# utilities are run by path, and the listing goes through a file so the
+# scratch directory can be taken out of it.
+/bin/mkdir one two
+printf '#!/bin/sh\necho one\n' > one/mycmd
+printf '#!/bin/sh\necho two\n' > two/mycmd
+/bin/chmod +x one/mycmd two/mycmd
+PATH=$PWD/one
+hash
+mycmd
+mycmd
+hash > list
+/bin/sed "s|$PWD/||" list
+hash mycmd
+hash > list
+/bin/sed "s|$PWD/||" list
+hash /bin/sh
+echo "slash path $?"
+hash ./one/mycmd
+echo "relative path $?"
+hash ./missing
+echo "missing path $?"
+hash /
+echo "directory $?"
+hash nosuchcommand
+echo "missing name $?"
+hash > list
+/bin/sed "s|$PWD/||" list
+PATH=$PWD/two:$PWD/one
+mycmd
+hash > list
+/bin/sed "s|$PWD/||" list
+hash -r
+hash
+printf '#!/bin/sh\necho two\n' > two/mycmd
+/bin/chmod +x two/mycmd
+/proc/$$/exe -f -c 'mycmd; /bin/rm two/mycmd; mycmd; hash > list'
+/bin/sed "s|$PWD/||" list
+printf '#!/bin/sh\necho two\n' > two/mycmd
+/bin/chmod +x two/mycmd
+/proc/$$/exe -z -c 'mycmd; /bin/rm two/mycmd; mycmd; hash > list'
+/bin/sed "s|$PWD/||" list
@@ -0,0 +1,9 @@
+# History expansion and the history file, through a terminal since only
+# interactive input is recorded. The input is sent once the line editor
+# is running so the terminal does not echo it.
+export HISTFILE=$PWD/history
+sh -c '(sleep 0.5; printf "echo one\n!!\necho two\n!ec\n!1\n!nomatch\nhistory\nexit\n") | script -qec "$0" /dev/null | tr -d "\r"' /proc/$$/exe
+echo "session 1 $?"
+sh -c '(sleep 0.5; printf "!echo t\n!3\n!hist\nexit\n") | script -qec "$0" /dev/null | tr -d "\r"' /proc/$$/exe
+echo "session 2 $?"
+test -s history.idx && echo "index kept"
@@ -0,0 +1,12 @@
+# Job control builtins, "$!" and background reaping, run as a nested
+# script so the pids it prints can be replaced with N.
+printf '%s\n' 'sleep 0.3 &' 'test $! -gt 0 && echo "last set"' 'p=$!' 'sh -c "sleep 0.6; exit 3" &' 'jobs' > script
+printf '%s\n' 'wait $p' 'echo "wait last $?"' 'wait %2' 'echo "wait job $?"' >> script
+printf '%s\n' 'sh -c "exit 4" &' 'sleep 0.3' 'jobs' 'echo "reaped before jobs"' 'wait $!' 'echo "wait reaped last $?"' >> script
+printf '%s\n' 'wait 1' 'echo "wait unknown $?"' 'wait %7' 'echo "wait no job $?"' >> script
+printf '%s\n' 'sleep 1 &' '/bin/kill -STOP $!' 'sleep 0.2' 'jobs' 'bg %1' 'jobs' 'fg %1' 'echo "fg $?"' >> script
+printf '%s\n' 'sh -c "sleep 0.2; exit 6" &' 'fg' 'echo "fg current $?"' 'fg' 'echo "fg none $?"' >> script
+printf '%s\n' 'sleep 0.2 &' 'sh -c "sleep 0.1; exit 5" &' 'jobs' 'wait' 'echo "wait all $?"' 'jobs' >> script
+/proc/$$/exe script > out
+echo "shell $?"
+sed 's/pid is [0-9]*/pid is N/; s/pid [0-9]* is done/pid N is done/' out
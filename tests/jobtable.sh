@@ -0,0 +1,11 @@
+# Stress test for the job table: 10000 background jobs, each started and
+# reported exactly once, and 1000 of them running at the same time.
+/proc/$$/exe -c 'd="0 1 2 3 4 5 6 7 8 9"; for a in $d; do for b in $d; do for c in $d; do for e in $d; do /bin/true & done; done; done; done; sleep 1; true' > out
+echo "started $(grep -c '^Background pid is' out)"
+echo "done $(grep -c 'is done: exit value 0$' out)"
+grep '^Background pid is' out | sed 's/.* //' | sort > started
+grep 'is done: exit value 0$' out | sed 's/Background pid \([0-9]*\) .*/\1/' | sort > finished
+cmp started finished && echo "same pids"
+/proc/$$/exe -c 'd="0 1 2 3 4 5 6 7 8 9"; for b in $d; do for c in $d; do for e in $d; do /bin/sleep 2 & done; done; done; jobs > running; sleep 3; true' > out
+echo "running at once $(grep -c Running running)"
+echo "done $(grep -c 'is done: exit value 0$' out)"
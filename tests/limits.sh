@@ -0,0 +1,28 @@
+# Timeouts and resource limits.
+timeout 0.2 sleep 5
+echo "timed out $?"
+timeout 5 sh -c 'exit 3'
+echo "in time $?"
+timeout -s KILL 0.2 sleep 5
+echo "killed $?"
+timeout -s INT -k 0.2 0.1 sh -c 'trap "" INT; sleep 5'
+echo "kill after $?"
+timeout 0.2 sleep 5 | cat
+echo "pipeline $?"
+timeout 1m
+echo "usage $?"
+timeout 1x true
+echo "interval $?"
+ulimit -S -n 64
+ulimit -n
+ulimit -n 32 sh -c 'ulimit -n'
+ulimit -n
+ulimit -v unlimited timeout 5 sh -c 'ulimit -v'
+ulimit -t 1 timeout 10 sh -c 'while :; do :; done'
+echo "cpu $?"
+ulimit -n sh
+echo "no value $?"
+ulimit -z
+echo "bad option $?"
+/proc/$$/exe -z -c 'ulimit -S -n 64; sleep 0.1; sh -c "ulimit -n"; sh -c "ulimit -n"; ulimit -S -t 5; sleep 0.1; sh -c "ulimit -t"; sh -c "ulimit -t"'
+echo "workers $?"
@@ -0,0 +1,5 @@
+# ^C stops "parallel" from launching more jobs and ends the running ones.
+sh -c '"$0" -c "parallel -j 2 sleep ::: 5 5 5 5; echo not reached" > out & sleep 0.5; kill -INT $!; wait $!; echo "exit $?"' /proc/$$/exe
+sed 's/[0-9.]*s)/Ns)/; s/[0-9.]*s wall/Ns wall/' out
+sh -c '"$0" -c "for i in 1 2; do parallel -j 2 sh -c \"trap \\\"\\\" INT; sleep 5\" ::: a b c; done" > out & sleep 0.5; kill -INT $!; wait $!; echo "exit $?"' /proc/$$/exe
+sed 's/[0-9.]*s)/Ns)/; s/[0-9.]*s wall/Ns wall/' out
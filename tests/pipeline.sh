@@ -0,0 +1,16 @@
+# Pipelines and builtins.
+printf 'c\nb\na\n' | sort | head -n 2
+echo piped builtin | tr a-z A-Z
+ls /nonexistent 2>/dev/null | cat
+status
+cat /dev/null | false
+status
+mkdir sub
+cd sub
+pwd | sed 's|.*/||'
+cd ..
+test -d sub && echo is-dir
+[ abc = abc ] && echo brackets
+printf '%s-%s\n' one two three
+nosuchcommand
+status
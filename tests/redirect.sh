@@ -0,0 +1,15 @@
+# Redirections: >, >>, 2>, 2>&1, &>, <<< and <.
+echo one > out
+echo two >> out
+cat out
+ls /nonexistent 2> err
+cat err | wc -l
+ls /nonexistent > both 2>&1
+wc -l < both
+ls /nonexistent &> both2
+wc -l < both2
+cat <<< "here string"
+cat < out | tr a-z A-Z
+cat < missing
+status
+echo done
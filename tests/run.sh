@@ -0,0 +1,40 @@
+#!/bin/sh
+# Runs each script in this directory with the shell under test, in an
+# empty scratch directory, and compares its stdout, stderr and exit
+# status with the matching .out file. Used by "make test".
+#
+# Usage: sh tests/run.sh SHELL
+# Set UPDATE=1 to rewrite the .out files from the current output.
+
+if [ $# -ne 1 ]; then
+    echo "usage: sh tests/run.sh SHELL"
+    exit 2
+fi
+shell=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+dir=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d) || exit 2
+trap 'rm -rf "$work"' EXIT
+
+passed=0
+failed=0
+for test in "$dir"/*.sh; do
+    name=$(basename "$test" .sh)
+    if [ "$name" = run ]; then
+        continue
+    fi
+    mkdir "$work/$name"
+    (cd "$work/$name" && HOME="$work" "$shell" "$test" < /dev/null > "$work/$name.actual" 2>&1
+        echo "exit $?" >> "$work/$name.actual")
+    if [ "$UPDATE" = 1 ]; then
+        cp "$work/$name.actual" "$dir/$name.out"
+    fi
+    if diff -u "$dir/$name.out" "$work/$name.actual"; then
+        passed=$((passed + 1))
+    else
+        echo "FAIL: $name"
+        failed=$((failed + 1))
+    fi
+done
+
+echo "$passed passed, $failed failed"
+[ $failed -eq 0 ]
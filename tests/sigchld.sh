@@ -0,0 +1,9 @@
+# Stress test for child reaping: 20000 background jobs end while
+# foreground commands and builtins run, and each is reported exactly once.
+/proc/$$/exe -c 'd="0 1 2 3 4 5 6 7 8 9"; for a in 0 1; do for b in $d; do for c in $d; do for e in $d; do for f in $d; do /bin/true & done; /bin/true; x=$(echo $e); done; done; done; done; sleep 1; true' > out
+echo "started $(grep -c '^Background pid is' out)"
+echo "done $(grep -c 'is done: exit value 0$' out)"
+grep '^Background pid is' out | sed 's/.* //' | sort > started
+grep 'is done: exit value 0$' out | sed 's/Background pid \([0-9]*\) .*/\1/' | sort > finished
+cmp started finished && echo "same pids"
+echo "other lines $(grep -v '^Background pid [0-9]* is done: exit value 0$' out | grep -v '^Background pid is [0-9]*$' | grep -c .)"
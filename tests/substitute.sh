@@ -0,0 +1,23 @@
+# Command substitution with $(...) and backquotes.
+echo a $(echo b c) d
+echo "[$(printf '%s\n' x y)]"
+x=$(echo hello   world)
+echo "$x"
+y=`echo back tick`
+echo $y
+echo $(echo $(echo nested) deep) `echo \`echo inner\``
+echo "$(echo "quoted (paren)")"
+echo lines $(printf 'a\nb\nc\n' | wc -l)
+z=$(false)
+echo status $?
+echo $(true)empty
+for w in $(echo 1 2 3); do echo item $w; done
+f() { echo func $1; }
+echo $(f arg)
+echo $(mkdir made; cd made; pwd | sed 's|.*/||')
+pwd | sed 's|.*/||'
+big=$(seq 1 30000)
+echo "$big" > copy
+seq 1 30000 | cmp - copy && echo large output kept
+echo $( echo unterminated
+echo next
@@ -0,0 +1,4 @@
+# The -z pool holds the helper and WORKER_POOL (4) idle workers, all
+# children of the shell, and refills itself after a pipeline uses them.
+/proc/$$/exe -z -c 'sleep 0.3; ps --ppid $$ -o comm= > children; grep -vc "^ps$" children; sleep 0.1 | sleep 0.1 | sleep 0.1 | sleep 0.1; sleep 0.3; ps --ppid $$ -o comm= > children; grep -vc "^ps$" children'
+echo "shell $?"